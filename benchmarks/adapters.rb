@@ -0,0 +1,85 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Per-request allocations and time for each app adapter, from decoded
+# HTTP/3 headers to an encoded response: mode: :rack (protocol-http
+# Request/Headers, protocol-rack env and Response), :rack_direct
+# (Server::RackEnvAdapter) and :raw (Server::RawAdapter). No server or
+# network involved.
+#
+# Examples:
+#   ruby benchmarks/adapters.rb
+#   REQUESTS=50000 ruby benchmarks/adapters.rb
+
+$LOAD_PATH.unshift(File.expand_path("../lib", __dir__))
+
+require "socket"
+require "quicsilver"
+
+REQUESTS = Integer(ENV.fetch("REQUESTS", "20000"))
+
+HEADERS = {
+  ":method" => "GET",
+  ":scheme" => "https",
+  ":authority" => "example.com",
+  ":path" => "/users?page=2",
+  "accept" => "text/html,application/xhtml+xml",
+  "accept-encoding" => "gzip, deflate, br",
+  "accept-language" => "en-GB,en;q=0.9",
+  "user-agent" => "Mozilla/5.0 (Macintosh; Intel Mac OS X 14_0) AppleWebKit/537.36",
+  "cookie" => "session=abc123"
+}.freeze
+
+APP = ->(env) { [200, { "content-type" => "text/plain" }, ["Hello"]] }
+
+RAW_HEADERS = ["content-type", "text/plain"].freeze
+RAW_RESPONSE = [200, RAW_HEADERS, "Hello"].freeze
+RAW_APP = ->(_stream, _headers, _body) { RAW_RESPONSE }
+
+# One encoder for all adapters, as the server shares its own
+ENCODER = Quicsilver::Protocol::Qpack::Encoder.new
+
+ADAPTERS = {
+  "rack" => Quicsilver::Protocol::Adapter.new(Quicsilver::Server::RackAdapter.new(APP), encoder: ENCODER),
+  "rack_direct" => Quicsilver::Server::RackEnvAdapter.new(APP),
+  "raw" => Quicsilver::Server::RawAdapter.new(RAW_APP, encoder: ENCODER)
+}.freeze
+
+def serve(adapter)
+  request, = adapter.build_request(HEADERS, remote_address: "127.0.0.1", remote_port: 4433,
+    transport_context: { "connection" => { "stream_id" => 0 } }, early_data: false)
+  response = adapter.call(request)
+  return adapter.encode_response(response) if adapter.respond_to?(:encode_response)
+
+  status, headers, body, trailers = adapter.response_parts(response)
+  Quicsilver::Protocol::ResponseEncoder.new(status, headers, body || [], encoder: ENCODER, trailers: trailers).encode
+end
+
+def measure(adapter)
+  1_000.times { serve(adapter) } # warm caches
+
+  GC.start
+  GC.disable
+  allocated = GC.stat(:total_allocated_objects)
+  started = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  REQUESTS.times { serve(adapter) }
+  elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started
+  allocated = GC.stat(:total_allocated_objects) - allocated
+  GC.enable
+
+  [allocated.fdiv(REQUESTS), elapsed * 1_000_000 / REQUESTS]
+end
+
+puts "=" * 60
+puts "Request to encoded response, #{REQUESTS} requests"
+puts "=" * 60
+
+results = ADAPTERS.transform_values { |adapter| measure(adapter) }
+results.each do |mode, (allocations, micros)|
+  puts format("%-12s %8.1f objects/request %8.2f us/request", mode, allocations, micros)
+end
+
+base = results["rack"]
+results.except("rack").each do |mode, (allocations, micros)|
+  puts format("%-12s %.0f%% fewer allocations than rack, %.1fx faster", mode, (1 - allocations / base[0]) * 100, base[1] / micros)
+end
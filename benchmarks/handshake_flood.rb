@@ -0,0 +1,107 @@
+#!/usr/bin/env ruby
+# frozen_string_literal: true
+
+# Local handshake-flood generator. Workers open fresh connections (full
+# handshake, no resumption ticket) as fast as they can for DURATION seconds,
+# then print completed handshakes/s and the server's admission counters.
+#
+# Client and server share one process, so process-wide MsQuic counters
+# include both sides; the admission counters are listener-only.
+#
+# Examples:
+#   ruby benchmarks/handshake_flood.rb
+#   WORKERS=32 DURATION=10 ruby benchmarks/handshake_flood.rb
+#   RATE_LIMIT=200 ruby benchmarks/handshake_flood.rb        # attack mode at 200/s
+#   RETRY_PERCENT=0 ruby benchmarks/handshake_flood.rb       # always stateless Retry
+#   PER_IP=8 ruby benchmarks/handshake_flood.rb              # per-prefix limit
+
+$LOAD_PATH.unshift(File.expand_path("../lib", __dir__))
+
+require "localhost/authority"
+require "quicsilver"
+require_relative "helpers"
+
+WORKERS = Integer(ENV.fetch("WORKERS", "16"))
+DURATION = Float(ENV.fetch("DURATION", "5"))
+RATE_LIMIT = ENV["RATE_LIMIT"]&.then { |v| Integer(v) }
+RETRY_PERCENT = ENV["RETRY_PERCENT"]&.then { |v| Integer(v) }
+PER_IP = ENV["PER_IP"]&.then { |v| Integer(v) }
+MAX_CONNECTIONS = Integer(ENV.fetch("MAX_CONNECTIONS", "10000"))
+PORT = Integer(ENV.fetch("PORT", Benchmarks.random_port.to_s))
+
+REPORTED_COUNTERS = %w[
+  connections_limit_rejected connections_prefix_rejected
+  stateless_retries_sent retry_tokens_validated
+  handshakes_in_progress handshake_rate under_attack attack_episodes
+  connections_handshake_failed
+].freeze
+
+def start_server
+  authority = Localhost::Authority.fetch
+  config = Quicsilver::Transport::Configuration.new(
+    authority.certificate_path, authority.key_path,
+    handshake_rate_limit: RATE_LIMIT,
+    retry_memory_percent: RETRY_PERCENT,
+    max_connections_per_ip: PER_IP,
+  )
+  server = Quicsilver::Server.new(
+    PORT,
+    address: "127.0.0.1",
+    app: ->(_env) { [200, {}, [Benchmarks::TINY_RESPONSE]] },
+    server_configuration: config,
+    max_connections: MAX_CONNECTIONS,
+  )
+
+  thread = Thread.new { server.start }
+  thread.abort_on_exception = true
+  sleep 0.1 until server.running?
+  [server, thread]
+end
+
+def flood
+  deadline = Benchmarks.now + DURATION
+  times = Queue.new
+  failed = Queue.new
+
+  started = Benchmarks.now
+  workers = Array.new(WORKERS) do
+    Thread.new do
+      while Benchmarks.now < deadline
+        client = Quicsilver::Client.new("127.0.0.1", PORT, unsecure: true, connection_timeout: 2000)
+        began = Benchmarks.now
+        begin
+          client.open_connection
+          times << (Benchmarks.now - began)
+        rescue Quicsilver::ConnectionError, Quicsilver::TimeoutError
+          failed << 1
+        ensure
+          client.close_connection
+        end
+      end
+    end
+  end
+  workers.each(&:join)
+
+  [Array.new(times.size) { times.pop }, failed.size, Benchmarks.now - started]
+end
+
+begin
+  server, thread = start_server
+  times, failed, elapsed = flood
+  s = Benchmarks.stats(times)
+
+  puts "\nQuicsilver handshake flood"
+  puts "workers: #{WORKERS}, duration: #{DURATION}s, rate_limit: #{RATE_LIMIT.inspect}, " \
+    "retry_percent: #{RETRY_PERCENT.inspect}, per_ip: #{PER_IP.inspect}"
+  puts "-" * 76
+  puts format("%12s %8s %8s %8s %8s", "Handshakes/s", "p50", "p99", "max", "Failed")
+  puts "-" * 76
+  puts format("%12.0f %7.2fms %7.2fms %7.2fms %8d", times.size / elapsed, s[:p50], s[:p99], s[:max], failed)
+
+  counters = server.stats["transport"] || {}
+  puts "\nserver counters"
+  REPORTED_COUNTERS.each { |key| puts format("  %-30s %s", key, counters[key].inspect) }
+ensure
+  server&.stop rescue nil
+  thread&.join(5)
+end
@@ -111,4 +111,20 @@ unless find_library('msquic', nil, lib_dir)
         "Ensure lib/quicsilver/libmsquic.2.dylib exists or run 'rake build_msquic'."
 end
 
+# Response compression (Quicsilver::Compressor): gzip needs zlib; br and
+# zstd are compiled in when their libraries are installed.
+unless have_library('z', 'deflateInit2_', 'zlib.h')
+  raise "zlib not found. Install the zlib development package."
+end
+if have_library('brotlienc', 'BrotliEncoderCreateInstance', 'brotli/encode.h')
+  $defs << '-DHAVE_BROTLI'
+else
+  puts "libbrotlienc not found; br response compression disabled"
+end
+if have_library('zstd', 'ZSTD_compressStream2', 'zstd.h')
+  $defs << '-DHAVE_ZSTD'
+else
+  puts "libzstd not found; zstd response compression disabled"
+end
+
 create_makefile('quicsilver/quicsilver')
\ No newline at end of file
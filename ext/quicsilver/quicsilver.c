@@ -1,12 +1,21 @@
 #include <ruby.h>
 #include <ruby/thread.h>
+#include <ruby/fiber/scheduler.h>
 #define QUIC_API_ENABLE_PREVIEW_FEATURES 1
 #include "msquic.h"
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 #if __linux__
 #include <sys/epoll.h>
@@ -52,6 +61,13 @@ static HQUIC Registration = NULL;
 // Registration configuration
 static const QUIC_REGISTRATION_CONFIG RegConfig = { "quicsilver", QUIC_EXECUTION_PROFILE_LOW_LATENCY };
 
+// Token bucket for request/byte rate limits. Holds up to one second of
+// the rate, in thousandths so slow rates still refill between events.
+typedef struct {
+    uint64_t tokens;
+    uint64_t updated_ms;  // 0 = never used, starts full
+} TokenBucket;
+
 // Connection state tracking
 typedef struct {
     int connected;
@@ -65,6 +81,14 @@ typedef struct {
     // 0-RTT resumption ticket (client-side)
     uint8_t* resumption_ticket;
     uint32_t resumption_ticket_length;
+    // Admission accounting (server-side): released on SHUTDOWN_COMPLETE
+    int limit_counted;
+    uint32_t limit_bucket;
+    int handshaking;   // admitted, CONNECTED not yet seen
+    uint64_t send_inflight;  // bytes passed to StreamSend, SEND_COMPLETE not yet seen
+    // Rate limits (server-side): request streams opened, request bytes received
+    TokenBucket request_tokens;
+    TokenBucket byte_tokens;
 } ConnectionContext;
 
 // Listener state tracking
@@ -89,6 +113,9 @@ typedef struct {
     int shutdown;
     int early_data;        // Set when stream received 0-RTT data
     QUIC_STATUS error_status;
+    uint64_t send_inflight;   // bytes passed to StreamSend, SEND_COMPLETE not yet seen
+    uint32_t send_waiters;    // writers parked on this stream; the last one frees a shut-down ctx
+    int rate_limited;         // RATE_REFUSED or RATE_RESET, see RateLimits
 } StreamContext;
 
 // Pending stream priorities — set from Ruby threads, applied on MsQuic event thread.
@@ -97,6 +124,405 @@ typedef struct {
 static struct { HQUIC stream; uint16_t priority_plus_one; } PendingPriorities[MAX_PENDING_PRIORITIES];
 static int PendingPriorityCount = 0;
 
+// Send-side backpressure. StreamSend only queues: bytes count as in flight
+// until SEND_COMPLETE. A writer that finds its stream or connection over the
+// high-water mark waits — GVL released, or yielding to a fiber scheduler —
+// until completions bring both back under half of it. The counters are only
+// touched under the GVL; the mutex/cond just wake writers parked outside it.
+// The event-loop thread never waits: it is the one delivering SEND_COMPLETE.
+static struct {
+    uint64_t stream_high_water;      // 0 = unlimited
+    uint64_t connection_high_water;  // 0 = unlimited
+    uint32_t waiters;
+    uint64_t generation;             // bumped on every wake, so no signal is lost
+    uint64_t waits;                  // writers that had to wait
+    uint64_t inflight;               // process-wide, for Server#stats
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} SendLimits = {
+    .stream_high_water = 1048576,
+    .connection_high_water = 16777216,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+
+static pthread_t PollThread;
+static int PollThreadKnown = 0;
+// Nesting depth of Ruby dispatch from MsQuic callbacks (poll thread only).
+// Code running inside a callback must never park: nothing else would poll.
+static int CallbackDepth = 0;
+
+// Connection admission limits — enforced in ListenerCallback on
+// NEW_CONNECTION, before MsQuic does the TLS handshake for the connection.
+// Process-global rather than in ListenerContext because connections can
+// outlive the listener during shutdown and still need to release their slot.
+// Only touched from MsQuic callbacks and Ruby calls, all under the GVL.
+//
+// Per-prefix counts are kept in hashed buckets rather than an exact table:
+// fixed memory no matter how many source addresses a flood uses. Two
+// prefixes sharing a bucket share its limit, which errs towards refusing.
+//
+// Handshake-flood defense: handshake attempts are counted per one second
+// window. When a window exceeds handshake_rate_limit the server goes "under
+// attack" — every new client must complete a stateless Retry — until
+// ATTACK_COOLDOWN_WINDOWS consecutive windows stay under the limit. While
+// Retry is forced, a flood never reaches NEW_CONNECTION, so the Retries
+// MsQuic sends count as the attempts instead. Windows roll on the clock
+// (from the poll loop too), not only when a connection arrives.
+#define PREFIX_BUCKETS 4096
+#define RETRY_LOAD_PERCENT 75  // retry_under_load kicks in at 75% of max_connections
+#define ATTACK_COOLDOWN_WINDOWS 10
+static struct {
+    uint32_t max_connections;       // 0 = unlimited
+    uint32_t max_per_prefix;        // 0 = unlimited
+    uint8_t ipv4_prefix_length;
+    uint8_t ipv6_prefix_length;
+    int retry_under_load;
+    int retry_forced;               // RETRY_MEMORY_PERCENT currently forced to 0
+    uint16_t retry_memory_percent;  // MsQuic value to restore when load drops
+    uint32_t active;
+    uint32_t handshaking;           // admitted, not yet CONNECTED
+    uint64_t rejected_limit;
+    uint64_t rejected_prefix;
+    uint64_t retry_validated;       // admitted while Retry was forced
+    uint32_t handshake_rate_limit;  // attempts per second, 0 = no attack detection
+    uint32_t window_attempts;
+    uint32_t last_window_attempts;
+    uint64_t window_start_ms;
+    uint64_t window_retries_base;   // MsQuic Retries sent when the window began
+    int under_attack;
+    uint32_t calm_windows;
+    uint64_t attack_episodes;
+    uint32_t prefix_counts[PREFIX_BUCKETS];
+} ConnLimits = { .ipv4_prefix_length = 32, .ipv6_prefix_length = 64, .retry_memory_percent = 65 };
+
+static uint64_t
+monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Hash the source address, masked to the configured prefix, into a bucket.
+// IPv4-mapped IPv6 addresses (dual-stack listener) are treated as IPv4.
+static uint32_t
+prefix_bucket(const QUIC_ADDR* addr)
+{
+    uint8_t key[17] = {0};
+    const uint8_t* bytes;
+    int len, prefix;
+
+    if (QuicAddrGetFamily(addr) == QUIC_ADDRESS_FAMILY_INET) {
+        bytes = (const uint8_t*)&addr->Ipv4.sin_addr;
+        len = 4;
+    } else if (IN6_IS_ADDR_V4MAPPED(&addr->Ipv6.sin6_addr)) {
+        bytes = (const uint8_t*)&addr->Ipv6.sin6_addr.s6_addr[12];
+        len = 4;
+    } else {
+        bytes = (const uint8_t*)&addr->Ipv6.sin6_addr;
+        len = 16;
+    }
+    prefix = len == 4 ? ConnLimits.ipv4_prefix_length : ConnLimits.ipv6_prefix_length;
+    key[16] = (uint8_t)len;
+
+    for (int i = 0; i < len; i++) {
+        int bits = prefix - i * 8;
+        if (bits >= 8) {
+            key[i] = bytes[i];
+        } else if (bits > 0) {
+            key[i] = bytes[i] & (uint8_t)(0xFF << (8 - bits));
+        }
+    }
+
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < (int)sizeof(key); i++) {
+        hash ^= key[i];
+        hash *= 16777619u;
+    }
+    return hash % PREFIX_BUCKETS;
+}
+
+// Under load, force MsQuic to answer new Initials with a stateless Retry
+// (RETRY_MEMORY_PERCENT = 0): clients must prove their address before any
+// per-connection state exists. Restored once load drops back.
+static void
+update_retry_under_load(void)
+{
+    int loaded = ConnLimits.retry_under_load && ConnLimits.max_connections &&
+        (uint64_t)ConnLimits.active * 100 >= (uint64_t)ConnLimits.max_connections * RETRY_LOAD_PERCENT;
+    int force = loaded || ConnLimits.under_attack;
+    if (force == ConnLimits.retry_forced) return;
+
+    uint16_t percent = force ? 0 : ConnLimits.retry_memory_percent;
+    if (QUIC_SUCCEEDED(MsQuic->SetParam(NULL, QUIC_PARAM_GLOBAL_RETRY_MEMORY_PERCENT, sizeof(percent), &percent))) {
+        ConnLimits.retry_forced = force;
+    }
+}
+
+// Stateless Retries MsQuic has sent, process-wide. 0 without perf
+// counters: attempts are then only counted at NEW_CONNECTION.
+static uint64_t
+stateless_retries_sent(void)
+{
+#ifdef QUIC_PARAM_GLOBAL_PERF_COUNTERS
+    uint64_t counters[QUIC_PERF_COUNTER_MAX] = {0};
+    uint32_t counters_size = sizeof(counters);
+    if (QUIC_FAILED(MsQuic->GetParam(NULL, QUIC_PARAM_GLOBAL_PERF_COUNTERS, &counters_size, counters))) {
+        return 0;
+    }
+    return counters[QUIC_PERF_COUNTER_SEND_STATELESS_RETRY];
+#else
+    return 0;
+#endif
+}
+
+static void
+enter_attack_mode(void)
+{
+    ConnLimits.under_attack = 1;
+    ConnLimits.calm_windows = 0;
+    ConnLimits.attack_episodes++;
+    update_retry_under_load();
+}
+
+// Close the rate window once a second has passed. Enters attack mode on a
+// window over the limit; leaves it after a run of calm windows.
+static void
+roll_handshake_window(void)
+{
+    if (ConnLimits.handshake_rate_limit == 0) return;
+
+    uint64_t now = monotonic_ms();
+    if (now - ConnLimits.window_start_ms < 1000) return;
+
+    // Every Initial answered with a Retry was an attempt, including those
+    // from clients that never come back with the token.
+    uint64_t retries = stateless_retries_sent();
+    if (retries > ConnLimits.window_retries_base) {
+        uint64_t sent = retries - ConnLimits.window_retries_base;
+        ConnLimits.window_attempts += sent > UINT32_MAX ? UINT32_MAX : (uint32_t)sent;
+    }
+    ConnLimits.window_retries_base = retries;
+
+    // Windows with no attempts at all still count as calm
+    uint64_t elapsed_windows = (now - ConnLimits.window_start_ms) / 1000;
+    int over = ConnLimits.window_attempts > ConnLimits.handshake_rate_limit;
+
+    ConnLimits.last_window_attempts = ConnLimits.window_attempts;
+    ConnLimits.window_attempts = 0;
+    ConnLimits.window_start_ms = now;
+
+    if (ConnLimits.under_attack) {
+        ConnLimits.calm_windows = over ? 0 : ConnLimits.calm_windows + (uint32_t)elapsed_windows;
+        if (ConnLimits.calm_windows >= ATTACK_COOLDOWN_WINDOWS) {
+            ConnLimits.under_attack = 0;
+            update_retry_under_load();
+        }
+    } else if (over) {
+        enter_attack_mode();
+    }
+}
+
+// Count a handshake attempt at NEW_CONNECTION. With Retry forced the
+// client was already counted when its Retry went out.
+static void
+track_handshake_rate(void)
+{
+    if (ConnLimits.handshake_rate_limit == 0) return;
+
+    roll_handshake_window();
+    if (ConnLimits.retry_forced) return;
+
+    ConnLimits.window_attempts++;
+    if (!ConnLimits.under_attack && ConnLimits.window_attempts > ConnLimits.handshake_rate_limit) {
+        enter_attack_mode();
+    }
+}
+
+// Returns QUIC_STATUS_SUCCESS and takes a slot, or a failure status that
+// refuses the connection.
+static QUIC_STATUS
+admit_connection(const QUIC_NEW_CONNECTION_INFO* info, ConnectionContext* conn_ctx)
+{
+    uint32_t bucket = 0;
+
+    track_handshake_rate();
+
+    if (ConnLimits.max_connections && ConnLimits.active >= ConnLimits.max_connections) {
+        ConnLimits.rejected_limit++;
+        return QUIC_STATUS_CONNECTION_REFUSED;
+    }
+
+    // The bucket also keys the per-prefix rate limits, so it is needed
+    // even without a per-prefix connection cap.
+    if (info->RemoteAddress) {
+        bucket = prefix_bucket(info->RemoteAddress);
+    }
+
+    if (ConnLimits.max_per_prefix && info->RemoteAddress) {
+        if (ConnLimits.prefix_counts[bucket] >= ConnLimits.max_per_prefix) {
+            ConnLimits.rejected_prefix++;
+            return QUIC_STATUS_CONNECTION_REFUSED;
+        }
+        ConnLimits.prefix_counts[bucket]++;
+    }
+
+    // With Retry forced, MsQuic only creates a connection once the client
+    // has echoed a valid Retry token — so this one proved its address.
+    if (ConnLimits.retry_forced) ConnLimits.retry_validated++;
+
+    ConnLimits.active++;
+    ConnLimits.handshaking++;
+    conn_ctx->limit_counted = 1;
+    conn_ctx->limit_bucket = bucket;
+    conn_ctx->handshaking = 1;
+    update_retry_under_load();
+    return QUIC_STATUS_SUCCESS;
+}
+
+static void
+handshake_done(ConnectionContext* conn_ctx)
+{
+    if (!conn_ctx->handshaking) return;
+    conn_ctx->handshaking = 0;
+    if (ConnLimits.handshaking > 0) ConnLimits.handshaking--;
+}
+
+static void
+release_connection(ConnectionContext* conn_ctx)
+{
+    handshake_done(conn_ctx);
+    if (!conn_ctx->limit_counted) return;
+    conn_ctx->limit_counted = 0;
+
+    if (ConnLimits.active > 0) ConnLimits.active--;
+    if (ConnLimits.max_per_prefix && ConnLimits.prefix_counts[conn_ctx->limit_bucket] > 0) {
+        ConnLimits.prefix_counts[conn_ctx->limit_bucket]--;
+    }
+    update_retry_under_load();
+}
+
+// Request rate limits — token buckets per connection and per source prefix
+// (the ConnLimits buckets), checked in the MsQuic callbacks before anything
+// reaches Ruby. Server-side, client-initiated bidirectional (request)
+// streams only; control and QPACK streams are never limited.
+//
+// A request stream opened over the request rate is refused at
+// PEER_STREAM_STARTED: the server answers a fixed 429 (retry-after: 1) and
+// asks the client to stop sending. Ruby never hears of the stream. Request
+// data received over the byte rate resets the stream with
+// H3_EXCESSIVE_LOAD, and Ruby gets it as a STREAM_RESET.
+#define H3_NO_ERROR 0x100
+#define H3_EXCESSIVE_LOAD 0x107
+#define H3_REQUEST_REJECTED 0x10b
+#define RATE_REFUSED 1
+#define RATE_RESET 2
+static struct {
+    uint64_t request_rate;         // per second, 0 = unlimited
+    uint64_t prefix_request_rate;
+    uint64_t byte_rate;
+    uint64_t prefix_byte_rate;
+    uint64_t requests_limited;
+    uint64_t streams_byte_limited;
+    TokenBucket prefix_requests[PREFIX_BUCKETS];
+    TokenBucket prefix_bytes[PREFIX_BUCKETS];
+} RateLimits;
+
+// HEADERS frame: QPACK, static table only — :status 429 (name reference
+// to static entry 24), retry-after: 1 (literal name).
+static const uint8_t RateLimitedResponse[] = {
+    0x01, 0x17, 0x00, 0x00,
+    0x5F, 0x09, 0x03, '4', '2', '9',
+    0x27, 0x04, 'r', 'e', 't', 'r', 'y', '-', 'a', 'f', 't', 'e', 'r', 0x01, '1'
+};
+
+static void
+refill_tokens(TokenBucket* bucket, uint64_t rate, uint64_t now)
+{
+    uint64_t capacity = rate * 1000;
+
+    if (bucket->updated_ms == 0) {
+        bucket->tokens = capacity;
+    } else {
+        uint64_t elapsed = now - bucket->updated_ms;
+        bucket->tokens += (elapsed < 1000 ? elapsed : 1000) * rate;
+        if (bucket->tokens > capacity) bucket->tokens = capacity;
+    }
+    bucket->updated_ms = now;
+}
+
+// Take cost from the connection's bucket and its prefix's, or from neither
+// if either is short. A cost above a full bucket drains it rather than
+// failing forever.
+static int
+take_tokens(TokenBucket* conn_bucket, uint64_t conn_rate,
+            TokenBucket* prefix_tokens, uint64_t prefix_rate, uint64_t cost)
+{
+    uint64_t now = monotonic_ms();
+    uint64_t conn_cost = 0, prefix_cost = 0;
+
+    if (conn_rate) {
+        refill_tokens(conn_bucket, conn_rate, now);
+        conn_cost = cost < conn_rate ? cost * 1000 : conn_rate * 1000;
+        if (conn_bucket->tokens < conn_cost) return 0;
+    }
+    if (prefix_rate) {
+        refill_tokens(prefix_tokens, prefix_rate, now);
+        prefix_cost = cost < prefix_rate ? cost * 1000 : prefix_rate * 1000;
+        if (prefix_tokens->tokens < prefix_cost) return 0;
+    }
+
+    if (conn_rate) conn_bucket->tokens -= conn_cost;
+    if (prefix_rate) prefix_tokens->tokens -= prefix_cost;
+    return 1;
+}
+
+static int
+request_rate_limited(ConnectionContext* conn_ctx)
+{
+    if (!RateLimits.request_rate && !RateLimits.prefix_request_rate) return 0;
+
+    int allowed = take_tokens(&conn_ctx->request_tokens, RateLimits.request_rate,
+        &RateLimits.prefix_requests[conn_ctx->limit_bucket], RateLimits.prefix_request_rate, 1);
+    if (!allowed) RateLimits.requests_limited++;
+    return !allowed;
+}
+
+static int
+byte_rate_limited(ConnectionContext* conn_ctx, uint64_t length)
+{
+    if (!RateLimits.byte_rate && !RateLimits.prefix_byte_rate) return 0;
+
+    int allowed = take_tokens(&conn_ctx->byte_tokens, RateLimits.byte_rate,
+        &RateLimits.prefix_bytes[conn_ctx->limit_bucket], RateLimits.prefix_byte_rate, length);
+    if (!allowed) RateLimits.streams_byte_limited++;
+    return !allowed;
+}
+
+// Answer a refused request stream with the 429 and stop reading it
+// (H3_NO_ERROR: the response is complete, RFC 9114 §4.1). Falls back to a
+// reset if the response can't be queued.
+static void
+refuse_rate_limited_stream(HQUIC Stream)
+{
+    void* SendBufferRaw = malloc(sizeof(QUIC_BUFFER) + sizeof(RateLimitedResponse));
+    if (SendBufferRaw != NULL) {
+        QUIC_BUFFER* SendBuffer = (QUIC_BUFFER*)SendBufferRaw;
+        SendBuffer->Buffer = (uint8_t*)SendBufferRaw + sizeof(QUIC_BUFFER);
+        SendBuffer->Length = sizeof(RateLimitedResponse);
+        memcpy(SendBuffer->Buffer, RateLimitedResponse, sizeof(RateLimitedResponse));
+
+        if (QUIC_SUCCEEDED(MsQuic->StreamSend(Stream, SendBuffer, 1, QUIC_SEND_FLAG_FIN, SendBufferRaw))) {
+            MsQuic->StreamShutdown(Stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT_RECEIVE, H3_NO_ERROR);
+            return;
+        }
+        free(SendBufferRaw);
+    }
+    MsQuic->StreamShutdown(Stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, H3_REQUEST_REJECTED);
+}
+
 // rb_protect wrapper — catches Ruby exceptions so they don't longjmp
 // through MsQuic callback frames (which would corrupt MsQuic state).
 // All Ruby object construction AND the funcall happen inside rb_protect.
@@ -169,7 +595,9 @@ dispatch_to_ruby(HQUIC connection, void* connection_ctx, VALUE client_obj,
     args.early_data = early_data;
 
     int state = 0;
+    CallbackDepth++;
     rb_protect(dispatch_ruby_body, (VALUE)&args, &state);
+    CallbackDepth--;
     if (state) {
         VALUE err = rb_errinfo();
         if (!NIL_P(err)) {
@@ -226,6 +654,27 @@ cqe_get_sqe(QUIC_CQE* cqe)
 #endif
 }
 
+// Run MsQuic completions for ready events, skipping (and draining) wakes.
+static void
+fire_completions(QUIC_CQE* events, int count)
+{
+    for (int i = 0; i < count; i++) {
+#if __linux__
+        if (events[i].data.ptr == NULL) {
+            uint64_t val;
+            read(WakeFd, &val, sizeof(val));  // drain eventfd
+            continue;
+        }
+#elif __APPLE__ || __FreeBSD__
+        if (events[i].filter == EVFILT_USER && events[i].ident == WAKE_IDENT) continue;
+#endif
+        QUIC_SQE* sqe = cqe_get_sqe(&events[i]);
+        if (sqe && sqe->Completion) {
+            sqe->Completion(&events[i]);
+        }
+    }
+}
+
 // Drive MsQuic execution: poll internal timers, wait for I/O, fire completions.
 // Callbacks (StreamCallback, ConnectionCallback) fire HERE on the Ruby thread.
 static VALUE
@@ -233,6 +682,10 @@ quicsilver_poll(VALUE self)
 {
     if (ExecContext == NULL) return INT2NUM(0);
 
+    PollThread = pthread_self();
+    PollThreadKnown = 1;
+    roll_handshake_window();
+
     // 1. ExecutionPoll — process MsQuic timers/state, may fire callbacks (has GVL)
     uint32_t wait_ms = MsQuic->ExecutionPoll(ExecContext);
 
@@ -249,23 +702,49 @@ quicsilver_poll(VALUE self)
     rb_thread_call_without_gvl(eventq_wait_nogvl, &args, RUBY_UBF_IO, NULL);
 
     // 3. Fire completions — MsQuic callbacks run here (has GVL)
-    for (int i = 0; i < args.count; i++) {
+    fire_completions(args.events, args.count);
+
+    return INT2NUM(args.count);
+}
+
+// One non-blocking turn of the loop, for a Ruby Fiber scheduler driving it:
+// the caller waits for event_queue_fd to become readable (through the
+// scheduler, so request fibers run meanwhile) instead of us blocking in
+// epoll_wait/kevent. Returns how long MsQuic may sleep in ms, 0 to come
+// straight back, or nil when it has no timer pending.
+static VALUE
+quicsilver_poll_nowait(VALUE self)
+{
+    if (ExecContext == NULL) return Qnil;
+
+    PollThread = pthread_self();
+    PollThreadKnown = 1;
+    roll_handshake_window();
+
+    uint32_t wait_ms = MsQuic->ExecutionPoll(ExecContext);
+
+    QUIC_CQE events[64];
 #if __linux__
-        if (args.events[i].data.ptr == NULL) {
-            uint64_t val;
-            read(WakeFd, &val, sizeof(val));  // drain eventfd
-            continue;
-        }
+    int count = epoll_wait(EventQ, events, 64, 0);
 #elif __APPLE__ || __FreeBSD__
-        if (args.events[i].filter == EVFILT_USER && args.events[i].ident == WAKE_IDENT) continue;
+    struct timespec ts = { 0, 0 };
+    int count = kevent(EventQ, NULL, 0, events, 64, &ts);
 #endif
-        QUIC_SQE* sqe = cqe_get_sqe(&args.events[i]);
-        if (sqe && sqe->Completion) {
-            sqe->Completion(&args.events[i]);
-        }
-    }
+    if (count < 0) count = 0;
+    fire_completions(events, count);
 
-    return INT2NUM(args.count);
+    // Completions may have armed timers or left more events queued
+    if (count > 0) return INT2NUM(0);
+    return wait_ms == UINT32_MAX ? Qnil : UINT2NUM(wait_ms);
+}
+
+// epoll/kqueue descriptor MsQuic's completions (and wake) arrive on. It
+// polls readable while events are pending.
+static VALUE
+quicsilver_event_queue_fd(VALUE self)
+{
+    if (ExecContext == NULL) return Qnil;
+    return INT2NUM((int)EventQ);
 }
 
 // Inline poll for use during synchronous waits (e.g. wait_for_connection).
@@ -286,23 +765,46 @@ poll_inline(int timeout_ms)
     ts.tv_nsec = (timeout_ms % 1000) * 1000000;
     int count = kevent(EventQ, NULL, 0, events, 8, &ts);
 #endif
-    for (int i = 0; i < count; i++) {
-#if __linux__
-        if (events[i].data.ptr == NULL) {
-            uint64_t val;
-            read(WakeFd, &val, sizeof(val));  // drain eventfd
-            continue;
-        }
-#elif __APPLE__ || __FreeBSD__
-        if (events[i].filter == EVFILT_USER && events[i].ident == WAKE_IDENT) continue;
-#endif
-        QUIC_SQE* sqe = cqe_get_sqe(&events[i]);
-        if (sqe && sqe->Completion) {
-            sqe->Completion(&events[i]);
+    if (count > 0) fire_completions(events, count);
+}
+
+// Writers parked under a fiber scheduler, as [scheduler, fiber] pairs
+// (each pair is also the blocker). Only touched under the GVL.
+static VALUE SendWaitFibers = Qnil;
+
+static void
+wake_send_waiters(void)
+{
+    if (SendLimits.waiters == 0) return;
+
+    pthread_mutex_lock(&SendLimits.mutex);
+    SendLimits.generation++;
+    pthread_cond_broadcast(&SendLimits.cond);
+    pthread_mutex_unlock(&SendLimits.mutex);
+
+    if (!NIL_P(SendWaitFibers) && RARRAY_LEN(SendWaitFibers) > 0) {
+        VALUE fibers = SendWaitFibers;
+        SendWaitFibers = rb_ary_new();
+        for (long i = 0; i < RARRAY_LEN(fibers); i++) {
+            VALUE waiter = RARRAY_AREF(fibers, i);
+            rb_fiber_scheduler_unblock(RARRAY_AREF(waiter, 0), waiter, RARRAY_AREF(waiter, 1));
         }
     }
 }
 
+static void
+release_send_bytes(StreamContext* ctx, uint32_t length)
+{
+    ConnectionContext* conn_ctx = (ConnectionContext*)ctx->connection_ctx;
+
+    ctx->send_inflight -= length < ctx->send_inflight ? length : ctx->send_inflight;
+    SendLimits.inflight -= length < SendLimits.inflight ? length : SendLimits.inflight;
+    if (conn_ctx != NULL) {
+        conn_ctx->send_inflight -= length < conn_ctx->send_inflight ? length : conn_ctx->send_inflight;
+    }
+    wake_send_waiters();
+}
+
 QUIC_STATUS
 StreamCallback(HQUIC Stream, void* Context, QUIC_STREAM_EVENT* Event)
 {
@@ -331,10 +833,29 @@ StreamCallback(HQUIC Stream, void* Context, QUIC_STREAM_EVENT* Event)
         }
     }
 
+    // Refused by the rate limit: Ruby never saw this stream, so only free
+    // the 429's buffer and the context.
+    if (ctx->rate_limited == RATE_REFUSED) {
+        if (Event->Type == QUIC_STREAM_EVENT_SEND_COMPLETE && Event->SEND_COMPLETE.ClientContext != NULL) {
+            free(Event->SEND_COMPLETE.ClientContext);
+        } else if (Event->Type == QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE) {
+            MsQuic->SetCallbackHandler(Stream, (void*)StreamCallback, NULL);
+            free(ctx);
+            if (Event->SHUTDOWN_COMPLETE.AppCloseInProgress == FALSE) {
+                MsQuic->StreamClose(Stream);
+            }
+        }
+        return QUIC_STATUS_SUCCESS;
+    }
+
     switch (Event->Type) {
         case QUIC_STREAM_EVENT_RECEIVE: {
             int has_fin = (Event->RECEIVE.Flags & QUIC_RECEIVE_FLAG_FIN) != 0;
 
+            if (ctx->rate_limited) {
+                break;
+            }
+
             // Track 0-RTT early data for replay protection
             if (Event->RECEIVE.Flags & QUIC_RECEIVE_FLAG_0_RTT) {
                 ctx->early_data = 1;
@@ -355,6 +876,20 @@ StreamCallback(HQUIC Stream, void* Context, QUIC_STREAM_EVENT* Event)
                     total_data_len += Event->RECEIVE.Buffers[b].Length;
                 }
 
+                // Request data over the byte rate: reset the stream and
+                // tell Ruby as if the peer had reset it
+                if (NIL_P(ctx->client_obj) && ctx->connection_ctx != NULL && (ctx->stream_id & 0x3) == 0 &&
+                    byte_rate_limited((ConnectionContext*)ctx->connection_ctx, total_data_len)) {
+                    uint64_t error_code = H3_EXCESSIVE_LOAD;
+                    char reset[sizeof(HQUIC) + sizeof(uint64_t)];
+                    ctx->rate_limited = RATE_RESET;
+                    MsQuic->StreamShutdown(Stream, QUIC_STREAM_SHUTDOWN_FLAG_ABORT, H3_EXCESSIVE_LOAD);
+                    memcpy(reset, &Stream, sizeof(HQUIC));
+                    memcpy(reset + sizeof(HQUIC), &error_code, sizeof(uint64_t));
+                    dispatch_to_ruby(ctx->connection, ctx->connection_ctx, ctx->client_obj, "STREAM_RESET", ctx->stream_id, reset, sizeof(reset), 0);
+                    break;
+                }
+
                 // Always prepend [stream_handle(8)] so Ruby has the handle
                 // for all events — needed for WebTransport streams, GOAWAY,
                 // and any code that needs to send back on the stream.
@@ -375,18 +910,25 @@ StreamCallback(HQUIC Stream, void* Context, QUIC_STREAM_EVENT* Event)
         }
         case QUIC_STREAM_EVENT_SEND_COMPLETE:
             // Free the send buffer that was allocated in quicsilver_send_stream
+            // (acked or canceled) and let parked writers re-check their window
             if (Event->SEND_COMPLETE.ClientContext != NULL) {
+                release_send_bytes(ctx, ((QUIC_BUFFER*)Event->SEND_COMPLETE.ClientContext)->Length);
                 free(Event->SEND_COMPLETE.ClientContext);
             }
             dispatch_to_ruby(ctx->connection, ctx->connection_ctx, ctx->client_obj,
                 "SEND_COMPLETE", ctx->stream_id, (const char*)&Stream, sizeof(HQUIC), 0);
             break;
         case QUIC_STREAM_EVENT_SHUTDOWN_COMPLETE:
+            // Writers parked on this stream give up (and raise) once they
+            // see shutdown; the last of them frees ctx.
+            ctx->shutdown = 1;
+            wake_send_waiters();
             dispatch_to_ruby(ctx->connection, ctx->connection_ctx, ctx->client_obj,
                 "STREAM_SHUTDOWN_COMPLETE", ctx->stream_id, (const char*)&Stream, sizeof(HQUIC), 0);
-            ctx->shutdown = 1;
             MsQuic->SetCallbackHandler(Stream, (void*)StreamCallback, NULL);
-            free(ctx);
+            if (ctx->send_waiters == 0) {
+                free(ctx);
+            }
             if (Event->SHUTDOWN_COMPLETE.AppCloseInProgress == FALSE) {
                 MsQuic->StreamClose(Stream);
             }
@@ -448,9 +990,16 @@ ConnectionCallback(HQUIC Connection, void* Context, QUIC_CONNECTION_EVENT* Event
             ctx->connected = 1;
             ctx->failed = 0;
             ctx->session_resumed = Event->CONNECTED.SessionResumed;
+            handshake_done(ctx);
             // Server: send resumption ticket so client can do 0-RTT on reconnect
             if (NIL_P(ctx->client_obj)) {
                 MsQuic->ConnectionSendResumptionTicket(Connection, QUIC_SEND_RESUMPTION_FLAG_NONE, 0, NULL);
+                // Streams of equal priority take turns (a batch of packets
+                // each) rather than going first come, first served. Ruby
+                // gives sequential responses distinct priorities and
+                // incremental ones a shared one (Transport::SendScheduler).
+                QUIC_STREAM_SCHEDULING_SCHEME Scheme = QUIC_STREAM_SCHEDULING_SCHEME_ROUND_ROBIN;
+                MsQuic->SetParam(Connection, QUIC_PARAM_CONN_STREAM_SCHEDULING_SCHEME, sizeof(Scheme), &Scheme);
             }
             // Notify Ruby about new connection - pass ctx pointer for building connection_data
             dispatch_to_ruby(Connection, ctx, ctx->client_obj, "CONNECTION_ESTABLISHED", 0, (const char*)&Connection, sizeof(HQUIC), 0);
@@ -464,6 +1013,12 @@ ConnectionCallback(HQUIC Connection, void* Context, QUIC_CONNECTION_EVENT* Event
             ctx->resumption_ticket = (uint8_t*)malloc(ctx->resumption_ticket_length);
             if (ctx->resumption_ticket) {
                 memcpy(ctx->resumption_ticket, Event->RESUMPTION_TICKET_RECEIVED.ResumptionTicket, ctx->resumption_ticket_length);
+                // Hand the ticket to the client so it can persist it in its
+                // ticket store now, not only on an orderly disconnect.
+                if (!NIL_P(ctx->client_obj)) {
+                    dispatch_to_ruby(Connection, ctx, ctx->client_obj, "RESUMPTION_TICKET_RECEIVED", 0,
+                        (const char*)ctx->resumption_ticket, ctx->resumption_ticket_length, 0);
+                }
             }
             break;
         case QUIC_CONNECTION_EVENT_SHUTDOWN_INITIATED_BY_TRANSPORT:
@@ -490,6 +1045,7 @@ ConnectionCallback(HQUIC Connection, void* Context, QUIC_CONNECTION_EVENT* Event
                 free(ctx->resumption_ticket);
                 ctx->resumption_ticket = NULL;
             }
+            release_connection(ctx);
             free(ctx);
             break;
          case QUIC_CONNECTION_EVENT_PEER_STREAM_STARTED:
@@ -505,9 +1061,20 @@ ConnectionCallback(HQUIC Connection, void* Context, QUIC_CONNECTION_EVENT* Event
                 stream_ctx->stream_id = UINT64_MAX;  // Lazily resolved on first callback
                 stream_ctx->early_data = 0;
                 stream_ctx->error_status = QUIC_STATUS_SUCCESS;
+                stream_ctx->send_inflight = 0;
+                stream_ctx->send_waiters = 0;
+                stream_ctx->rate_limited = 0;
 
                 // Set the stream callback handler to handle data events
                 MsQuic->SetCallbackHandler(Stream, (void*)StreamCallback, stream_ctx);
+
+                // Server request stream over the request rate: answered here
+                if (NIL_P(ctx->client_obj) &&
+                    !(Event->PEER_STREAM_STARTED.Flags & QUIC_STREAM_OPEN_FLAG_UNIDIRECTIONAL) &&
+                    request_rate_limited(ctx)) {
+                    stream_ctx->rate_limited = RATE_REFUSED;
+                    refuse_rate_limited_stream(Stream);
+                }
             } else {
                 MsQuic->StreamClose(Stream);
             }
@@ -560,13 +1127,28 @@ ListenerCallback(HQUIC Listener, void* Context, QUIC_LISTENER_EVENT* Event)
                 conn_ctx->session_resumed = 0;
                 conn_ctx->resumption_ticket = NULL;
                 conn_ctx->resumption_ticket_length = 0;
+                conn_ctx->limit_counted = 0;
+                conn_ctx->limit_bucket = 0;
+                conn_ctx->handshaking = 0;
+                conn_ctx->send_inflight = 0;
+                conn_ctx->request_tokens = (TokenBucket){0};
+                conn_ctx->byte_tokens = (TokenBucket){0};
+
+                // Refuse over-limit connections before ConnectionSetConfiguration —
+                // no certificate, no key exchange, no Ruby dispatch.
+                QUIC_STATUS Status = admit_connection(Event->NEW_CONNECTION.Info, conn_ctx);
+                if (QUIC_FAILED(Status)) {
+                    free(conn_ctx);
+                    return Status;
+                }
 
                 // Set the connection callback
                 MsQuic->SetCallbackHandler(Event->NEW_CONNECTION.Connection, (void*)ConnectionCallback, conn_ctx);
 
                 // Accept the new connection with the server configuration
-                QUIC_STATUS Status = MsQuic->ConnectionSetConfiguration(Event->NEW_CONNECTION.Connection, ctx->Configuration);
+                Status = MsQuic->ConnectionSetConfiguration(Event->NEW_CONNECTION.Connection, ctx->Configuration);
                 if (QUIC_FAILED(Status)) {
+                    release_connection(conn_ctx);
                     free(conn_ctx);
                     return Status;
                 }
@@ -870,6 +1452,12 @@ quicsilver_create_connection(VALUE self, VALUE client_obj)
     ctx->session_resumed = 0;
     ctx->resumption_ticket = NULL;
     ctx->resumption_ticket_length = 0;
+    ctx->limit_counted = 0;
+    ctx->limit_bucket = 0;
+    ctx->handshaking = 0;
+    ctx->send_inflight = 0;
+    ctx->request_tokens = (TokenBucket){0};
+    ctx->byte_tokens = (TokenBucket){0};
 
     // Protect from GC if it's a Ruby object
     if (!NIL_P(client_obj)) {
@@ -1044,6 +1632,10 @@ quicsilver_connection_statistics(VALUE self, VALUE connection_handle_val)
     // Misc
     rb_hash_aset(result, rb_str_new_cstr("key_update_count"), UINT2NUM(stats.KeyUpdateCount));
 
+    // Memory: response bytes MsQuic holds until SEND_COMPLETE
+    ConnectionContext* ctx = (ConnectionContext*)MsQuic->GetContext(Connection);
+    rb_hash_aset(result, rb_str_new_cstr("send_buffered_bytes"), ULL2NUM(ctx ? ctx->send_inflight : 0));
+
     return result;
 }
 
@@ -1127,6 +1719,25 @@ quicsilver_transport_counters(VALUE self)
 
 #undef ADD_COUNTER
 
+    // Quicsilver admission control (ListenerCallback), not MsQuic counters.
+    roll_handshake_window();
+    rb_hash_aset(result, rb_str_new_cstr("connections_admitted"), UINT2NUM(ConnLimits.active));
+    rb_hash_aset(result, rb_str_new_cstr("connections_limit_rejected"), ULL2NUM(ConnLimits.rejected_limit));
+    rb_hash_aset(result, rb_str_new_cstr("connections_prefix_rejected"), ULL2NUM(ConnLimits.rejected_prefix));
+    rb_hash_aset(result, rb_str_new_cstr("retry_under_load"), ConnLimits.retry_forced ? Qtrue : Qfalse);
+    rb_hash_aset(result, rb_str_new_cstr("retry_tokens_validated"), ULL2NUM(ConnLimits.retry_validated));
+    rb_hash_aset(result, rb_str_new_cstr("handshakes_in_progress"), UINT2NUM(ConnLimits.handshaking));
+    rb_hash_aset(result, rb_str_new_cstr("handshake_rate"), UINT2NUM(ConnLimits.last_window_attempts));
+    rb_hash_aset(result, rb_str_new_cstr("under_attack"), ConnLimits.under_attack ? Qtrue : Qfalse);
+    rb_hash_aset(result, rb_str_new_cstr("attack_episodes"), ULL2NUM(ConnLimits.attack_episodes));
+    rb_hash_aset(result, rb_str_new_cstr("requests_rate_limited"), ULL2NUM(RateLimits.requests_limited));
+    rb_hash_aset(result, rb_str_new_cstr("streams_byte_rate_limited"), ULL2NUM(RateLimits.streams_byte_limited));
+
+    // Send backpressure (quicsilver_send_stream)
+    rb_hash_aset(result, rb_str_new_cstr("send_waits"), ULL2NUM(SendLimits.waits));
+    rb_hash_aset(result, rb_str_new_cstr("send_buffered"), ULL2NUM(SendLimits.inflight));
+    rb_hash_aset(result, rb_str_new_cstr("send_waiters"), UINT2NUM(SendLimits.waiters));
+
     return result;
 #else
     return Qnil;
@@ -1403,6 +2014,91 @@ cibir_param_buffer(VALUE cibir_bytes_val, uint8_t* buffer)
     return (uint32_t)(1 + cibir_len);
 }
 
+// Set the admission limits ListenerCallback enforces on NEW_CONNECTION.
+// Keys: max_connections, max_connections_per_prefix (0 = unlimited),
+// ipv4_prefix_length, ipv6_prefix_length, retry_under_load (0/1),
+// handshake_rate_limit (0 = off), retry_memory_percent (nil = MsQuic default),
+// and the RateLimits per second (0 = off): request_rate_limit,
+// prefix_request_rate_limit, byte_rate_limit, prefix_byte_rate_limit.
+static VALUE
+quicsilver_configure_connection_limits(VALUE self, VALUE limits_hash)
+{
+    if (MsQuic == NULL) {
+        rb_raise(rb_eRuntimeError, "MSQUIC not initialized. Call Quicsilver.open_connection first.");
+        return Qnil;
+    }
+
+    VALUE max_connections_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("max_connections")));
+    VALUE max_per_prefix_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("max_connections_per_prefix")));
+    VALUE ipv4_prefix_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("ipv4_prefix_length")));
+    VALUE ipv6_prefix_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("ipv6_prefix_length")));
+    VALUE retry_under_load_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("retry_under_load")));
+    VALUE handshake_rate_limit_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("handshake_rate_limit")));
+    VALUE retry_memory_percent_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("retry_memory_percent")));
+    VALUE request_rate_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("request_rate_limit")));
+    VALUE prefix_request_rate_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("prefix_request_rate_limit")));
+    VALUE byte_rate_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("byte_rate_limit")));
+    VALUE prefix_byte_rate_val = rb_hash_aref(limits_hash, ID2SYM(rb_intern("prefix_byte_rate_limit")));
+
+    uint32_t ipv4_prefix = NUM2UINT(ipv4_prefix_val);
+    uint32_t ipv6_prefix = NUM2UINT(ipv6_prefix_val);
+    if (ipv4_prefix > 32 || ipv6_prefix > 128) {
+        rb_raise(rb_eArgError, "prefix length out of range");
+        return Qnil;
+    }
+
+    // Baseline retry threshold: share of MsQuic's handshake memory that may
+    // be in use before it starts answering Initials with a stateless Retry.
+    // Forced-retry modes drop it to 0 and restore this value afterwards.
+    if (!NIL_P(retry_memory_percent_val)) {
+        uint32_t requested = NUM2UINT(retry_memory_percent_val);
+        if (requested > 100) {
+            rb_raise(rb_eArgError, "retry_memory_percent out of range");
+            return Qnil;
+        }
+        uint16_t percent = (uint16_t)requested;
+        QUIC_STATUS Status;
+        if (!ConnLimits.retry_forced &&
+            QUIC_FAILED(Status = MsQuic->SetParam(NULL, QUIC_PARAM_GLOBAL_RETRY_MEMORY_PERCENT, sizeof(percent), &percent))) {
+            rb_raise(rb_eRuntimeError, "SetParam(RETRY_MEMORY_PERCENT) failed, 0x%x!", Status);
+            return Qnil;
+        }
+        ConnLimits.retry_memory_percent = percent;
+    } else if (!ConnLimits.retry_forced) {
+        uint16_t percent = 0;
+        uint32_t percent_size = sizeof(percent);
+        if (QUIC_SUCCEEDED(MsQuic->GetParam(NULL, QUIC_PARAM_GLOBAL_RETRY_MEMORY_PERCENT, &percent_size, &percent))) {
+            ConnLimits.retry_memory_percent = percent;
+        }
+    }
+
+    ConnLimits.max_connections = NUM2UINT(max_connections_val);
+    ConnLimits.max_per_prefix = NUM2UINT(max_per_prefix_val);
+    ConnLimits.ipv4_prefix_length = (uint8_t)ipv4_prefix;
+    ConnLimits.ipv6_prefix_length = (uint8_t)ipv6_prefix;
+    ConnLimits.retry_under_load = NUM2INT(retry_under_load_val);
+    ConnLimits.handshake_rate_limit = NUM2UINT(handshake_rate_limit_val);
+    if (ConnLimits.handshake_rate_limit == 0) {
+        ConnLimits.under_attack = 0;
+    } else {
+        // Retries sent before detection was on are not this window's attempts
+        ConnLimits.window_retries_base = stateless_retries_sent();
+    }
+    RateLimits.request_rate = NIL_P(request_rate_val) ? 0 : NUM2ULL(request_rate_val);
+    RateLimits.prefix_request_rate = NIL_P(prefix_request_rate_val) ? 0 : NUM2ULL(prefix_request_rate_val);
+    RateLimits.byte_rate = NIL_P(byte_rate_val) ? 0 : NUM2ULL(byte_rate_val);
+    RateLimits.prefix_byte_rate = NIL_P(prefix_byte_rate_val) ? 0 : NUM2ULL(prefix_byte_rate_val);
+    // Buckets depend on prefix lengths — only safe to reset with nothing admitted.
+    if (ConnLimits.active == 0) {
+        memset(ConnLimits.prefix_counts, 0, sizeof(ConnLimits.prefix_counts));
+        memset(RateLimits.prefix_requests, 0, sizeof(RateLimits.prefix_requests));
+        memset(RateLimits.prefix_bytes, 0, sizeof(RateLimits.prefix_bytes));
+    }
+    update_retry_under_load();
+
+    return Qtrue;
+}
+
 // Configure the fixed Server ID bytes MsQuic places in generated QUIC
 // connection IDs. Must run before RegistrationOpen, because MsQuic only applies
 // this process-global setting safely before the library is in use.
@@ -1626,6 +2322,9 @@ quicsilver_open_stream(VALUE self, VALUE connection_data, VALUE unidirectional)
     ctx->shutdown = 0;
     ctx->early_data = 0;
     ctx->error_status = QUIC_STATUS_SUCCESS;
+    ctx->send_inflight = 0;
+    ctx->send_waiters = 0;
+    ctx->rate_limited = 0;
 
     // Use flag based on parameter
     QUIC_STREAM_OPEN_FLAGS flags = RTEST(unidirectional)
@@ -1655,10 +2354,145 @@ quicsilver_open_stream(VALUE self, VALUE connection_data, VALUE unidirectional)
     return ULL2NUM((uintptr_t)Stream);
 }
 
+static int
+send_over_high_water(StreamContext* ctx)
+{
+    ConnectionContext* conn_ctx = (ConnectionContext*)ctx->connection_ctx;
+
+    if (SendLimits.stream_high_water && ctx->send_inflight >= SendLimits.stream_high_water) return 1;
+    return conn_ctx != NULL && SendLimits.connection_high_water &&
+        conn_ctx->send_inflight >= SendLimits.connection_high_water;
+}
+
+static int
+send_under_low_water(StreamContext* ctx)
+{
+    ConnectionContext* conn_ctx = (ConnectionContext*)ctx->connection_ctx;
+
+    if (SendLimits.stream_high_water && ctx->send_inflight > SendLimits.stream_high_water / 2) return 0;
+    return conn_ctx == NULL || !SendLimits.connection_high_water ||
+        conn_ctx->send_inflight <= SendLimits.connection_high_water / 2;
+}
+
+struct send_wait_args {
+    StreamContext* ctx;
+    uint64_t generation;
+    int interrupted;
+    VALUE fiber_waiter;  // [scheduler, fiber] while blocked in a fiber
+};
+
+// Park until the next wake (or 100ms, as a safety net). Runs without the GVL.
+static void*
+send_wait_nogvl(void* arg)
+{
+    struct send_wait_args* args = (struct send_wait_args*)arg;
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += 100 * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&SendLimits.mutex);
+    while (SendLimits.generation == args->generation && !args->interrupted) {
+        if (pthread_cond_timedwait(&SendLimits.cond, &SendLimits.mutex, &deadline) == ETIMEDOUT) break;
+    }
+    pthread_mutex_unlock(&SendLimits.mutex);
+    return NULL;
+}
+
+// Thread#raise / #kill / shutdown on a parked writer
+static void
+send_wait_ubf(void* arg)
+{
+    struct send_wait_args* args = (struct send_wait_args*)arg;
+    pthread_mutex_lock(&SendLimits.mutex);
+    args->interrupted = 1;
+    pthread_cond_broadcast(&SendLimits.cond);
+    pthread_mutex_unlock(&SendLimits.mutex);
+}
+
+static VALUE
+send_wait_loop(VALUE arg)
+{
+    struct send_wait_args* args = (struct send_wait_args*)arg;
+    StreamContext* ctx = args->ctx;
+    VALUE scheduler = rb_fiber_scheduler_current();
+
+    while (!ctx->shutdown && !send_under_low_water(ctx)) {
+        if (!NIL_P(scheduler)) {
+            // Non-blocking fiber: block in the scheduler until
+            // wake_send_waiters unblocks it (or 100ms, as a safety net)
+            args->fiber_waiter = rb_ary_new_from_args(2, scheduler, rb_fiber_current());
+            rb_ary_push(SendWaitFibers, args->fiber_waiter);
+            rb_fiber_scheduler_block(scheduler, args->fiber_waiter, DBL2NUM(0.1));
+            rb_ary_delete(SendWaitFibers, args->fiber_waiter);
+            args->fiber_waiter = Qnil;
+        } else {
+            args->generation = SendLimits.generation;
+            args->interrupted = 0;
+            rb_thread_call_without_gvl(send_wait_nogvl, args, send_wait_ubf, args);
+            rb_thread_check_ints();
+        }
+    }
+
+    return ctx->shutdown ? Qtrue : Qfalse;
+}
+
+static VALUE
+send_wait_done(VALUE arg)
+{
+    struct send_wait_args* args = (struct send_wait_args*)arg;
+    StreamContext* ctx = args->ctx;
+
+    if (!NIL_P(args->fiber_waiter)) {
+        rb_ary_delete(SendWaitFibers, args->fiber_waiter);  // raised while blocked
+    }
+    SendLimits.waiters--;
+    if (--ctx->send_waiters == 0 && ctx->shutdown) {
+        free(ctx);  // SHUTDOWN_COMPLETE left it to us
+    }
+    return Qnil;
+}
+
+// Block the calling writer while its stream or connection is over the
+// high-water mark. Returns 1 if the stream shut down meanwhile (ctx is then
+// no longer safe to use).
+static int
+wait_for_send_window(StreamContext* ctx)
+{
+    if (!send_over_high_water(ctx)) return 0;
+    // The poll thread can only wait from a request fiber (fiber-scheduler
+    // event loop), which yields back to the poll fiber; never in a callback.
+    if (PollThreadKnown && pthread_equal(pthread_self(), PollThread) &&
+        (CallbackDepth > 0 || NIL_P(rb_fiber_scheduler_current()))) return 0;
+
+    struct send_wait_args args = { .ctx = ctx, .generation = 0, .interrupted = 0, .fiber_waiter = Qnil };
+    ctx->send_waiters++;
+    SendLimits.waiters++;
+    SendLimits.waits++;
+    return RTEST(rb_ensure(send_wait_loop, (VALUE)&args, send_wait_done, (VALUE)&args));
+}
+
 // Send data on a QUIC stream
+// send_stream(stream_handle, data, send_fin, allow_0rtt = false, wait = true)
+//
+// With wait (the default), a writer whose stream or connection has more
+// than the configured high-water mark unacknowledged first waits for
+// SEND_COMPLETEs to drain it — see SendLimits. Pass false from callers that
+// must never block (async bodies written under a lock the event loop takes).
+//
+// allow_0rtt lets MsQuic encrypt the data with 0-RTT keys when the
+// connection is resuming and the handshake hasn't completed yet. If the
+// server rejects 0-RTT, MsQuic treats those packets as lost and resends
+// the stream data in 1-RTT — no replay needed at this layer.
 static VALUE
-quicsilver_send_stream(VALUE self, VALUE stream_handle, VALUE data, VALUE send_fin)
+quicsilver_send_stream(int argc, VALUE* argv, VALUE self)
 {
+    VALUE stream_handle, data, send_fin, allow_0rtt, wait;
+    rb_scan_args(argc, argv, "32", &stream_handle, &data, &send_fin, &allow_0rtt, &wait);
+
     if (MsQuic == NULL) {
         rb_raise(rb_eRuntimeError, "MSQUIC not initialized.");
         return Qnil;
@@ -1666,6 +2500,13 @@ quicsilver_send_stream(VALUE self, VALUE stream_handle, VALUE data, VALUE send_f
 
     HQUIC Stream = (HQUIC)(uintptr_t)NUM2ULL(stream_handle);
     StringValue(data);
+
+    StreamContext* ctx = (StreamContext*)MsQuic->GetContext(Stream);
+    if (ctx != NULL && (NIL_P(wait) || RTEST(wait)) && wait_for_send_window(ctx)) {
+        rb_raise(rb_eRuntimeError, "StreamSend failed, stream shut down while waiting for send window!");
+        return Qfalse;
+    }
+
     const char* data_str = RSTRING_PTR(data);
     uint32_t data_len = (uint32_t)RSTRING_LEN(data);
     
@@ -1685,6 +2526,9 @@ quicsilver_send_stream(VALUE self, VALUE stream_handle, VALUE data, VALUE send_f
     QUIC_SEND_FLAGS flags = (NIL_P(send_fin) || RTEST(send_fin))
         ? QUIC_SEND_FLAG_FIN
         : QUIC_SEND_FLAG_NONE;
+    if (RTEST(allow_0rtt)) {
+        flags |= QUIC_SEND_FLAG_ALLOW_0_RTT;
+    }
     
     QUIC_STATUS Status = MsQuic->StreamSend(Stream, SendBuffer, 1, flags, SendBufferRaw);
     if (QUIC_FAILED(Status)) {
@@ -1693,6 +2537,14 @@ quicsilver_send_stream(VALUE self, VALUE stream_handle, VALUE data, VALUE send_f
         return Qfalse;
     }
 
+    if (ctx != NULL) {
+        ctx->send_inflight += data_len;
+        SendLimits.inflight += data_len;
+        if (ctx->connection_ctx != NULL) {
+            ((ConnectionContext*)ctx->connection_ctx)->send_inflight += data_len;
+        }
+    }
+
     wake_event_loop();
     return Qtrue;
 }
@@ -1783,6 +2635,8 @@ quicsilver_stream_reset(VALUE self, VALUE stream_handle, VALUE error_code)
 
 // Queue a stream priority change. Called from Ruby threads — just stores the
 // priority. The actual SetParam happens on the MsQuic event thread in StreamCallback.
+// A change still queued for the stream (e.g. a PRIORITY_UPDATE re-sorting it
+// before the first one was applied) is replaced.
 static VALUE
 quicsilver_set_stream_priority(VALUE self, VALUE stream_handle, VALUE priority)
 {
@@ -1791,9 +2645,17 @@ quicsilver_set_stream_priority(VALUE self, VALUE stream_handle, VALUE priority)
     HQUIC Stream = (HQUIC)(uintptr_t)NUM2ULL(stream_handle);
     if (Stream == NULL) return Qnil;
 
+    uint16_t Priority = (uint16_t)NUM2UINT(priority);
+    for (int i = 0; i < PendingPriorityCount; i++) {
+        if (PendingPriorities[i].stream == Stream) {
+            PendingPriorities[i].priority_plus_one = Priority + 1;
+            wake_event_loop();
+            return Qtrue;
+        }
+    }
+
     if (PendingPriorityCount >= MAX_PENDING_PRIORITIES) return Qfalse;
 
-    uint16_t Priority = (uint16_t)NUM2UINT(priority);
     PendingPriorities[PendingPriorityCount].stream = Stream;
     PendingPriorities[PendingPriorityCount].priority_plus_one = Priority + 1;
     PendingPriorityCount++;
@@ -1822,6 +2684,81 @@ quicsilver_stream_stop_sending(VALUE self, VALUE stream_handle, VALUE error_code
     return Qtrue;
 }
 
+// Pause (false) or resume (true) RECEIVE delivery on a stream. While paused
+// MsQuic stops consuming the receive buffer, so the peer's flow-control
+// window closes and a fast uploader can't outrun a slow reader.
+static VALUE
+quicsilver_stream_receive_set_enabled(VALUE self, VALUE stream_handle, VALUE enabled)
+{
+    if (MsQuic == NULL) {
+        rb_raise(rb_eRuntimeError, "MSQUIC not initialized.");
+        return Qnil;
+    }
+
+    HQUIC Stream = (HQUIC)(uintptr_t)NUM2ULL(stream_handle);
+    if (Stream == NULL) return Qnil;
+
+    QUIC_STATUS Status = MsQuic->StreamReceiveSetEnabled(Stream, RTEST(enabled) ? TRUE : FALSE);
+    if (QUIC_FAILED(Status)) {
+        rb_raise(rb_eRuntimeError, "StreamReceiveSetEnabled failed, 0x%x!", Status);
+        return Qnil;
+    }
+
+    wake_event_loop();
+    return Qtrue;
+}
+
+// Per-stream and per-connection send high-water marks in bytes (0 =
+// unlimited). Process-wide, like the connection admission limits.
+static VALUE
+quicsilver_configure_send_limits(VALUE self, VALUE stream_bytes, VALUE connection_bytes)
+{
+    SendLimits.stream_high_water = NIL_P(stream_bytes) ? 0 : NUM2ULL(stream_bytes);
+    SendLimits.connection_high_water = NIL_P(connection_bytes) ? 0 : NUM2ULL(connection_bytes);
+    wake_send_waiters();
+    return Qnil;
+}
+
+// Bytes sent on a stream that MsQuic hasn't completed yet.
+static VALUE
+quicsilver_stream_send_inflight(VALUE self, VALUE stream_handle)
+{
+    if (MsQuic == NULL) {
+        rb_raise(rb_eRuntimeError, "MSQUIC not initialized.");
+        return Qnil;
+    }
+
+    HQUIC Stream = (HQUIC)(uintptr_t)NUM2ULL(stream_handle);
+    if (Stream == NULL) return Qnil;
+
+    StreamContext* ctx = (StreamContext*)MsQuic->GetContext(Stream);
+    return ctx ? ULL2NUM(ctx->send_inflight) : Qnil;
+}
+
+// Bytes sent on all of a connection's streams that MsQuic hasn't completed yet.
+static VALUE
+quicsilver_connection_send_inflight(VALUE self, VALUE connection_handle)
+{
+    if (MsQuic == NULL) {
+        rb_raise(rb_eRuntimeError, "MSQUIC not initialized.");
+        return Qnil;
+    }
+
+    HQUIC Connection = (HQUIC)(uintptr_t)NUM2ULL(connection_handle);
+    if (Connection == NULL) return Qnil;
+
+    ConnectionContext* ctx = (ConnectionContext*)MsQuic->GetContext(Connection);
+    return ctx ? ULL2NUM(ctx->send_inflight) : Qnil;
+}
+
+// Bytes sent on all streams in the process that MsQuic hasn't completed
+// yet — the send side of Transport::MemoryBudget's server-wide budget.
+static VALUE
+quicsilver_send_buffered(VALUE self)
+{
+    return ULL2NUM(SendLimits.inflight);
+}
+
 static VALUE
 quicsilver_wake(VALUE self)
 {
@@ -1829,11 +2766,362 @@ quicsilver_wake(VALUE self)
     return Qnil;
 }
 
+// === Response compression ===
+//
+// Quicsilver::Compressor — one content-coding stream per response body.
+// gzip (zlib) is always built; br and zstd when extconf finds libbrotlienc
+// and libzstd. A call runs without the GVL once COMPRESS_NOGVL_MIN bytes of
+// input have come in since the last call that released it, so other
+// requests keep running meanwhile. Counting earlier small chunks too
+// covers the encoders that buffer input and compress it in one go on a
+// later call (brotli's blocks, flush and finish). Below the threshold the
+// work at our levels is a few tens of microseconds, less than taking the
+// GVL back from a busy thread can cost. The output buffer is malloc'd
+// there and copied into a Ruby string afterwards.
+
+#define COMPRESS_NOGVL_MIN 4096
+#define COMPRESS_MIN_SPACE 1024
+
+typedef enum {
+    COMPRESS_GZIP,
+    COMPRESS_BROTLI,
+    COMPRESS_ZSTD
+} CompressKind;
+
+typedef struct {
+    CompressKind kind;
+    int ready;     // encoder state allocated and not finished
+    int busy;      // a call is running (possibly without the GVL)
+    size_t held;   // input bytes since the last call without the GVL
+    z_stream zs;
+#ifdef HAVE_BROTLI
+    BrotliEncoderState* br;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_CCtx* zstd;
+#endif
+} Compressor;
+
+typedef struct {
+    Compressor* c;
+    const uint8_t* in;
+    size_t in_len;
+    int flush;
+    int finish;
+    uint8_t* out;
+    size_t out_len;
+    size_t out_cap;
+    int failed;
+} CompressCall;
+
+static VALUE cCompressor;
+
+static void
+compressor_release(Compressor* c)
+{
+    if (!c->ready) return;
+    c->ready = 0;
+    switch (c->kind) {
+    case COMPRESS_GZIP:
+        deflateEnd(&c->zs);
+        break;
+    case COMPRESS_BROTLI:
+#ifdef HAVE_BROTLI
+        BrotliEncoderDestroyInstance(c->br);
+        c->br = NULL;
+#endif
+        break;
+    case COMPRESS_ZSTD:
+#ifdef HAVE_ZSTD
+        ZSTD_freeCCtx(c->zstd);
+        c->zstd = NULL;
+#endif
+        break;
+    }
+}
+
+static void
+compressor_free(void* ptr)
+{
+    Compressor* c = (Compressor*)ptr;
+    compressor_release(c);
+    xfree(c);
+}
+
+static size_t
+compressor_memsize(const void* ptr)
+{
+    return sizeof(Compressor);
+}
+
+static const rb_data_type_t compressor_type = {
+    .wrap_struct_name = "Quicsilver::Compressor",
+    .function = { .dfree = compressor_free, .dsize = compressor_memsize },
+    .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE
+compressor_alloc(VALUE klass)
+{
+    Compressor* c;
+    VALUE obj = TypedData_Make_Struct(klass, Compressor, &compressor_type, c);
+    return obj;
+}
+
+// Make room for at least COMPRESS_MIN_SPACE more output bytes.
+static int
+compress_reserve(CompressCall* call)
+{
+    if (call->out_cap - call->out_len >= COMPRESS_MIN_SPACE) return 1;
+
+    size_t cap = call->out_cap ? call->out_cap * 2 : call->in_len / 2 + COMPRESS_MIN_SPACE;
+    uint8_t* out = realloc(call->out, cap);
+    if (out == NULL) return 0;
+    call->out = out;
+    call->out_cap = cap;
+    return 1;
+}
+
+static void
+compress_gzip(CompressCall* call)
+{
+    z_stream* zs = &call->c->zs;
+    int mode = call->finish ? Z_FINISH : (call->flush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+
+    zs->next_in = (Bytef*)call->in;
+    zs->avail_in = (uInt)call->in_len;
+    for (;;) {
+        if (!compress_reserve(call)) { call->failed = 1; return; }
+        zs->next_out = call->out + call->out_len;
+        zs->avail_out = (uInt)(call->out_cap - call->out_len);
+
+        int ret = deflate(zs, mode);
+        call->out_len = call->out_cap - zs->avail_out;
+        if (ret == Z_STREAM_ERROR) { call->failed = 1; return; }
+        if (call->finish ? ret == Z_STREAM_END : zs->avail_out != 0) return;
+        if (ret == Z_BUF_ERROR && zs->avail_out != 0) return;  // nothing left to do
+    }
+}
+
+#ifdef HAVE_BROTLI
+static void
+compress_brotli(CompressCall* call)
+{
+    BrotliEncoderState* br = call->c->br;
+    BrotliEncoderOperation op = call->finish ? BROTLI_OPERATION_FINISH :
+        (call->flush ? BROTLI_OPERATION_FLUSH : BROTLI_OPERATION_PROCESS);
+    size_t avail_in = call->in_len;
+    const uint8_t* next_in = call->in;
+
+    for (;;) {
+        if (!compress_reserve(call)) { call->failed = 1; return; }
+        size_t avail_out = call->out_cap - call->out_len;
+        uint8_t* next_out = call->out + call->out_len;
+
+        if (!BrotliEncoderCompressStream(br, op, &avail_in, &next_in, &avail_out, &next_out, NULL)) {
+            call->failed = 1;
+            return;
+        }
+        call->out_len = call->out_cap - avail_out;
+        if (avail_in == 0 && !BrotliEncoderHasMoreOutput(br) &&
+            (!call->finish || BrotliEncoderIsFinished(br))) return;
+    }
+}
+#endif
+
+#ifdef HAVE_ZSTD
+static void
+compress_zstd(CompressCall* call)
+{
+    ZSTD_EndDirective mode = call->finish ? ZSTD_e_end : (call->flush ? ZSTD_e_flush : ZSTD_e_continue);
+    ZSTD_inBuffer input = { call->in, call->in_len, 0 };
+
+    for (;;) {
+        if (!compress_reserve(call)) { call->failed = 1; return; }
+        ZSTD_outBuffer output = { call->out + call->out_len, call->out_cap - call->out_len, 0 };
+
+        size_t remaining = ZSTD_compressStream2(call->c->zstd, &output, &input, mode);
+        call->out_len += output.pos;
+        if (ZSTD_isError(remaining)) { call->failed = 1; return; }
+        if (mode == ZSTD_e_continue) {
+            if (input.pos == input.size && output.pos < output.size) return;
+        } else if (remaining == 0) {
+            return;
+        }
+    }
+}
+#endif
+
+static void*
+compress_nogvl(void* ptr)
+{
+    CompressCall* call = (CompressCall*)ptr;
+    switch (call->c->kind) {
+    case COMPRESS_GZIP:
+        compress_gzip(call);
+        break;
+    case COMPRESS_BROTLI:
+#ifdef HAVE_BROTLI
+        compress_brotli(call);
+#endif
+        break;
+    case COMPRESS_ZSTD:
+#ifdef HAVE_ZSTD
+        compress_zstd(call);
+#endif
+        break;
+    }
+    return NULL;
+}
+
+// Compressor.new(encoding, level = nil) — encoding is "gzip", "br" or
+// "zstd"; level nil means the library's default.
+static VALUE
+compressor_initialize(int argc, VALUE* argv, VALUE self)
+{
+    VALUE encoding, level;
+    rb_scan_args(argc, argv, "11", &encoding, &level);
+
+    Compressor* c;
+    TypedData_Get_Struct(self, Compressor, &compressor_type, c);
+    if (c->ready) rb_raise(rb_eRuntimeError, "Compressor already initialized");
+
+    const char* name = StringValueCStr(encoding);
+    if (strcmp(name, "gzip") == 0) {
+        int lvl = NIL_P(level) ? Z_DEFAULT_COMPRESSION : NUM2INT(level);
+        c->kind = COMPRESS_GZIP;
+        memset(&c->zs, 0, sizeof(c->zs));
+        // windowBits 15 + 16: gzip wrapper rather than raw zlib
+        if (deflateInit2(&c->zs, lvl, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            rb_raise(rb_eArgError, "gzip: invalid compression level %d", lvl);
+        }
+#ifdef HAVE_BROTLI
+    } else if (strcmp(name, "br") == 0) {
+        // Checked up front: brotli and zstd clamp out-of-range levels silently
+        int lvl = NIL_P(level) ? BROTLI_DEFAULT_QUALITY : NUM2INT(level);
+        if (lvl < BROTLI_MIN_QUALITY || lvl > BROTLI_MAX_QUALITY) {
+            rb_raise(rb_eArgError, "br: invalid compression level %d", lvl);
+        }
+        c->kind = COMPRESS_BROTLI;
+        c->br = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+        if (c->br == NULL) rb_raise(rb_eNoMemError, "BrotliEncoderCreateInstance failed");
+        BrotliEncoderSetParameter(c->br, BROTLI_PARAM_QUALITY, (uint32_t)lvl);
+#endif
+#ifdef HAVE_ZSTD
+    } else if (strcmp(name, "zstd") == 0) {
+        // 0 is zstd's "default level"; negative levels are its fast modes
+        int lvl = NIL_P(level) ? 0 : NUM2INT(level);
+        if (lvl < ZSTD_minCLevel() || lvl > ZSTD_maxCLevel()) {
+            rb_raise(rb_eArgError, "zstd: invalid compression level %d", lvl);
+        }
+        c->kind = COMPRESS_ZSTD;
+        c->zstd = ZSTD_createCCtx();
+        if (c->zstd == NULL) rb_raise(rb_eNoMemError, "ZSTD_createCCtx failed");
+        ZSTD_CCtx_setParameter(c->zstd, ZSTD_c_compressionLevel, lvl);
+#endif
+    } else {
+        rb_raise(rb_eArgError, "Unsupported content-coding: %s", name);
+    }
+
+    c->ready = 1;
+    return self;
+}
+
+static VALUE
+compressor_run(VALUE self, VALUE chunk, int flush, int finish)
+{
+    Compressor* c;
+    TypedData_Get_Struct(self, Compressor, &compressor_type, c);
+    if (!c->ready) rb_raise(rb_eIOError, "Compressor is finished");
+    if (c->busy) rb_raise(rb_eRuntimeError, "Compressor is in use by another thread");
+
+    CompressCall call = { 0 };
+    call.c = c;
+    call.flush = flush;
+    call.finish = finish;
+    if (!NIL_P(chunk)) {
+        StringValue(chunk);
+        chunk = rb_str_new_frozen(chunk);  // can't change while the GVL is released
+        call.in = (const uint8_t*)RSTRING_PTR(chunk);
+        call.in_len = RSTRING_LEN(chunk);
+    }
+    if (call.in_len == 0 && !flush && !finish) return rb_str_new(NULL, 0);
+
+    c->busy = 1;
+    c->held += call.in_len;
+    if (c->held >= COMPRESS_NOGVL_MIN) {
+        c->held = 0;
+        rb_thread_call_without_gvl(compress_nogvl, &call, NULL, NULL);
+    } else {
+        compress_nogvl(&call);
+    }
+    c->busy = 0;
+    RB_GC_GUARD(chunk);
+
+    if (call.failed) {
+        free(call.out);
+        compressor_release(c);
+        rb_raise(rb_eRuntimeError, "Compression failed");
+    }
+
+    VALUE out = rb_str_new((const char*)call.out, call.out_len);
+    free(call.out);
+    if (finish) compressor_release(c);
+    return out;
+}
+
+// Compressed bytes for chunk. Output may be held back until later calls
+// unless flush is true, which emits everything compressed so far.
+static VALUE
+compressor_deflate(int argc, VALUE* argv, VALUE self)
+{
+    VALUE chunk, flush;
+    rb_scan_args(argc, argv, "11", &chunk, &flush);
+    return compressor_run(self, chunk, RTEST(flush), 0);
+}
+
+// Compress the last chunk (if any) and end the stream. The compressor is
+// freed; further calls raise IOError.
+static VALUE
+compressor_finish(int argc, VALUE* argv, VALUE self)
+{
+    VALUE chunk;
+    rb_scan_args(argc, argv, "01", &chunk);
+    return compressor_run(self, chunk, 0, 1);
+}
+
+// Drop the encoder state without finishing (e.g. the client went away).
+static VALUE
+compressor_close(VALUE self)
+{
+    Compressor* c;
+    TypedData_Get_Struct(self, Compressor, &compressor_type, c);
+    if (!c->busy) compressor_release(c);
+    return Qnil;
+}
+
+// Content-codings this build supports, most preferred first.
+static VALUE
+compressor_encodings(VALUE klass)
+{
+    VALUE encodings = rb_ary_new();
+#ifdef HAVE_ZSTD
+    rb_ary_push(encodings, rb_str_new_cstr("zstd"));
+#endif
+#ifdef HAVE_BROTLI
+    rb_ary_push(encodings, rb_str_new_cstr("br"));
+#endif
+    rb_ary_push(encodings, rb_str_new_cstr("gzip"));
+    return rb_ary_freeze(encodings);
+}
+
 // Initialize the extension
 void
 Init_quicsilver(void)
 {
     mQuicsilver = rb_define_module("Quicsilver");
+    SendWaitFibers = rb_ary_new();
+    rb_gc_register_address(&SendWaitFibers);
 
     // Core initialization
     rb_define_singleton_method(mQuicsilver, "open_connection", quicsilver_open, 0);
@@ -1861,6 +3149,7 @@ Init_quicsilver(void)
     
     // Listener management
     rb_define_singleton_method(mQuicsilver, "apply_msquic_server_id", quicsilver_apply_msquic_server_id, 1);
+    rb_define_singleton_method(mQuicsilver, "configure_connection_limits", quicsilver_configure_connection_limits, 1);
     rb_define_singleton_method(mQuicsilver, "create_listener", quicsilver_create_listener, 1);
     rb_define_singleton_method(mQuicsilver, "configure_listener_cibir", quicsilver_configure_listener_cibir, 2);
     rb_define_singleton_method(mQuicsilver, "configure_connection_cibir", quicsilver_configure_connection_cibir, 2);
@@ -1870,14 +3159,30 @@ Init_quicsilver(void)
 
     // Stream management
     rb_define_singleton_method(mQuicsilver, "open_stream", quicsilver_open_stream, 2);
-    rb_define_singleton_method(mQuicsilver, "send_stream", quicsilver_send_stream, 3);
+    rb_define_singleton_method(mQuicsilver, "send_stream", quicsilver_send_stream, -1);
     rb_define_singleton_method(mQuicsilver, "stream_reset", quicsilver_stream_reset, 2);
     rb_define_singleton_method(mQuicsilver, "stream_stop_sending", quicsilver_stream_stop_sending, 2);
+    rb_define_singleton_method(mQuicsilver, "stream_receive_set_enabled", quicsilver_stream_receive_set_enabled, 2);
+    rb_define_singleton_method(mQuicsilver, "stream_send_inflight", quicsilver_stream_send_inflight, 1);
+    rb_define_singleton_method(mQuicsilver, "connection_send_inflight", quicsilver_connection_send_inflight, 1);
+    rb_define_singleton_method(mQuicsilver, "send_buffered", quicsilver_send_buffered, 0);
+    rb_define_singleton_method(mQuicsilver, "configure_send_limits", quicsilver_configure_send_limits, 2);
     rb_define_singleton_method(mQuicsilver, "set_stream_priority", quicsilver_set_stream_priority, 2);
     rb_define_singleton_method(mQuicsilver, "get_stream_id", quicsilver_get_stream_id, 1);
     rb_define_singleton_method(mQuicsilver, "datagram_send", quicsilver_datagram_send, 2);
 
     // Event processing (custom execution — app drives MsQuic)
     rb_define_singleton_method(mQuicsilver, "poll", quicsilver_poll, 0);
+    rb_define_singleton_method(mQuicsilver, "poll_nowait", quicsilver_poll_nowait, 0);
+    rb_define_singleton_method(mQuicsilver, "event_queue_fd", quicsilver_event_queue_fd, 0);
     rb_define_singleton_method(mQuicsilver, "wake", quicsilver_wake, 0);
+
+    // Response compression
+    cCompressor = rb_define_class_under(mQuicsilver, "Compressor", rb_cObject);
+    rb_define_alloc_func(cCompressor, compressor_alloc);
+    rb_define_method(cCompressor, "initialize", compressor_initialize, -1);
+    rb_define_method(cCompressor, "deflate", compressor_deflate, -1);
+    rb_define_method(cCompressor, "finish", compressor_finish, -1);
+    rb_define_method(cCompressor, "close", compressor_close, 0);
+    rb_define_singleton_method(cCompressor, "encodings", compressor_encodings, 0);
 }
@@ -7,6 +7,7 @@ require_relative "quicsilver/response"
 
 # Protocol layer
 require_relative "quicsilver/protocol/frames"
+require_relative "quicsilver/protocol/chunk_buffer"
 require_relative "quicsilver/protocol/datagram"
 require_relative "quicsilver/protocol/capsule"
 require_relative "quicsilver/protocol/web_transport"
@@ -18,7 +19,10 @@ require_relative "quicsilver/protocol/request_encoder"
 require_relative "quicsilver/protocol/response_parser"
 require_relative "quicsilver/protocol/response_encoder"
 require_relative "quicsilver/protocol/stream_input"
+require_relative "quicsilver/protocol/request_spool"
 require_relative "quicsilver/protocol/stream_output"
+require_relative "quicsilver/protocol/coalescing_writer"
+require_relative "quicsilver/protocol/response_compression"
 require_relative "quicsilver/protocol/adapter"
 require_relative "quicsilver/protocol/control_stream_parser"
 require "protocol/rack"
@@ -33,19 +37,30 @@ require_relative "quicsilver/transport/stream_event"
 require_relative "quicsilver/transport/inbound_stream"
 require_relative "quicsilver/transport/event_loop"
 require_relative "quicsilver/transport/configuration"
+require_relative "quicsilver/transport/send_scheduler"
+require_relative "quicsilver/transport/memory_budget"
 require_relative "quicsilver/transport/connection"
 require_relative "quicsilver/transport/connection_stats"
 
 # Server
 require_relative "quicsilver/server/listener_data"
 require_relative "quicsilver/server/request_registry"
+require_relative "quicsilver/server/async_body"
+require_relative "quicsilver/server/cancellation"
+require_relative "quicsilver/server/request_deadlines"
+require_relative "quicsilver/server/response_cache"
+require_relative "quicsilver/server/server_push"
 require_relative "quicsilver/server/request_handler"
+require_relative "quicsilver/server/rack_env"
 require_relative "quicsilver/server/rack_adapter"
+require_relative "quicsilver/server/rack_env_adapter"
+require_relative "quicsilver/server/raw_adapter"
 require_relative "quicsilver/server/web_transport_manager"
 require_relative "quicsilver/server/server"
 
 # Client
 require_relative "quicsilver/client/request"
+require_relative "quicsilver/client/ticket_store"
 require_relative "quicsilver/client/connection_pool"
 require_relative "quicsilver/client/client"
 
@@ -6,11 +6,22 @@ module Quicsilver
 
     attr_reader :hostname, :port, :unsecure, :connection_timeout, :request_timeout
     attr_reader :peer_goaway_id, :peer_settings, :peer_max_field_section_size
+    attr_reader :ticket_store
 
-    FINISHED_EVENTS = %w[RECEIVE_FIN RECEIVE STREAM_RESET STOP_SENDING DATAGRAM_RECEIVED STREAM_START_COMPLETE STREAM_PEER_ACCEPTED].freeze
+    FINISHED_EVENTS = %w[RECEIVE_FIN RECEIVE STREAM_RESET STOP_SENDING DATAGRAM_RECEIVED STREAM_START_COMPLETE STREAM_PEER_ACCEPTED RESUMPTION_TICKET_RECEIVED].freeze
+
+    # ALPN negotiated by every client connection (set in the C configuration).
+    ALPN = "h3"
 
     DEFAULT_REQUEST_TIMEOUT = 30  # seconds
     DEFAULT_CONNECTION_TIMEOUT = 5000  # ms
+    DEFAULT_MAX_EARLY_DATA_SIZE = 16_384  # bytes (headers + body) sent in 0-RTT
+
+    # Safe methods (RFC 9110 §9.2.1). Only these ride in 0-RTT by default —
+    # early data can be replayed by an attacker before the handshake
+    # confirms, so the request must not change anything. Idempotent but
+    # unsafe methods (PUT, DELETE) need an explicit early_data_methods:.
+    EARLY_DATA_METHODS = %w[GET HEAD OPTIONS].freeze
 
     def initialize(hostname, port = 4433, **options)
       @hostname = hostname
@@ -21,18 +32,33 @@ module Quicsilver
       @max_body_size = options[:max_body_size]
       @max_header_size = options[:max_header_size]
 
+      # 0-RTT: when resuming, send the request that opens the connection
+      # before the handshake completes. Disable with early_data: false.
+      @early_data = options.fetch(:early_data, true)
+      @early_data_methods = options.fetch(:early_data_methods, EARLY_DATA_METHODS)
+      @max_early_data_size = options.fetch(:max_early_data_size, DEFAULT_MAX_EARLY_DATA_SIZE)
+
       # MsQuic CIBIR bytes for connecting to a CIBIR-configured listener.
       # Must be set before ConnectionStart; MsQuic currently supports offset 0 only.
       @transport_cibir_id = normalize_transport_cibir_id(options[:transport_cibir_id])
 
+      # Resumption tickets outlive this object when a store is given
+      # (see MemoryTicketStore / FileTicketStore). Without one, the ticket
+      # is only reused when this same Client reconnects.
+      @ticket_store = options.fetch(:ticket_store) { self.class.ticket_store }
+
       @connection_data = nil
       @connected = false
       @connection_start_time = nil
 
+      @qpack_encoder = Protocol::Qpack::Encoder.new  # reused across requests
       @response_buffers = {}  # stream_id => binary data
       @streaming = {}  # stream_id => { body:, frame_buffer: }
       @inflight = {}  # handle => { request:, stream_id: }
       @mutex = Mutex.new
+      # Serializes connection setup. Separate from @mutex so responses to a
+      # 0-RTT request can be dispatched while the handshake is still pending.
+      @connect_mutex = Mutex.new
 
       # Server control stream state
       @peer_settings = {}
@@ -53,6 +79,10 @@ module Quicsilver
     class << self
       attr_writer :pool
 
+      # Default ticket store for clients created without a ticket_store: option.
+      # nil (the default) keeps tickets per-Client.
+      attr_accessor :ticket_store
+
       def pool
         @pool ||= ConnectionPool.new
       end
@@ -87,7 +117,7 @@ module Quicsilver
       # Save resumption ticket before closing (for 0-RTT reconnection)
       if @connection_data
         ticket = Quicsilver.get_resumption_ticket(@connection_data[1])
-        @resumption_ticket = ticket if ticket
+        save_resumption_ticket(ticket) if ticket
       end
 
       @mutex.synchronize do
@@ -148,6 +178,11 @@ module Quicsilver
     end
 
     def build_request(method, path, headers: {}, body: nil, priority: nil)
+      unless @connected
+        request = build_early_request(method, path, headers: headers, body: body, priority: priority)
+        return request if request
+      end
+
       ensure_connected!
       raise GoAwayError, "Connection is draining (GOAWAY received)" if draining?
 
@@ -191,15 +226,22 @@ module Quicsilver
       "#{@hostname}:#{@port}"
     end
 
+    def ticket_key
+      TicketStore.key_for(@hostname, @port, ALPN)
+    end
+
     # :nodoc:
-    def open_connection
+    # When resuming with a ticket, yields after the connection has started but
+    # before the handshake completes — anything sent with early_data: true in
+    # the block goes out in 0-RTT.
+    def open_connection(&before_handshake)
       return self if @connected
 
       Quicsilver.open_connection
       config = Quicsilver.create_configuration(@unsecure)
       raise ConnectionError, "Failed to create configuration" if config.nil?
 
-      start_connection(config)
+      start_connection(config, &before_handshake)
       @connected = true
       @connection_start_time = Time.now
       send_control_stream
@@ -224,6 +266,11 @@ module Quicsilver
     def handle_stream_event(stream_id, event, data, _early_data) # :nodoc:
       return unless FINISHED_EVENTS.include?(event)
 
+      if event == "RESUMPTION_TICKET_RECEIVED"
+        save_resumption_ticket(data)
+        return
+      end
+
       # Server unidirectional streams (control, QPACK) — process incrementally
       if Transport::StreamId.unidirectional?(stream_id) && (event == "RECEIVE" || event == "RECEIVE_FIN")
         begin
@@ -297,20 +344,60 @@ module Quicsilver
 
     def ensure_connected!
       return if @connected
-      @mutex.synchronize do
+      @connect_mutex.synchronize do
         return if @connected
         open_connection
       end
     end
 
+    # 0-RTT (RFC 9001 §4.6.1): the request that triggers a resumed connection
+    # is sent alongside the ClientHello instead of one RTT later. Returns nil
+    # when the request isn't eligible or there is no ticket to resume with —
+    # the caller then falls back to the regular 1-RTT path.
+    #
+    # If the server rejects 0-RTT, MsQuic resends the stream data in 1-RTT.
+    # If it accepts 0-RTT but refuses the request (425 Too Early, RFC 8470),
+    # Request#response replays it once the handshake is done.
+    def build_early_request(method, path, headers:, body:, priority:)
+      return unless early_data_eligible?(method, path, headers, body)
+
+      request = nil
+      @connect_mutex.synchronize do
+        return if @connected
+
+        open_connection do
+          stream = open_stream
+          raise StreamFailedToOpenError unless stream
+
+          request = Request.new(self, stream, replay: [method, path, { headers: headers, body: body, priority: priority }])
+          @mutex.synchronize do
+            @inflight[stream.handle] = { request: request, stream_id: nil }
+          end
+          send_to_stream(stream, method, path, headers, body, priority: priority, early_data: true)
+        end
+      end
+      request
+    rescue
+      @mutex.synchronize { @inflight.delete(request.stream.handle) } if request
+      raise
+    end
+
+    def early_data_eligible?(method, path, headers, body)
+      return false unless @early_data && @early_data_methods.include?(method)
+      return false if body == :stream
+
+      # Sized as RequestEncoder sends it: arrays of chunks are joined
+      Array(body).join.bytesize + estimate_header_size(method, path, headers) <= @max_early_data_size
+    end
+
     def start_connection(config)
       connection_handle, context_handle = create_connection
 
       configure_cibir(connection_handle)
 
       # Apply saved resumption ticket for 0-RTT reconnection
-      if @resumption_ticket
-        Quicsilver.set_resumption_ticket(connection_handle, @resumption_ticket)
+      if (ticket = @resumption_ticket || @ticket_store&.fetch(ticket_key))
+        Quicsilver.set_resumption_ticket(connection_handle, ticket)
       end
 
       unless Quicsilver.start_connection(connection_handle, config, @hostname, @port)
@@ -318,6 +405,10 @@ module Quicsilver
         raise ConnectionError, "Failed to start connection"
       end
 
+      # Without a ticket there are no 0-RTT keys — early sends would just
+      # queue until the handshake finishes, so don't bother.
+      yield if ticket && block_given?
+
       result = Quicsilver.wait_for_connection(context_handle, @connection_timeout)
       handle_connection_result(result)
     end
@@ -346,6 +437,13 @@ module Quicsilver
       cibir_id.downcase
     end
 
+    def save_resumption_ticket(ticket)
+      @resumption_ticket = ticket
+      @ticket_store&.store(ticket_key, ticket)
+    rescue => e
+      Quicsilver.logger.debug("Failed to store resumption ticket: #{e.message}")
+    end
+
     def cleanup_failed_connection
       Quicsilver.close_connection_handle(@connection_data) if @connection_data
       @connection_data = nil
@@ -413,7 +511,7 @@ module Quicsilver
       false
     end
 
-    def send_to_stream(stream, method, path, headers, body, priority: nil)
+    def send_to_stream(stream, method, path, headers, body, priority: nil, early_data: false)
       # RFC 9114 §4.2.2: Enforce server's SETTINGS_MAX_FIELD_SECTION_SIZE
       if @peer_max_field_section_size
         header_size = estimate_header_size(method, path, headers)
@@ -427,16 +525,18 @@ module Quicsilver
         # Streaming mode: send HEADERS only, body sent later via Request#stream_body
         encoded = Protocol::RequestEncoder.new(
           method: method, path: path, scheme: "https",
-          authority: authority, headers: headers, body: nil, priority: priority
+          authority: authority, headers: headers, body: nil, priority: priority,
+          encoder: @qpack_encoder
         ).encode
         result = stream.send(encoded, fin: false)
       else
         # Buffered mode: send HEADERS + body + FIN
         encoded = Protocol::RequestEncoder.new(
           method: method, path: path, scheme: "https",
-          authority: authority, headers: headers, body: body, priority: priority
+          authority: authority, headers: headers, body: body, priority: priority,
+          encoder: @qpack_encoder
         ).encode
-        result = stream.send(encoded, fin: true)
+        result = early_data ? stream.send(encoded, fin: true, early_data: true) : stream.send(encoded, fin: true)
       end
 
       unless result
@@ -460,7 +560,7 @@ module Quicsilver
         state[:frame_buffer] << event_obj.data
         drain_streaming_data(state)
       else
-        (@response_buffers[stream_id] ||= "".b) << event_obj.data
+        (@response_buffers[stream_id] ||= Protocol::ChunkBuffer.new) << event_obj.data
         strip_informational_frames!(stream_id)
         # Only transition to streaming when the caller opted in via streaming_response.
         # Buffered callers (.response) are unaffected.
@@ -492,9 +592,10 @@ module Quicsilver
         ))
       else
         # Buffered mode: parse everything at once
-        buffer = @response_buffers.delete(stream_id)
-        full_data = (buffer || "".b) + event.data
-        full_data = strip_informational_data(full_data)
+        buffer = @response_buffers.delete(stream_id) || Protocol::ChunkBuffer.new
+        buffer << event.data
+        skip_informational_frames(buffer)
+        full_data = buffer.to_s
 
         response_parser = Protocol::ResponseParser.new(full_data, max_body_size: @max_body_size,
           max_header_size: @max_header_size)
@@ -530,33 +631,25 @@ module Quicsilver
       buf = @response_buffers[stream_id]
       return unless buf && buf.bytesize >= 2
 
-      # Use FrameReader to find the first HEADERS frame
-      status = nil
+      # Only look at the first frame — informational ones were already stripped
+      type, payload, size = buf.peek_frame
+      return unless type == Protocol::FRAME_HEADERS
+
+      status = peek_status(payload)
+      return unless status && status >= 200 # No final HEADERS yet
+
       headers = {}
-      headers_end = 0
-
-      Protocol::FrameReader.each(buf) do |type, payload, offset|
-        if type == Protocol::FRAME_HEADERS
-          s = peek_status(payload)
-          if s && s >= 200
-            status = s
-            PEEK_DECODER.decode(payload) do |name, value|
-              headers[name] = value unless name == ":status"
-            end
-            headers_end = offset
-          end
-        end
-        break # only look at the first frame
+      PEEK_DECODER.decode(payload) do |name, value|
+        headers[name] = value unless name == ":status"
       end
 
-      return unless status  # No final HEADERS yet
-
-      # Transition from buffered to streaming
-      remaining = buf.byteslice(headers_end..-1) || "".b
+      # Transition from buffered to streaming; the rest of the buffer is the
+      # start of the body frames.
+      buf.consume(size)
       @response_buffers.delete(stream_id)
 
       body = Protocol::StreamInput.new
-      state = { body: body, frame_buffer: remaining, status: status, headers: headers, trailers: {} }
+      state = { body: body, frame_buffer: buf, status: status, headers: headers, trailers: {} }
       @streaming[stream_id] = state
 
       # Drain any DATA frames that arrived with the HEADERS
@@ -572,9 +665,9 @@ module Quicsilver
     # Extract complete DATA frame payloads from frame_buffer and write to body.
     def drain_streaming_data(state)
       buf = state[:frame_buffer]
-      consumed = 0
 
-      Protocol::FrameReader.each(buf) do |type, payload, offset|
+      while (frame = buf.shift_frame)
+        type, payload = frame
         if type == Protocol::FRAME_DATA
           state[:body].write(payload)
         elsif type == Protocol::FRAME_HEADERS && state[:status]
@@ -583,11 +676,6 @@ module Quicsilver
           PEEK_DECODER.decode(payload) { |name, value| trailers[name] = value }
           state[:trailers] = trailers
         end
-        consumed = offset
-      end
-
-      if consumed > 0
-        state[:frame_buffer] = buf.byteslice(consumed..-1) || "".b
       end
     end
 
@@ -603,21 +691,23 @@ module Quicsilver
       size
     end
 
-    # Strip leading 1xx informational HEADERS frames from data.
+    # Drop leading 1xx informational HEADERS frames from a buffer.
     # RFC 9114 §4.1: Interim responses (1xx) precede the final response.
-    def strip_informational_data(data)
-      skip = Protocol::FrameReader.skip_while(data) do |type, payload|
-        type == Protocol::FRAME_HEADERS &&
+    def skip_informational_frames(buffer)
+      while (frame = buffer.peek_frame)
+        type, payload, size = frame
+        break unless type == Protocol::FRAME_HEADERS &&
           (status = peek_status(payload)) && status >= 100 && status < 200
+
+        buffer.consume(size)
       end
-      skip > 0 ? data.byteslice(skip..-1) || "".b : data
     end
 
     def strip_informational_frames!(stream_id)
       buf = @response_buffers[stream_id]
       return unless buf && buf.bytesize >= 2
 
-      @response_buffers[stream_id] = strip_informational_data(buf)
+      skip_informational_frames(buf)
     end
 
     # Decode just the :status pseudo-header from a QPACK header block.
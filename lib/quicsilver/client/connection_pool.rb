@@ -8,7 +8,7 @@ module Quicsilver
     #   Quicsilver::Client.get("example.com", 4433, "/users")
     #
     class ConnectionPool
-      attr_reader :max_size, :idle_timeout, :mode
+      attr_reader :max_size, :idle_timeout, :mode, :ticket_store
 
       DEFAULT_MAX_SIZE = 4
       DEFAULT_IDLE_TIMEOUT = 60 # seconds
@@ -19,11 +19,16 @@ module Quicsilver
       #     QUIC stream multiplexing. 5x faster, one TLS handshake per host.
       #   :exclusive — one connection per checkout, like ActiveRecord. Use for
       #     maintenance tasks that need isolation or servers with low stream limits.
-      def initialize(max_size: DEFAULT_MAX_SIZE, idle_timeout: DEFAULT_IDLE_TIMEOUT, checkout_timeout: DEFAULT_CHECKOUT_TIMEOUT, mode: :shared)
+      # @param ticket_store Resumption tickets shared by every client in the pool,
+      #   so a replacement connection resumes (0-RTT) instead of doing a full
+      #   handshake. Defaults to Client.ticket_store, else an in-memory LRU.
+      def initialize(max_size: DEFAULT_MAX_SIZE, idle_timeout: DEFAULT_IDLE_TIMEOUT, checkout_timeout: DEFAULT_CHECKOUT_TIMEOUT, mode: :shared,
+                     ticket_store: Client.ticket_store || MemoryTicketStore.new)
         @max_size = max_size
         @idle_timeout = idle_timeout
         @checkout_timeout = checkout_timeout
         @mode = mode
+        @ticket_store = ticket_store
         @pools = {} # "host:port" => [{ client:, checked_out: }]
         @mutex = Mutex.new
         @condition = ConditionVariable.new
@@ -71,7 +76,7 @@ module Quicsilver
         end
 
         # Create outside the lock (blocking I/O)
-        client = Client.new(hostname, port, **options)
+        client = Client.new(hostname, port, ticket_store: @ticket_store, **options)
         client.open_connection
 
         @mutex.synchronize do
@@ -98,7 +103,7 @@ module Quicsilver
         end
 
         # Create outside the lock (blocking I/O)
-        client = Client.new(hostname, port, **options)
+        client = Client.new(hostname, port, ticket_store: @ticket_store, **options)
         client.open_connection
 
         @mutex.synchronize do
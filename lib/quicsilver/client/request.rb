@@ -14,9 +14,13 @@ module Quicsilver
         end
       end
 
-      def initialize(client, stream)
+      # replay: [method, path, options] for requests sent in 0-RTT, so a
+      # 425 Too Early can be retried once the handshake has completed.
+      def initialize(client, stream, replay: nil)
         @client = client
         @stream = stream
+        @replay = replay
+        @early_data = !replay.nil?
         @status = :pending
         @queue = Queue.new
         @streaming_queue = Queue.new
@@ -26,6 +30,11 @@ module Quicsilver
         @streaming_requested = false
       end
 
+      # Whether the request was sent as 0-RTT early data.
+      def early_data?
+        @early_data
+      end
+
       # Whether the caller has opted into streaming via streaming_response.
       def streaming_requested?
         @streaming_requested
@@ -65,6 +74,7 @@ module Quicsilver
         return @response if @status == :completed
 
         result = @queue.pop(timeout: timeout)
+        result = replay_after_handshake(timeout) if too_early?(result)
 
         @mutex.synchronize do
           case result
@@ -166,6 +176,22 @@ module Quicsilver
         end
       end
 
+      private def too_early?(result)
+        @replay && result.is_a?(Response) && result.status == 425
+      end
+
+      # RFC 8470 §5.2: the server refused to process the request as early
+      # data. The handshake is complete by now, so resend it in 1-RTT.
+      private def replay_after_handshake(timeout)
+        method, path, options = @replay
+        @replay = nil
+        retried = @client.build_request(method, path, **options)
+        @stream = retried.stream
+        retried.response(timeout: timeout)
+      rescue ResetError => e
+        { error: true, error_code: e.error_code, message: e.message }
+      end
+
       # Called by Client when buffered response arrives
       def complete(response) # :nodoc:
         @queue.push(response)
@@ -0,0 +1,182 @@
+# frozen_string_literal: true
+
+require "fileutils"
+
+module Quicsilver
+  class Client
+    # Stores TLS resumption tickets so reconnects can skip the full handshake
+    # (and send 0-RTT data) even after the Client object — or the whole
+    # process — is gone. Keyed by "host:port:alpn".
+    #
+    # Any object responding to fetch(key), store(key, ticket) and delete(key)
+    # can be passed as a ticket store.
+    #
+    #   store = Quicsilver::Client::FileTicketStore.new("tmp/quic_tickets")
+    #   client = Quicsilver::Client.new("example.com", 443, ticket_store: store)
+    #
+    #   # Or for every client created by the class-level API / pool:
+    #   Quicsilver::Client.ticket_store = store
+    #
+    module TicketStore
+      # TLS 1.3 caps ticket lifetime at 7 days (RFC 8446 §4.6.1). MsQuic
+      # falls back to a full handshake for expired tickets, so this only
+      # bounds how long dead entries linger.
+      DEFAULT_MAX_AGE = 604_800 # seconds
+      DEFAULT_MAX_SIZE = 256
+
+      def self.key_for(hostname, port, alpn)
+        "#{hostname}:#{port}:#{alpn}"
+      end
+    end
+
+    # In-process LRU store. Shared by all clients created from a pool so
+    # short-lived connections to the same host resume each other's sessions.
+    class MemoryTicketStore
+      attr_reader :max_size, :max_age
+
+      def initialize(max_size: TicketStore::DEFAULT_MAX_SIZE, max_age: TicketStore::DEFAULT_MAX_AGE)
+        @max_size = max_size
+        @max_age = max_age
+        @entries = {} # key => [ticket, expires_at]; insertion order is LRU order
+        @mutex = Mutex.new
+      end
+
+      def fetch(key)
+        @mutex.synchronize do
+          ticket, expires_at = @entries.delete(key)
+          return nil unless ticket
+          return nil if expires_at < now
+
+          @entries[key] = [ticket, expires_at] # move to most-recently-used
+          ticket
+        end
+      end
+
+      def store(key, ticket)
+        return if ticket.nil? || ticket.empty?
+
+        @mutex.synchronize do
+          @entries.delete(key)
+          @entries[key] = [ticket.b.freeze, now + @max_age]
+          evict
+        end
+      end
+
+      def delete(key)
+        @mutex.synchronize { @entries.delete(key) }
+      end
+
+      def size
+        @mutex.synchronize { @entries.size }
+      end
+
+      private
+
+      def evict
+        @entries.shift while @entries.size > @max_size
+      end
+
+      def now
+        Process.clock_gettime(Process::CLOCK_REALTIME)
+      end
+    end
+
+    # Disk-backed store for processes that reconnect to the same hosts across
+    # restarts (batch jobs, CLIs). Reads are served from memory; the file is
+    # re-read when another process has changed it and rewritten atomically
+    # (write temp file + rename) under an exclusive lock on every store.
+    #
+    # Tickets are session secrets — the file is created with 0600 permissions.
+    class FileTicketStore < MemoryTicketStore
+      attr_reader :path
+
+      def initialize(path, **options)
+        super(**options)
+        @path = path
+        @loaded_mtime = nil
+      end
+
+      def fetch(key)
+        reload_if_changed
+        super
+      end
+
+      def store(key, ticket)
+        return if ticket.nil? || ticket.empty?
+
+        with_file_lock do
+          load_file
+          super
+          write_file
+        end
+      end
+
+      def delete(key)
+        with_file_lock do
+          load_file
+          super
+          write_file
+        end
+      end
+
+      private
+
+      def reload_if_changed
+        mtime = File.mtime(@path)
+        return if mtime == @loaded_mtime
+
+        with_file_lock(File::LOCK_SH) { load_file }
+      rescue Errno::ENOENT
+        nil
+      end
+
+      # One entry per line: key \t expires_at \t base64(ticket)
+      def load_file
+        entries = {}
+        if File.exist?(@path)
+          File.foreach(@path) do |line|
+            key, expires_at, encoded = line.chomp.split("\t", 3)
+            next unless key && expires_at && encoded
+
+            expires_at = expires_at.to_f
+            next if expires_at < now
+
+            entries[key] = [encoded.unpack1("m0").freeze, expires_at]
+          rescue ArgumentError
+            next # corrupt line — skip it, the next store rewrites the file
+          end
+          @loaded_mtime = File.mtime(@path)
+        end
+
+        @mutex.synchronize do
+          @entries = entries
+          evict
+        end
+      end
+
+      def write_file
+        lines = @mutex.synchronize do
+          @entries.map { |key, (ticket, expires_at)| "#{key}\t#{expires_at}\t#{[ticket].pack("m0")}\n" }
+        end
+
+        tmp = "#{@path}.#{Process.pid}.tmp"
+        File.open(tmp, File::WRONLY | File::CREAT | File::TRUNC, 0o600) { |f| f.write(lines.join) }
+        File.rename(tmp, @path)
+        @loaded_mtime = File.mtime(@path)
+      end
+
+      def with_file_lock(mode = File::LOCK_EX)
+        FileUtils.mkdir_p(File.dirname(@path))
+        File.open("#{@path}.lock", File::RDWR | File::CREAT, 0o600) do |lock|
+          lock.flock(mode)
+          yield
+        end
+      rescue SystemCallError => e
+        # A ticket store failure must never fail the request — worst case
+        # the next connection does a full handshake.
+        Quicsilver.logger.debug("Ticket store #{@path} unavailable: #{e.message}")
+        nil
+      end
+    end
+  end
+end
@@ -37,9 +37,11 @@ module Quicsilver
     class Adapter
       VERSION = "HTTP/3"
 
-      def initialize(app)
+      # encoder: the server's shared Qpack::Encoder; standalone adapters
+      # keep their own.
+      def initialize(app, encoder: Quicsilver::Protocol::Qpack::Encoder.new)
         @app = app
-        @qpack_encoder = Quicsilver::Protocol::Qpack::Encoder.new
+        @qpack_encoder = encoder
       end
 
       # Build a Protocol::HTTP::Request from parsed HTTP/3 headers.
@@ -55,7 +57,9 @@ module Quicsilver
       # @param remote_address [String, nil] Peer IP from the QUIC connection (e.g. "127.0.0.1").
       # @param remote_port [Integer] Peer port from the QUIC connection.
       # @param transport_context [Hash, nil] Quicsilver transport metadata for request debugging/log tags.
-      def build_request(headers, remote_address: nil, remote_port: 0, transport_context: nil, rack_context: nil)
+      # @param early_data [Boolean, nil] Whether the request arrived as 0-RTT; sent to the app as the
+      #   quicsilver-early-data header unless nil.
+      def build_request(headers, remote_address: nil, remote_port: 0, transport_context: nil, rack_context: nil, early_data: nil)
         method = headers[":method"]
         scheme = headers[":scheme"] || "https"
         authority = headers[":authority"]
@@ -68,6 +72,7 @@ module Quicsilver
           next if name.start_with?(":")
           protocol_headers.add(name, value)
         end
+        protocol_headers.add("quicsilver-early-data", early_data.to_s) unless early_data.nil?
 
         body = unless bodyless_request?(method)
           Protocol::StreamInput.new(content_length)
@@ -121,6 +126,33 @@ module Quicsilver
         @app.call(request)
       end
 
+      # Flatten a response for Connection#send_response.
+      #
+      # @param response [Protocol::HTTP::Response]
+      # @return [Array(Integer, Hash, Object, Hash | nil)] status, headers, body and trailers.
+      def response_parts(response)
+        headers = response.headers
+
+        # Extract trailers before flattening (Protocol::HTTP::Headers tracks
+        # trailer! state that a plain Hash would lose — needed for gRPC).
+        trailers = extract_trailers(headers)
+
+        response_headers = {}
+        if headers.respond_to?(:header)
+          headers.header.each { |name, value| response_headers[name] = value }
+        else
+          headers&.each { |name, value| response_headers[name] = value }
+        end
+
+        # Protocol-rack moves content-length from headers to body.length —
+        # re-add it so the HTTP/3 response includes the header.
+        if !response_headers.key?("content-length") && response.body&.length
+          response_headers["content-length"] = response.body.length.to_s
+        end
+
+        [response.status, response_headers, response.body, trailers]
+      end
+
       private
 
       # Methods where a body has no defined semantics (RFC 9110 §9.3.1, §9.3.2, §9.3.8).
@@ -134,7 +166,7 @@ module Quicsilver
 
       # No body — send HEADERS with FIN
       def send_headers_only(status, headers, writer, trailers: nil)
-        encoder = Quicsilver::Protocol::ResponseEncoder.new(status, headers, [], trailers: trailers)
+        encoder = Quicsilver::Protocol::ResponseEncoder.new(status, headers, [], encoder: @qpack_encoder, trailers: trailers)
         writer.call(encoder.encode, true)
       end
 
@@ -150,7 +182,7 @@ module Quicsilver
       # Buffered body (Rack array or enumerable) — encode everything and send.
       def buffer_response(status, headers, body, writer, trailers: nil)
         parts = body.respond_to?(:each) ? body : [body.to_s]
-        encoder = Quicsilver::Protocol::ResponseEncoder.new(status, headers, parts, trailers: trailers)
+        encoder = Quicsilver::Protocol::ResponseEncoder.new(status, headers, parts, encoder: @qpack_encoder, trailers: trailers)
         writer.call(encoder.encode, true)
       ensure
         body.close if body.respond_to?(:close)
@@ -0,0 +1,151 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  module Protocol
+    # Received stream bytes kept as a list of segments (a rope) instead of
+    # one growing String. Appending a RECEIVE payload never copies; frames
+    # are parsed across segment boundaries and only what a caller takes out
+    # — a frame payload, or the whole buffer via #to_s — is copied.
+    #
+    #   buffer = ChunkBuffer.new
+    #   buffer << payload             # per RECEIVE
+    #   while (frame = buffer.shift_frame)
+    #     type, payload = frame
+    #     body.write(payload) if type == FRAME_DATA
+    #   end
+    #
+    class ChunkBuffer
+      attr_reader :bytesize
+
+      def initialize(data = nil)
+        @chunks = []
+        @offset = 0 # bytes already consumed from @chunks.first
+        @bytesize = 0
+        self << data if data
+      end
+
+      def <<(data)
+        return self if data.nil? || data.empty?
+
+        @chunks << data
+        @bytesize += data.bytesize
+        self
+      end
+      alias write <<
+
+      def empty?
+        @bytesize == 0
+      end
+
+      def getbyte(index)
+        return if index < 0 || index >= @bytesize
+
+        index += @offset
+        @chunks.each do |chunk|
+          return chunk.getbyte(index) if index < chunk.bytesize
+          index -= chunk.bytesize
+        end
+        nil
+      end
+
+      # Copy length bytes starting at index into a new String.
+      def byteslice(index, length)
+        length = [length, @bytesize - index].min
+        return "".b if length <= 0
+
+        index += @offset
+        result = nil
+        @chunks.each do |chunk|
+          if index >= chunk.bytesize
+            index -= chunk.bytesize
+            next
+          end
+
+          take = [chunk.bytesize - index, length].min
+          piece = chunk.byteslice(index, take)
+          return piece if result.nil? && take == length # within one segment
+
+          (result ||= String.new(capacity: length, encoding: Encoding::BINARY)) << piece
+          length -= take
+          index = 0
+          break if length == 0
+        end
+        result
+      end
+
+      # Drop n bytes from the front.
+      def consume(n)
+        n = @bytesize if n > @bytesize
+        @bytesize -= n
+        n += @offset
+        while (chunk = @chunks.first) && n >= chunk.bytesize
+          n -= chunk.bytesize
+          @chunks.shift
+        end
+        @offset = n
+        self
+      end
+
+      # QUIC varint (RFC 9000 §16) at index: [value, bytes], or [0, 0] when
+      # the buffer ends first.
+      def varint(index)
+        first = getbyte(index)
+        return [0, 0] unless first
+
+        length = 1 << (first >> 6)
+        return [0, 0] if index + length > @bytesize
+
+        value = first & 0x3F
+        (1...length).each { |i| value = (value << 8) | getbyte(index + i) }
+        [value, length]
+      end
+
+      # [type, payload, frame_size] for the complete frame at the front, or
+      # nil if it hasn't fully arrived. Doesn't consume it.
+      def peek_frame
+        type, type_len = varint(0)
+        return if type_len == 0
+
+        length, length_len = varint(type_len)
+        return if length_len == 0
+
+        header_len = type_len + length_len
+        return if @bytesize < header_len + length
+
+        [type, byteslice(header_len, length), header_len + length]
+      end
+
+      # Remove and return the first complete frame as [type, payload].
+      def shift_frame
+        type, payload, size = peek_frame
+        return unless type
+
+        consume(size)
+        [type, payload]
+      end
+
+      def each_chunk
+        @chunks.each_with_index do |chunk, i|
+          yield(i == 0 && @offset > 0 ? chunk.byteslice(@offset..-1) : chunk)
+        end
+      end
+
+      # Contiguous copy, for APIs that need a single String (parsers). The
+      # buffer collapses to that one segment, so repeated calls don't copy.
+      def to_s
+        return "".b if empty?
+
+        flat = if @chunks.size == 1
+          @offset == 0 ? @chunks.first : @chunks.first.byteslice(@offset..-1)
+        else
+          String.new(capacity: @bytesize, encoding: Encoding::BINARY).tap do |s|
+            each_chunk { |chunk| s << chunk }
+          end
+        end
+        @chunks = [flat]
+        @offset = 0
+        flat
+      end
+    end
+  end
+end
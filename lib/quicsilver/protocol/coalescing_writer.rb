@@ -0,0 +1,167 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  module Protocol
+    # Corks a streamed response: small body chunks are merged into one DATA
+    # frame (and one transport send) until max_size bytes are buffered or
+    # max_delay has passed since the first of them, whichever comes first.
+    # Template streaming and chatty enumerators otherwise cost a malloc, a
+    # StreamSend, an event-loop wake and a QUIC frame per chunk.
+    #
+    #   writer = CoalescingWriter.new(max_size: 16_384, max_delay: 0.005) do |bytes, fin, wait|
+    #     stream.send(bytes, fin: fin, wait: wait)
+    #   end
+    #   writer.write_frame(headers_frame)
+    #   body.each { |chunk| writer.write(chunk) }   # "" flushes immediately
+    #   writer.close(trailers_frame)
+    #
+    # The delay is enforced by a shared background thread, so a chunk never
+    # waits on the app producing the next one. That thread serves every
+    # writer in the process, so its flushes are passed wait = false and must
+    # not block on send backpressure; the response thread's own writes
+    # (wait = true) still do.
+    class CoalescingWriter
+      DEFAULT_MAX_SIZE = 16_384  # ~12 full QUIC packets
+      DEFAULT_MAX_DELAY = 0.005  # 5ms
+
+      attr_reader :max_size, :max_delay, :deadline
+
+      # @param max_delay [Numeric, nil] Seconds; nil = no timer, flush only on
+      #   size, #flush or #close.
+      def initialize(max_size: DEFAULT_MAX_SIZE, max_delay: DEFAULT_MAX_DELAY, &writer)
+        @writer = writer
+        @max_size = max_size
+        @max_delay = max_delay
+        @mutex = Mutex.new
+        @framed = "".b   # encoded frames (HEADERS, sealed DATA) not yet sent
+        @data = "".b     # body bytes for the next DATA frame
+        @deadline = nil
+        @error = nil
+        @closed = false
+      end
+
+      # Queue an already-encoded frame (HEADERS) behind anything buffered.
+      def write_frame(frame)
+        @mutex.synchronize do
+          raise_error!
+          seal_data
+          @framed << frame
+          arm
+        end
+      end
+
+      # Buffer a body chunk. An empty chunk is an explicit flush (SSE).
+      def write(chunk)
+        return flush if chunk.empty?
+
+        @mutex.synchronize do
+          raise_error!
+          @data << (chunk.encoding == Encoding::BINARY ? chunk : chunk.b)
+          if @data.bytesize + @framed.bytesize >= @max_size
+            flush_locked
+          else
+            arm
+          end
+        end
+      end
+      alias << write
+
+      def flush
+        @mutex.synchronize do
+          raise_error!
+          flush_locked
+        end
+      end
+
+      # Send everything left, then the optional trailer frame, with FIN.
+      def close(trailer_frame = nil)
+        @mutex.synchronize do
+          raise_error!
+          seal_data
+          @framed << trailer_frame if trailer_frame
+          @closed = true
+          @deadline = nil
+          output, @framed = @framed, "".b
+          @writer.call(output, true, true)
+        end
+      end
+
+      def closed?
+        @closed
+      end
+
+      # Called by the Flusher thread once the deadline may have passed.
+      def flush_if_due
+        @mutex.synchronize do
+          return if @closed || @error || @deadline.nil? || now < @deadline
+
+          flush_locked(wait: false)
+        end
+      rescue => e
+        # Surfaced to the response thread on its next write
+        @mutex.synchronize { @error = e }
+      end
+
+      private
+
+      def seal_data
+        return if @data.empty?
+
+        @framed << Protocol.build_frame(FRAME_DATA, @data)
+        @data = "".b
+      end
+
+      def flush_locked(wait: true)
+        @deadline = nil
+        seal_data
+        return if @framed.empty?
+
+        output, @framed = @framed, "".b
+        @writer.call(output, false, wait)
+      end
+
+      def arm
+        return if @deadline || @max_delay.nil?
+
+        @deadline = now + @max_delay
+        Flusher.schedule(self)
+      end
+
+      def raise_error!
+        raise @error if @error
+      end
+
+      def now
+        Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      end
+
+      # One thread per process. Every writer uses a delay fixed at creation,
+      # so FIFO order is (close to) deadline order and a plain queue will do.
+      module Flusher
+        @queue = Thread::Queue.new
+        @mutex = Mutex.new
+        @thread = nil
+
+        def self.schedule(writer)
+          @mutex.synchronize do
+            unless @thread&.alive? # first use, or after fork
+              @thread = Thread.new { run }
+              @thread.name = "quicsilver-flusher"
+            end
+          end
+          @queue << writer
+        end
+
+        def self.run
+          while (writer = @queue.pop)
+            if (deadline = writer.deadline)
+              delay = deadline - Process.clock_gettime(Process::CLOCK_MONOTONIC)
+              sleep(delay) if delay > 0
+            end
+            writer.flush_if_due
+          end
+        end
+      end
+    end
+  end
+end
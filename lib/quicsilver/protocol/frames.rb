@@ -282,8 +282,9 @@ module Quicsilver
         encode_varint(type) + encode_varint(payload.bytesize) + payload
       end
 
-      # Build a HEADERS frame from key-value pairs via QPACK.
-      def build_headers_frame(pairs, encoder: Qpack::Encoder.new)
+      # Build a HEADERS frame from key-value pairs via QPACK. Pass the
+      # long-lived encoder of the server or client so its caches stay warm.
+      def build_headers_frame(pairs, encoder:)
         build_frame(FRAME_HEADERS, encoder.encode(pairs))
       end
 
@@ -295,6 +296,22 @@ module Quicsilver
         frame_type + frame_length + payload
       end
 
+      # PUSH_PROMISE (RFC 9114 §7.2.5): push ID + the promised request's
+      # encoded field section. Sent on the request stream.
+      def build_push_promise_frame(push_id, field_section)
+        build_frame(FRAME_PUSH_PROMISE, encode_varint(push_id) + field_section.b)
+      end
+
+      # CANCEL_PUSH (RFC 9114 §7.2.3) on the control stream.
+      def build_cancel_push_frame(push_id)
+        build_frame(FRAME_CANCEL_PUSH, encode_varint(push_id))
+      end
+
+      # MAX_PUSH_ID (RFC 9114 §7.2.7), sent by clients on the control stream.
+      def build_max_push_id_frame(push_id)
+        build_frame(FRAME_MAX_PUSH_ID, encode_varint(push_id))
+      end
+
       # Cache for decode_varint_str: (object_id << 16 | offset) → [value, consumed]
       VARINT_STR_CACHE = {}
       VARINT_STR_CACHE_MAX = 256
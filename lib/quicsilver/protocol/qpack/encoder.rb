@@ -20,50 +20,42 @@ module Quicsilver
 
         PREFIX = "\x00\x00".b.freeze
 
-        FIELD_CACHE_MAX = 512
-
-        def initialize(huffman: true)
+        # Cache bounds. Encoders are meant to be long-lived (one per server or
+        # client, shared across threads), so both caches evict least recently
+        # used entries rather than filling up once and going cold.
+        FIELD_CACHE_MAX = 512   # encoded single fields
+        BLOCK_CACHE_MAX = 256   # encoded header blocks (up to BLOCK_MAX_FIELDS)
+        BLOCK_MAX_FIELDS = 16
+
+        def initialize(huffman: true, max_fields: FIELD_CACHE_MAX, max_blocks: BLOCK_CACHE_MAX)
           @huffman = huffman
+          @max_fields = max_fields
+          @max_blocks = max_blocks
           @field_cache = {}
           @block_cache = {}
-          @oid_cache = {}
+          @mutex = Mutex.new
         end
 
+        # Takes the cache lock once per header block, not once per field.
         def encode(headers)
-          # Fastest path: exact same object as last call
-          return @last_result if headers.equal?(@last_headers)
-
-          # Fast path: check object_id cache (same array object reused)
-          oid = headers.object_id
-          cached = @oid_cache[oid]
-          if cached
-            @last_headers = headers
-            @last_result = cached
-            return cached
-          end
+          @mutex.synchronize do
+            next encode_fields(headers) unless headers.is_a?(Array) && headers.size <= BLOCK_MAX_FIELDS
 
-          if headers.is_a?(Array) && headers.size <= 16
             # Content-based caching for small header sets
-            block_key = headers.map { |n, v| "#{n}\0#{v}" }.join("\x01")
-            cached_block = @block_cache[block_key]
-            if cached_block
-              @oid_cache[oid] = cached_block if @oid_cache.size < BLOCK_CACHE_MAX
-              return cached_block
-            end
+            block_key = headers.map { |n, v| "#{n}\0#{v}" }.join("\x01").freeze
+            cached = cache_get(@block_cache, block_key)
+            next cached if cached
 
-            result = encode_fields(headers)
-            result_frozen = result.freeze
-            if @block_cache.size < BLOCK_CACHE_MAX
-              @block_cache[block_key.freeze] = result_frozen
-            end
-            @oid_cache[oid] = result_frozen if @oid_cache.size < BLOCK_CACHE_MAX
-            return result_frozen
+            result = encode_fields(headers).freeze
+            cache_put(@block_cache, block_key, result, @max_blocks)
+            result
           end
-
-          encode_fields(headers)
         end
 
-        BLOCK_CACHE_MAX = 128
+        # Entries currently cached, for stats and tests.
+        def cache_sizes
+          @mutex.synchronize { { "fields" => @field_cache.size, "blocks" => @block_cache.size } }
+        end
 
         private def encode_fields(headers)
           out = encode_prefix
@@ -73,10 +65,10 @@ module Quicsilver
             # Downcase only if needed (most HTTP/3 headers are already lowercase)
             name = name.downcase if name.match?(/[A-Z]/)
 
-            cache_key = "#{name}\0#{value}"
+            cache_key = "#{name}\0#{value}".freeze
 
             # Check field cache
-            cached = @field_cache[cache_key]
+            cached = cache_get(@field_cache, cache_key)
             if cached
               out << cached
               next
@@ -102,9 +94,7 @@ module Quicsilver
             end
 
             # Cache the encoded field bytes
-            if @field_cache.size < FIELD_CACHE_MAX
-              @field_cache[cache_key.freeze] = out.byteslice(field_start..).freeze
-            end
+            cache_put(@field_cache, cache_key, out.byteslice(field_start..).freeze, @max_fields)
           end
           out
         end
@@ -131,6 +121,21 @@ module Quicsilver
 
         private
 
+        # LRU over Hash insertion order: a hit moves the entry to the end,
+        # an insert past max drops the oldest from the front. Callers hold
+        # @mutex.
+        def cache_get(cache, key)
+          value = cache.delete(key)
+          cache[key] = value if value
+          value
+        end
+
+        def cache_put(cache, key, value, max)
+          cache.delete(key)
+          cache[key] = value
+          cache.shift while cache.size > max
+        end
+
         # Pattern 1: Indexed Field Line (1xxxxxxx) — kept for test compatibility
         def encode_indexed(index)
           encode_prefixed_int(index, 6, 0xC0)
@@ -3,7 +3,7 @@
 module Quicsilver
   module Protocol
     class RequestEncoder
-      def initialize(method:, path:, scheme: "https", authority: "localhost:4433", headers: {}, body: nil, priority: nil, encoder: Qpack::Encoder.new)
+      def initialize(method:, path:, scheme: "https", authority: "localhost:4433", headers: {}, body: nil, priority: nil, encoder:)
         @priority = priority
         @method = method.upcase
         @path = path
@@ -0,0 +1,157 @@
+# frozen_string_literal: true
+
+require "tempfile"
+require "protocol/http/body/readable"
+
+module Quicsilver
+  module Protocol
+    # Buffers a non-streaming request stream that has grown too large to keep
+    # in memory. Frames are split as bytes arrive: HEADERS (and any other
+    # non-DATA frames) are kept verbatim in #head for RequestParser, while
+    # DATA payloads are appended to an unlinked temp file. Resident memory is
+    # one partial frame header, however large the body.
+    #
+    #   spool = RequestSpool.new(max_body_size: 10 * 1024 * 1024)
+    #   spool << bytes   # per RECEIVE
+    #   RequestParser.new(spool.head).parse
+    #   request.body = spool.to_input(content_length)
+    #
+    class RequestSpool
+      attr_reader :head, :body_size
+
+      def initialize(max_body_size: nil, max_frame_payload_size: nil)
+        @max_body_size = max_body_size
+        @max_frame_payload_size = max_frame_payload_size
+        @head = "".b
+        @carry = "".b          # incomplete frame header from the last write
+        @remaining = 0         # payload bytes left in the current frame
+        @in_data = false
+        @headers_frames = 0
+        @body_size = 0
+        @file = Tempfile.new("quicsilver-body").tap do |file|
+          file.binmode
+          file.unlink # nothing to clean up if the process dies
+        end
+      end
+
+      def write(data)
+        unless @carry.empty?
+          data = @carry + data
+          @carry = "".b
+        end
+
+        offset = 0
+        size = data.bytesize
+
+        while offset < size
+          if @remaining > 0
+            n = [@remaining, size - offset].min
+            chunk = data.byteslice(offset, n)
+            @in_data ? @file.write(chunk) : @head << chunk
+            @remaining -= n
+            offset += n
+            next
+          end
+
+          type, type_len = Protocol.decode_varint_str(data, offset)
+          length, length_len = Protocol.decode_varint_str(data, offset + type_len) unless type_len == 0
+          if type_len == 0 || length_len == 0
+            @carry = data.byteslice(offset..-1)
+            break
+          end
+
+          header_len = type_len + length_len
+          start_frame(type, length, data.byteslice(offset, header_len))
+          offset += header_len
+        end
+
+        self
+      end
+      alias << write
+
+      def bytesize
+        @head.bytesize + @body_size
+      end
+
+      # The body as a request body for the app. Validates content-length
+      # (RFC 9114 §4.1.2) the same way StreamInput#close_write does.
+      def to_input(content_length = nil)
+        if content_length && content_length != @body_size
+          raise Protocol::MessageError, "Content-length mismatch: header=#{content_length}, body=#{@body_size}"
+        end
+
+        @file.flush
+        @file.rewind
+        Input.new(@file, @body_size)
+      end
+
+      def close
+        @file.close unless @file.closed?
+      end
+
+      private
+
+      def start_frame(type, length, frame_header)
+        if @max_frame_payload_size && length > @max_frame_payload_size
+          raise Protocol::FrameError, "Frame payload #{length} exceeds limit #{@max_frame_payload_size}"
+        end
+
+        if type == FRAME_DATA
+          raise Protocol::FrameError, "DATA frame before HEADERS" if @headers_frames == 0
+          raise Protocol::FrameError, "DATA frame after trailers" if @headers_frames > 1
+
+          @body_size += length
+          if @max_body_size && @body_size > @max_body_size
+            raise Protocol::MessageError, "Body size #{@body_size} exceeds limit #{@max_body_size}"
+          end
+          @in_data = true
+        else
+          # Leave frame validation (reserved types, header limits) to RequestParser
+          @headers_frames += 1 if type == FRAME_HEADERS
+          @head << frame_header
+          @in_data = false
+        end
+
+        @remaining = length
+      end
+
+      # File-backed request body, read in fixed-size blocks.
+      class Input < ::Protocol::HTTP::Body::Readable
+        BLOCK_SIZE = 65_536
+
+        attr_reader :length
+
+        def initialize(file, length)
+          @file = file
+          @length = length
+        end
+
+        def read
+          @file.read(BLOCK_SIZE) unless @file.closed?
+        end
+
+        def empty?
+          @file.closed? || @file.eof?
+        end
+
+        def ready?
+          true
+        end
+
+        def rewindable?
+          true
+        end
+
+        def rewind
+          @file.rewind
+          true
+        end
+
+        def close(error = nil)
+          @file.close unless @file.closed?
+          super
+        end
+      end
+    end
+  end
+end
@@ -0,0 +1,265 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  module Protocol
+    # Content-coding for responses (RFC 9110 §8.4, §12.5.3), applied by
+    # Connection#send_response when the response_compression option is on.
+    #
+    # The coding is the client's highest-q accept-encoding among the ones
+    # enabled, ties going to the server's order (zstd, br, gzip). Only
+    # compressible content types of MIN_SIZE bytes or more are encoded, and
+    # never responses that already have a content-encoding or say
+    # no-transform. Compression runs in Quicsilver::Compressor (C), without
+    # the GVL for large chunks.
+    #
+    # Immutable bodies — cache-control: immutable, e.g. fingerprinted
+    # assets — are compressed once at a higher level and the result kept
+    # in a byte-bounded LRU keyed by coding and content (or file path,
+    # mtime and size for bodies that respond to to_path).
+    class ResponseCompression
+      PREFERENCE = %w[zstd br gzip].freeze
+      MIN_SIZE = 1024
+      DEFAULT_VARIANT_CACHE_SIZE = 16 * 1024 * 1024
+
+      # Levels for bodies compressed per response, and for immutable ones
+      # compressed once into the variants cache.
+      LEVELS = { "zstd" => 3, "br" => 5, "gzip" => 6 }.freeze
+      VARIANT_LEVELS = { "zstd" => 15, "br" => 9, "gzip" => 9 }.freeze
+
+      COMPRESSIBLE_TYPE = %r{\A\s*(?:text/|application/(?:json|javascript|xml|wasm|manifest\+json|x-javascript)|image/svg\+xml|[^;]*\+(?:json|xml)\b)}i
+
+      # Status codes whose bodies are left alone: no content (204, 304),
+      # or a byte range of the unencoded representation (206).
+      SKIP_STATUSES = [204, 206, 304].freeze
+
+      # Bound on distinct accept-encoding values remembered.
+      MAX_NEGOTIATION_CACHE = 256
+
+      attr_reader :encodings
+
+      # @param encodings [Array<String>, nil] codings to offer, most preferred
+      #   first; nil for every one this build of the extension supports
+      def initialize(encodings: nil, variant_cache_size: DEFAULT_VARIANT_CACHE_SIZE)
+        @encodings = (encodings || PREFERENCE) & Quicsilver::Compressor.encodings
+        @negotiated = {}
+        @variant_cache_size = variant_cache_size
+        @variants = {} # [coding, content key] => compressed String, least recently used first
+        @variants_size = 0
+        @mutex = Mutex.new
+      end
+
+      # The coding to use for a request's accept-encoding, or nil.
+      def negotiate(accept_encoding)
+        return if accept_encoding.nil? || accept_encoding.empty? || @encodings.empty?
+
+        @negotiated.fetch(accept_encoding) do
+          coding = pick(accept_encoding)
+          @negotiated[accept_encoding.frozen? ? accept_encoding : accept_encoding.dup.freeze] = coding if @negotiated.size < MAX_NEGOTIATION_CACHE
+          coding
+        end
+      end
+
+      # [headers, body] to send: compressed if the client and the response
+      # allow it, otherwise the ones given.
+      def apply(status, headers, body, accept_encoding)
+        coding, content_type, cache_control = encodable(status, headers, accept_encoding)
+        return [headers, body] unless coding
+
+        immutable = cache_control&.include?("immutable")
+        if immutable && body.respond_to?(:to_path) && (compressed = file_variant(coding, body.to_path))
+          body.close if body.respond_to?(:close)
+          [encoded_headers(headers, coding, compressed.bytesize), [compressed]]
+        elsif body.respond_to?(:to_ary)
+          data = join(body.to_ary)
+          return [headers, body] if data.bytesize < MIN_SIZE
+
+          compressed = if immutable
+            variant(coding, data) { |compressor| compressor.finish(data) }
+          else
+            Quicsilver::Compressor.new(coding, LEVELS[coding]).finish(data)
+          end
+          body.close if body.respond_to?(:close)
+          [encoded_headers(headers, coding, compressed.bytesize), [compressed]]
+        else
+          flush = content_type.include?("text/event-stream")
+          compressor = Quicsilver::Compressor.new(coding, LEVELS[coding])
+          [encoded_headers(headers, coding, nil), CompressedBody.new(body, compressor, flush: flush)]
+        end
+      end
+
+      # Headers for a HEAD response: the ones its GET would be sent with,
+      # less the encoded content-length, which takes compressing the body to
+      # know (RFC 9110 §9.3.2). The body itself is never encoded.
+      def apply_head(status, headers, body, accept_encoding)
+        coding, _content_type, _cache_control, content_length = encodable(status, headers, accept_encoding)
+        return headers unless coding
+        return headers if content_length.nil? && body.respond_to?(:to_ary) &&
+          body.to_ary.sum { |chunk| chunk.to_s.bytesize } < MIN_SIZE
+
+        encoded_headers(headers, coding, nil)
+      end
+
+      def variants_size
+        @mutex.synchronize { @variants_size }
+      end
+
+      # A streamed body, compressed chunk by chunk. Output is held back by
+      # the compressor until it has a block's worth, except for
+      # text/event-stream (flush: true) and on an empty chunk, which the
+      # encoder treats as a flush request.
+      class CompressedBody
+        def initialize(body, compressor, flush: false)
+          @body = body
+          @compressor = compressor
+          @flush = flush
+        end
+
+        def each
+          @body.each do |chunk|
+            if chunk.nil? || chunk.empty?
+              out = @compressor.deflate(nil, true)
+              yield out unless out.empty?
+              yield "".b
+            else
+              out = @compressor.deflate(chunk.to_s, @flush)
+              yield out unless out.empty?
+            end
+          end
+          out = @compressor.finish
+          yield out unless out.empty?
+        end
+
+        def close
+          @compressor.close
+          @body.close if @body.respond_to?(:close)
+        end
+      end
+
+      private
+
+      # [coding, content-type, cache-control, content-length] when the
+      # response may be encoded for this accept-encoding, otherwise nil.
+      def encodable(status, headers, accept_encoding)
+        return if status < 200 || SKIP_STATUSES.include?(status)
+        return unless (coding = negotiate(accept_encoding))
+
+        content_type = content_length = cache_control = nil
+        headers.each do |name, value|
+          case name.to_s.downcase
+          when "content-encoding" then return
+          when "content-type" then content_type = value.to_s
+          when "content-length" then content_length = value.to_s.to_i
+          when "cache-control" then cache_control = value.to_s
+          end
+        end
+        return unless content_type&.match?(COMPRESSIBLE_TYPE)
+        return if cache_control&.include?("no-transform")
+        return if content_length && content_length < MIN_SIZE
+
+        [coding, content_type, cache_control, content_length]
+      end
+
+      def pick(accept_encoding)
+        weights = {}
+        accept_encoding.split(",").each do |item|
+          coding, *params = item.split(";")
+          coding = coding.strip.downcase
+          coding = "gzip" if coding == "x-gzip"
+          q = 1.0
+          params.each do |param|
+            name, value = param.strip.split("=", 2)
+            q = value.to_f if name&.downcase == "q"
+          end
+          weights[coding] = q
+        end
+
+        best = nil
+        best_q = 0.0
+        @encodings.each do |coding|
+          q = weights.fetch(coding) { weights.fetch("*", 0.0) }
+          best, best_q = coding, q if q > best_q
+        end
+        best
+      end
+
+      def join(chunks)
+        return chunks.first.to_s.b if chunks.size == 1
+
+        data = String.new(capacity: chunks.sum { |chunk| chunk.to_s.bytesize })
+        chunks.each { |chunk| data << chunk.to_s.b }
+        data
+      end
+
+      # Headers for the encoded representation: its length if known, the
+      # coding, vary on accept-encoding and a weak ETag (RFC 9110 §8.8.3).
+      def encoded_headers(headers, coding, length)
+        pairs = []
+        vary = false
+        headers.each do |name, value|
+          case name.to_s.downcase
+          when "content-length"
+            next
+          when "etag"
+            value = value.to_s
+            value = "W/#{value}" unless value.start_with?("W/")
+          when "vary"
+            vary = true
+            value = value.to_s
+            value = "#{value}, accept-encoding" unless value == "*" || value.downcase.include?("accept-encoding")
+          end
+          pairs << [name, value]
+        end
+        pairs << ["content-encoding", coding]
+        pairs << ["content-length", length.to_s] if length
+        pairs << ["vary", "accept-encoding"] unless vary
+        pairs
+      end
+
+      def file_variant(coding, path)
+        stat = File.stat(path)
+        return if stat.size < MIN_SIZE
+
+        variant(coding, [path, stat.mtime, stat.size]) do |compressor|
+          compressor.finish(File.binread(path))
+        end
+      rescue SystemCallError
+        nil
+      end
+
+      # The cached compressed form of content_key, made by the block on a
+      # miss. Concurrent misses may both compress; the last one is kept.
+      def variant(coding, content_key)
+        key = [coding, content_key]
+        @mutex.synchronize do
+          if (compressed = @variants.delete(key))
+            @variants[key] = compressed
+            return compressed
+          end
+        end
+
+        content_key = content_key.dup.freeze if content_key.is_a?(String) && !content_key.frozen?
+        compressed = yield(Quicsilver::Compressor.new(coding, VARIANT_LEVELS[coding])).freeze
+        size = compressed.bytesize + (content_key.is_a?(String) ? content_key.bytesize : 0)
+        return compressed if size > @variant_cache_size / 4
+
+        @mutex.synchronize do
+          if (old = @variants.delete(key))
+            @variants_size -= variant_size(key, old)
+          end
+          @variants[[coding, content_key].freeze] = compressed
+          @variants_size += size
+          while @variants_size > @variant_cache_size
+            evicted_key, evicted = @variants.shift
+            @variants_size -= variant_size(evicted_key, evicted)
+          end
+        end
+        compressed
+      end
+
+      def variant_size(key, compressed)
+        content_key = key[1]
+        compressed.bytesize + (content_key.is_a?(String) ? content_key.bytesize : 0)
+      end
+    end
+  end
+end
@@ -5,7 +5,7 @@ module Quicsilver
     class ResponseEncoder
       # Encode an informational (1xx) response as a single HEADERS frame.
       # RFC 9114 §4.1: informational responses are encoded as HEADERS with no body.
-      def self.encode_informational(status, headers, encoder: Qpack::Encoder.new)
+      def self.encode_informational(status, headers, encoder:)
         raise ArgumentError, "Informational status must be 1xx, got #{status}" unless (100..199).include?(status)
 
         pairs = [[":status", status.to_s]]
@@ -13,7 +13,7 @@ module Quicsilver
         Protocol.build_headers_frame(pairs, encoder: encoder)
       end
 
-      def initialize(status, headers, body, encoder: Qpack::Encoder.new, head_request: false, trailers: nil)
+      def initialize(status, headers, body, encoder:, head_request: false, trailers: nil)
         @status = status
         @headers = headers
         @body = body
@@ -62,6 +62,22 @@ module Quicsilver
         @body.close if @body.respond_to?(:close)
       end
 
+      # Just the HEADERS frame, for bodies the caller sends itself.
+      def encode_headers
+        build_frame(FRAME_HEADERS, @encoder.encode(all_headers))
+      end
+
+      # Streaming encode through a CoalescingWriter, so small chunks share
+      # DATA frames. The writer sends FIN on close; an empty chunk from the
+      # body forces a flush.
+      def stream_to(writer)
+        writer.write_frame(build_frame(FRAME_HEADERS, @encoder.encode(all_headers)))
+        @body.each { |chunk| writer.write(chunk) } unless @head_request
+        writer.close(@trailers&.any? ? build_frame(FRAME_HEADERS, @encoder.encode(trailer_headers)) : nil)
+
+        @body.close if @body.respond_to?(:close)
+      end
+
       private
 
       # RFC 9114 §4.2: connection-specific header fields must not appear in HTTP/3
@@ -18,6 +18,10 @@ module Quicsilver
     #
     # Optional features:
     # - Back-pressure via Thread::SizedQueue (bounded buffer)
+    # - Flow control via {flow_control} — pauses the sender instead of
+    #   blocking the writer, for writers that must never block (the poll thread)
+    # - Memory accounting via {charge_to} — unread bytes count against a
+    #   connection's Transport::MemoryBudget, and pause the sender over it
     # - Read timeout for slow client protection
     #
     class StreamInput < ::Protocol::HTTP::Body::Writable
@@ -39,42 +43,129 @@ module Quicsilver
         super(length, queue: queue)
         @read_timeout = read_timeout
         @bytes_written = 0
+
+        @flow_mutex = Mutex.new
+        @flow_control = nil
+        @max_buffered = nil
+        @buffered = 0
+        @paused = false
+        @account = nil
       end
 
       # @attribute [Numeric, nil] Read timeout in seconds.
       attr_reader :read_timeout
 
+      # @attribute [Integer, nil] Unread bytes at which the sender is paused.
+      attr_reader :max_buffered
+
+      # Bound unread data to roughly max_buffered bytes. The block is called
+      # with false once that much is waiting to be read and with true after
+      # the reader has drained it to half, so the transport can stop and
+      # restart consuming from the peer. Writes never block.
+      #
+      #   body.flow_control(262_144) { |enabled| Quicsilver.stream_receive_set_enabled(handle, enabled) }
+      def flow_control(max_buffered, &block)
+        @flow_mutex.synchronize do
+          @max_buffered = max_buffered
+          @flow_control = block
+        end
+      end
+
+      # Count unread bytes against a Transport::MemoryBudget::Account. While
+      # it is over budget, flow control pauses the sender below max_buffered
+      # too; it resumes once this body is drained, or drained to half and
+      # the account is back within budget.
+      def charge_to(account)
+        @flow_mutex.synchronize { @account = account }
+      end
+
+      # Give back what is still unread to the account, e.g. when the app
+      # finished without reading the whole body.
+      def release_memory
+        account, bytes = @flow_mutex.synchronize do
+          [@account, @buffered].tap { @account = nil }
+        end
+        account&.release(bytes)
+      end
+
+      # Bytes written but not yet read.
+      def buffered_bytes
+        @flow_mutex.synchronize { @buffered }
+      end
+
+      def paused?
+        @flow_mutex.synchronize { @paused }
+      end
+
       # Track bytes written for content-length validation.
       def write(chunk)
         @bytes_written += chunk.bytesize
         super
+        buffer(chunk.bytesize)
       end
 
       # Signal that no more data will be written.
       # Validates content-length if declared (RFC 9114 §4.1.2) — raises
       # MessageError if total bytes written don't match.
       def close_write(error = nil)
+        release_flow_control
         if @length && @bytes_written != @length
           raise Protocol::MessageError, "Content-length mismatch: header=#{@length}, body=#{@bytes_written}"
         end
         super
       end
 
+      def close(error = nil)
+        release_flow_control
+        release_memory
+        super
+      end
+
       # Read the next available chunk, with optional timeout.
       #
       # @returns [String | Nil] The next chunk, or nil if the body is finished.
       # @raises [ReadTimeout] If no data arrives within the timeout.
       # @raises [Exception] If the body was closed due to an error.
       def read
-        if @read_timeout
+        chunk = if @read_timeout
           read_with_timeout
         else
           super
         end
+        drained(chunk.bytesize) if chunk
+        chunk
       end
 
       private
 
+      def buffer(bytes)
+        @flow_mutex.synchronize do
+          @buffered += bytes
+          @account&.reserve(bytes)
+          if @flow_control && !@paused && (@buffered >= @max_buffered || @account&.over_budget?)
+            @paused = true
+            @flow_control.call(false)
+          end
+        end
+      end
+
+      def drained(bytes)
+        @flow_mutex.synchronize do
+          @buffered -= bytes
+          @account&.release(bytes)
+          if @flow_control && @paused && @buffered <= @max_buffered / 2 && (@buffered.zero? || !@account&.over_budget?)
+            @paused = false
+            @flow_control.call(true)
+          end
+        end
+      end
+
+      # Once the peer has finished (or the stream is gone) there is nothing
+      # left to throttle, and the transport handle may no longer be valid.
+      def release_flow_control
+        @flow_mutex.synchronize { @flow_control = nil }
+      end
+
       def read_with_timeout
         raise @error if @error
 
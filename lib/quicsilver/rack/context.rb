@@ -25,6 +25,33 @@ module Quicsilver
         !!@webtransport
       end
 
+      # Server::Cancellation for this request, when served by Quicsilver::Server.
+      def cancellation
+        @metadata["cancellation"]
+      end
+
+      # True once the client has reset the stream or the connection closed.
+      def cancelled?
+        !!cancellation&.cancelled?
+      end
+
+      # CLOCK_MONOTONIC time by which the response is due, if the request
+      # has a deadline (request_deadline_ms or the client's header).
+      def deadline
+        @metadata["deadline"]
+      end
+
+      # Seconds left before the deadline (negative once it has passed), or
+      # nil when there is none.
+      def time_remaining
+        deadline - Process.clock_gettime(Process::CLOCK_MONOTONIC) if deadline
+      end
+
+      # Seconds the request waited for a worker.
+      def queue_time
+        @metadata["queue_time"]
+      end
+
       def [](key)
         @metadata[key]
       end
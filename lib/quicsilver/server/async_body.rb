@@ -0,0 +1,128 @@
+# frozen_string_literal: true
+
+require "protocol/http/body/readable"
+
+module Quicsilver
+  class Server
+    # A response body the app writes to after returning from call.
+    #
+    # The worker that ran the app sends HEADERS and moves on to the next
+    # request; each later #write goes straight to the stream from whichever
+    # thread calls it (a pub/sub callback, a timer, another request). An idle
+    # SSE or long-poll client costs this object, not a thread.
+    #
+    # Usage:
+    #   app = ->(env) {
+    #     body = Quicsilver::Server::AsyncBody.new
+    #     body.on_close { subscribers.delete(body) }  # client left or body closed
+    #     subscribers << body
+    #     [200, { "content-type" => "text/event-stream" }, body]
+    #   }
+    #
+    #   subscribers.each { |body| body.write("data: tick\n\n") }
+    #   body.close  # FIN
+    #
+    # Anything that isn't the server (middleware that wraps the body, the
+    # Adapter on another transport) can still #read it like any other body;
+    # that path blocks a thread as usual.
+    class AsyncBody < ::Protocol::HTTP::Body::Readable
+      attr_reader :error
+
+      def initialize
+        @mutex = Mutex.new
+        @readable = ConditionVariable.new
+        @chunks = []     # written before the server attached
+        @writer = nil
+        @closed = false
+        @error = nil
+        @close_callbacks = []
+      end
+
+      # Send a chunk. Returns false once the body is closed (including when
+      # the client went away), so broadcasters can drop it.
+      def write(chunk)
+        @mutex.synchronize do
+          return false if @closed
+
+          if @writer
+            @writer.call(chunk.to_s, false)
+          else
+            @chunks << chunk.to_s
+            @readable.signal
+          end
+        end
+        true
+      rescue RuntimeError => e
+        close(e)
+        false
+      end
+      alias << write
+
+      # Finish the response. With an error (client reset, connection closed)
+      # nothing more is sent.
+      def close(error = nil)
+        callbacks = @mutex.synchronize do
+          return if @closed
+
+          @closed = true
+          @error = error
+          begin
+            @writer.call("".b, true) if @writer && error.nil?
+          rescue RuntimeError => e
+            @error = e
+          end
+          @writer = nil
+          @readable.broadcast
+          @close_callbacks.dup
+        end
+
+        callbacks.each { |callback| callback.call(@error) }
+        nil
+      end
+
+      def closed?
+        @closed
+      end
+
+      def on_close(&block)
+        run_now = @mutex.synchronize do
+          @close_callbacks << block unless @closed
+          @closed
+        end
+        block.call(@error) if run_now
+      end
+
+      # Called by the server once HEADERS are out. Flushes anything written
+      # in the meantime, then every write goes straight to the writer.
+      def attach(&writer)
+        @mutex.synchronize do
+          @chunks.each { |chunk| writer.call(chunk, false) }
+          @chunks.clear
+          if @closed
+            writer.call("".b, true) if @error.nil?
+          else
+            @writer = writer
+          end
+        end
+      rescue RuntimeError => e
+        close(e)
+      end
+
+      def attached?
+        !@writer.nil?
+      end
+
+      # Blocking read, for callers that treat this as an ordinary body.
+      def read
+        @mutex.synchronize do
+          @readable.wait(@mutex) while @chunks.empty? && !@closed
+          @chunks.shift
+        end
+      end
+
+      def empty?
+        @closed && @chunks.empty?
+      end
+    end
+  end
+end
@@ -0,0 +1,70 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  class Server
+    # Fired when the client resets a request stream, sends STOP_SENDING, or
+    # the connection closes while the request is queued or running.
+    #
+    # Rack apps find it at env["quicsilver.cancellation"] (or
+    # env["quicsilver.context"].cancelled?); Falcon-mode apps at
+    # request.transport_context["cancellation"].
+    #
+    #   cancellation = env["quicsilver.cancellation"]
+    #   cancellation.on_cancel { db.cancel_query }    # abort blocking work
+    #   rows.each do |row|
+    #     cancellation.raise_if_cancelled!            # or poll #cancelled?
+    #     process(row)
+    #   end
+    #
+    # Callbacks run on the event loop thread: keep them short and don't
+    # block. The worker itself is never interrupted behind the app's back.
+    class Cancellation
+      attr_reader :reason
+
+      def initialize
+        @mutex = Mutex.new
+        @cancelled = false
+        @reason = nil
+        @callbacks = []
+      end
+
+      def cancelled?
+        @cancelled
+      end
+
+      # Returns false if already cancelled. Callbacks run outside the lock.
+      def cancel(reason = "cancelled")
+        callbacks = @mutex.synchronize do
+          return false if @cancelled
+
+          @cancelled = true
+          @reason = reason
+          @callbacks.dup.tap { @callbacks.clear }
+        end
+
+        callbacks.each do |callback|
+          callback.call(reason)
+        rescue => e
+          Quicsilver.logger.error("Cancellation callback failed: #{e.class} - #{e.message}")
+        end
+        true
+      end
+
+      # Runs immediately if the request is already cancelled.
+      def on_cancel(&block)
+        run_now = @mutex.synchronize do
+          @callbacks << block unless @cancelled
+          @cancelled
+        end
+        block.call(@reason) if run_now
+        self
+      end
+
+      # Safe point for long-running work: raises Quicsilver::CancelledError
+      # once the client has gone.
+      def raise_if_cancelled!
+        raise CancelledError, @reason if @cancelled
+      end
+    end
+  end
+end
@@ -12,6 +12,8 @@ module Quicsilver
     #   env["rack.trailers"] = { "grpc-status" => "0", "grpc-message" => "OK" }
     #
     class RackAdapter < ::Protocol::Rack::Adapter::Rack31
+      include RackEnv
+
       def call(request)
         env = self.make_environment(request)
         add_transport_context(env, request)
@@ -38,40 +40,6 @@ module Quicsilver
       rescue => error
         self.handle_error(env, status, headers, body, error)
       end
-
-      private
-
-      def add_rack_context(env, rack_context)
-        env["quicsilver.context"] = rack_context
-
-        if rack_context.respond_to?(:webtransport) && rack_context.webtransport
-          env["quicsilver.webtransport"] = rack_context.webtransport
-        end
-      end
-
-      def add_transport_context(env, request)
-        return unless request.respond_to?(:transport_context)
-        return unless (context = request.transport_context)
-
-        connection = context["connection"] || {}
-
-        if connection_id = connection["connection_id"]
-          env["quicsilver.connection_id"] = connection_id
-        end
-
-        if request_id = connection["request_id"]
-          env["quicsilver.request_id"] = request_id
-        end
-
-        if stream_id = connection["stream_id"]
-          env["quicsilver.stream_id"] = stream_id
-        end
-
-        env["quicsilver.context"] ||= ::Quicsilver::Rack::Context.new(
-          stream_id: connection["stream_id"],
-          metadata: context
-        )
-      end
     end
   end
 end
@@ -0,0 +1,59 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  class Server
+    # Quicsilver's additions to the Rack env, shared by RackAdapter (:rack
+    # mode) and RackEnvAdapter (:rack_direct mode).
+    module RackEnv
+      private
+
+      def add_rack_context(env, rack_context)
+        env["quicsilver.context"] = rack_context
+
+        if rack_context.respond_to?(:webtransport) && rack_context.webtransport
+          env["quicsilver.webtransport"] = rack_context.webtransport
+        end
+      end
+
+      def add_transport_context(env, request)
+        return unless request.respond_to?(:transport_context)
+        return unless (context = request.transport_context)
+
+        connection = context["connection"] || {}
+
+        if connection_id = connection["connection_id"]
+          env["quicsilver.connection_id"] = connection_id
+        end
+
+        if request_id = connection["request_id"]
+          env["quicsilver.request_id"] = request_id
+        end
+
+        if stream_id = connection["stream_id"]
+          env["quicsilver.stream_id"] = stream_id
+        end
+
+        if cancellation = context["cancellation"]
+          env["quicsilver.cancellation"] = cancellation
+        end
+
+        if deadline = context["deadline"]
+          env["quicsilver.deadline"] = deadline
+        end
+
+        if queue_time = context["queue_time"]
+          env["quicsilver.queue_time"] = queue_time
+        end
+
+        if push = context["push"]
+          env["quicsilver.push"] = push
+        end
+
+        env["quicsilver.context"] ||= ::Quicsilver::Rack::Context.new(
+          stream_id: connection["stream_id"],
+          metadata: context
+        )
+      end
+    end
+  end
+end
@@ -0,0 +1,260 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  class Server
+    # Rack adapter for mode: :rack_direct — a lean alternative to the
+    # protocol-http path that :rack mode takes (Protocol::HTTP::Request,
+    # Headers and Peer, then protocol-rack's env and Response wrapping).
+    #
+    # The env is built straight from the decoded header hash: env keys are
+    # frozen literals, HTTP_* names are cached per header name, and the
+    # app's [status, headers, body] goes to the response encoder as-is.
+    # Drop-in for Protocol::Adapter as far as the server is concerned
+    # (build_request / call / response_parts). Allocation counts for both
+    # paths: benchmarks/rack_env.rb.
+    class RackEnvAdapter
+      include RackEnv
+
+      SERVER_PROTOCOL = "HTTP/3"
+      BODYLESS_METHODS = %w[GET HEAD TRACE].freeze
+
+      # Header names never become HTTP_* keys (RFC 3875 §4.1.2, §4.1.3).
+      SPECIAL_KEYS = {
+        "content-type" => "CONTENT_TYPE",
+        "content-length" => "CONTENT_LENGTH"
+      }.freeze
+
+      # Bound on cached header names and authorities — both come from
+      # clients, so past this they are computed per request instead.
+      MAX_CACHE_SIZE = 1024
+
+      # Carries the parsed headers from build_request to call. Exposes the
+      # part of Protocol::Request the server uses.
+      class Request
+        attr_reader :headers, :transport_context, :rack_context, :remote_address, :early_data
+        attr_accessor :body, :interim_response
+
+        def initialize(headers, body, remote_address, transport_context, rack_context, early_data)
+          @headers = headers
+          @body = body
+          @remote_address = remote_address
+          @transport_context = transport_context
+          @rack_context = rack_context
+          @early_data = early_data
+          @interim_response = nil
+        end
+
+        def method
+          @headers[":method"]
+        end
+
+        def path
+          @headers[":path"]
+        end
+
+        def head?
+          method == "HEAD"
+        end
+      end
+
+      Response = Struct.new(:status, :headers, :body, :trailers)
+
+      def initialize(app)
+        @app = app
+        @env_keys = SPECIAL_KEYS.dup
+        @authorities = {}
+      end
+
+      # Same contract as Protocol::Adapter#build_request: returns
+      # [request, body], body being the StreamInput the transport feeds (nil
+      # for GET, HEAD and TRACE). The env itself is built in #call, after the
+      # request has left the queue.
+      def build_request(headers, remote_address: nil, remote_port: 0, transport_context: nil, rack_context: nil, early_data: nil)
+        body = unless BODYLESS_METHODS.include?(headers[":method"])
+          Protocol::StreamInput.new(headers["content-length"]&.to_i)
+        end
+
+        [Request.new(headers, body, remote_address, transport_context, rack_context, early_data), body]
+      end
+
+      def call(request)
+        env = build_env(request)
+        status, headers, body = @app.call(env)
+
+        trailers = env["rack.trailers"]
+        trailers = nil unless trailers.is_a?(Hash) && !trailers.empty?
+
+        Response.new(status.to_i, response_headers(headers), response_body(body, env), trailers)
+      end
+
+      # [status, headers, body, trailers] for Connection#send_response.
+      def response_parts(response)
+        [response.status, response.headers, response.body, response.trailers]
+      end
+
+      def build_env(request)
+        headers = request.headers
+        path = headers[":path"] || "/"
+        if (query = path.index("?"))
+          path_info = path.byteslice(0, query)
+          query_string = path.byteslice(query + 1, path.bytesize)
+        else
+          path_info = path
+          query_string = ""
+        end
+        authority = headers[":authority"]
+        server_name, server_port = split_authority(authority)
+
+        env = {
+          "REQUEST_METHOD" => headers[":method"],
+          "SCRIPT_NAME" => "",
+          "PATH_INFO" => path_info,
+          "QUERY_STRING" => query_string,
+          "SERVER_NAME" => server_name,
+          "SERVER_PORT" => server_port,
+          "SERVER_PROTOCOL" => SERVER_PROTOCOL,
+          "rack.url_scheme" => headers[":scheme"] || "https",
+          "rack.errors" => $stderr
+        }
+
+        headers.each do |name, value|
+          next if name.start_with?(":")
+          env[@env_keys[name] || env_key(name)] = value
+        end
+        env["HTTP_HOST"] ||= authority if authority
+        env["HTTP_QUICSILVER_EARLY_DATA"] = request.early_data.to_s unless request.early_data.nil?
+
+        # Empty for bodyless requests, as in :rack mode (Rack 3.0 requires it)
+        env["rack.input"] = ::Protocol::Rack::Input.new(request.body)
+        env["rack.protocol"] = headers[":protocol"] if headers[":protocol"]
+        env["REMOTE_ADDR"] = request.remote_address if request.remote_address
+
+        add_transport_context(env, request)
+        add_rack_context(env, request.rack_context) if request.rack_context
+
+        if (interim_response = request.interim_response)
+          env["rack.early_hints"] = ->(hints) { interim_response.call(103, response_headers(hints)) }
+        end
+
+        env
+      end
+
+      private
+
+      def env_key(name)
+        key = "HTTP_#{name.upcase.tr("-", "_")}".freeze
+        @env_keys[name] = key if @env_keys.size < MAX_CACHE_SIZE
+        key
+      end
+
+      def split_authority(authority)
+        return ["localhost", "443"] unless authority
+
+        @authorities[authority] || begin
+          colon = authority.rindex(":")
+          parts = if colon && !authority.index("]", colon)
+            [authority[0, colon].freeze, authority[colon + 1..].freeze].freeze
+          else
+            [authority, "443"].freeze
+          end
+          @authorities[authority] = parts if @authorities.size < MAX_CACHE_SIZE
+          parts
+        end
+      end
+
+      # Rack 3 headers map a name to a String or an Array of Strings (Rack 2
+      # joined them with "\n"). The common single-valued hash is passed
+      # through untouched; otherwise it becomes name/value pairs, which the
+      # encoder iterates the same way.
+      def response_headers(headers)
+        return {} unless headers
+        return headers unless headers.any? { |_, value| multi_value?(value) }
+
+        pairs = []
+        headers.each do |name, value|
+          if value.is_a?(Array)
+            value.each { |item| pairs << [name, item] }
+          elsif multi_value?(value)
+            value.split("\n").each { |item| pairs << [name, item] }
+          else
+            pairs << [name, value]
+          end
+        end
+        pairs
+      end
+
+      def multi_value?(value)
+        value.is_a?(Array) || (value.is_a?(String) && value.include?("\n"))
+      end
+
+      # Enumerable bodies (and AsyncBody) go out as they are; a Rack 3
+      # streaming body (responds only to #call) is run by the encoder.
+      def response_body(body, env)
+        return body if body.nil? || body.respond_to?(:each)
+        return StreamingBody.new(body, env["rack.input"]) if body.respond_to?(:call)
+
+        [body.to_s]
+      end
+
+      # Runs a Rack 3 streaming body inside #each, so every write becomes a
+      # DATA frame as the app makes it.
+      class StreamingBody
+        def initialize(body, input)
+          @body = body
+          @input = input
+        end
+
+        def each(&block)
+          @body.call(Stream.new(block, @input))
+        end
+      end
+
+      # The stream object a streaming body writes to.
+      class Stream
+        def initialize(output, input)
+          @output = output
+          @input = input
+          @closed = false
+        end
+
+        def read(...)
+          @input&.read(...)
+        end
+
+        def write(chunk)
+          raise IOError, "stream closed" if @closed
+
+          chunk = chunk.to_s
+          @output.call(chunk) unless chunk.empty?
+          chunk.bytesize
+        end
+
+        def <<(chunk)
+          write(chunk)
+          self
+        end
+
+        def flush
+          self
+        end
+
+        def close_read
+          @input&.close
+        end
+
+        def close_write
+          @closed = true
+        end
+
+        def close
+          close_read
+          close_write
+        end
+
+        def closed?
+          @closed
+        end
+      end
+    end
+  end
+end
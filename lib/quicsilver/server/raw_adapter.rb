@@ -0,0 +1,158 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  class Server
+    # Adapter for mode: :raw — no Rack env and no protocol-http objects, for
+    # endpoints where per-request overhead dominates (health checks, metrics,
+    # small RPC).
+    #
+    #   app = ->(stream, headers, body) {
+    #     [200, ["content-type", "application/json"], %({"ok":true})]
+    #   }
+    #
+    # headers is a flat, frozen [name, value, name, value, ...] array,
+    # pseudo-headers first; body is nil or a protocol-http readable
+    # (body.join reads it all). The app returns status, a flat header array
+    # and a String body. HEADERS frames are cached per (header array,
+    # status), so an app returning constant header arrays sends each
+    # response as one string with nothing else allocated. Headers are sent
+    # as given: lowercase names, no content-length added.
+    class RawAdapter
+      BODYLESS_METHODS = %w[GET HEAD TRACE].freeze
+
+      # Bound on each cache; both key on client- or app-supplied headers.
+      MAX_CACHE_SIZE = 256
+
+      # The "stream" argument: what the app gets to know about the request
+      # stream besides its headers and body.
+      class Stream
+        attr_reader :headers, :transport_context, :remote_address, :early_data
+        attr_accessor :body, :interim_response
+
+        def initialize(headers, body, remote_address, transport_context, early_data)
+          @headers = headers
+          @body = body
+          @remote_address = remote_address
+          @transport_context = transport_context
+          @early_data = early_data
+          @interim_response = nil
+        end
+
+        def header(name)
+          i = 0
+          while i < @headers.size
+            return @headers[i + 1] if @headers[i] == name
+            i += 2
+          end
+          nil
+        end
+
+        def method
+          header(":method")
+        end
+
+        def path
+          header(":path")
+        end
+
+        def head?
+          method == "HEAD"
+        end
+
+        def stream_id
+          @transport_context&.dig("connection", "stream_id")
+        end
+
+        def deadline
+          @transport_context&.[]("deadline")
+        end
+
+        def cancelled?
+          !!@transport_context&.[]("cancellation")&.cancelled?
+        end
+
+        # Server push (Server::ServerPush): path and a flat header array.
+        # Returns the push ID, nil if not pushed.
+        def push(path, headers = nil)
+          @transport_context&.[]("push")&.push(path, headers&.each_slice(2))
+        end
+
+        # 1xx response (e.g. 103 Early Hints) before the final one.
+        def send_interim_response(status, headers)
+          @interim_response&.call(status, headers.each_slice(2).to_a)
+        end
+      end
+
+      def initialize(app, encoder: Protocol::Qpack::Encoder.new)
+        @app = app
+        @header_arrays = {} # parsed headers hash => flat frozen array
+        @header_frames = {} # response header array => { status => HEADERS frame }
+        @encoder = encoder
+        @mutex = Mutex.new
+      end
+
+      # Same contract as Protocol::Adapter#build_request.
+      def build_request(headers, remote_address: nil, remote_port: 0, transport_context: nil, rack_context: nil, early_data: nil)
+        body = unless BODYLESS_METHODS.include?(headers[":method"])
+          Protocol::StreamInput.new(headers["content-length"]&.to_i)
+        end
+
+        [Stream.new(flat_headers(headers), body, remote_address, transport_context, early_data), body]
+      end
+
+      # Returns the app's [status, header_array, body] as is.
+      def call(stream)
+        @app.call(stream, stream.headers, stream.body)
+      end
+
+      def response_parts(response)
+        status, headers, body = response
+        [status, headers.each_slice(2).to_a, body ? [body] : [], nil]
+      end
+
+      # The whole response as one HEADERS (+ DATA) buffer.
+      def encode_response(response, head_request: false)
+        status, headers, body = response
+        frame = headers_frame(status, headers)
+        return frame if head_request || body.nil? || body.empty?
+
+        body = body.b unless body.encoding == Encoding::BINARY || body.ascii_only?
+        String.new(frame, capacity: frame.bytesize + body.bytesize + 16)
+          .concat(Protocol.encode_varint(Protocol::FRAME_DATA), Protocol.encode_varint(body.bytesize), body)
+      end
+
+      private
+
+      def flat_headers(headers)
+        @header_arrays[headers] || begin
+          flat = headers.to_a
+          flat.flatten!(1)
+          flat.freeze
+          @mutex.synchronize do
+            @header_arrays[headers.frozen? ? headers : headers.dup.freeze] = flat if @header_arrays.size < MAX_CACHE_SIZE
+          end
+          flat
+        end
+      end
+
+      def headers_frame(status, headers)
+        frames = @header_frames[headers]
+        frame = frames && frames[status]
+        return frame if frame
+
+        @mutex.synchronize do
+          pairs = [[":status", status.to_s]]
+          headers.each_slice(2) { |name, value| pairs << [name, value.to_s] }
+          frame = Protocol.build_headers_frame(pairs, encoder: @encoder).freeze
+
+          if frames
+            frames[status] = frame if frames.size < MAX_CACHE_SIZE
+          elsif @header_frames.size < MAX_CACHE_SIZE
+            @header_frames[headers.frozen? ? headers : headers.dup.freeze] = { status => frame }
+          end
+        end
+        frame
+      end
+    end
+  end
+end
@@ -0,0 +1,78 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  class Server
+    # Works out each request's deadline and keeps the queue-time numbers
+    # reported in Server#stats. Times are CLOCK_MONOTONIC seconds.
+    #
+    # A request's budget is the server's request_deadline_ms, or the
+    # client's request_deadline_header value if that is shorter (or the
+    # server has none). Workers check it when they take the request off the
+    # queue: an expired request gets a 503 and the app never sees it.
+    class RequestDeadlines
+      attr_reader :default_ms, :header
+
+      def initialize(default_ms: nil, header: nil)
+        @default_ms = default_ms
+        @header = header
+        @mutex = Mutex.new
+        @dequeued = 0
+        @expired = 0
+        @queue_time_total = 0.0
+        @queue_time_max = 0.0
+      end
+
+      def self.now
+        Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      end
+
+      # @param headers [Hash] parsed request headers (lowercase names)
+      # @return [Float, nil] absolute deadline, nil when there is no budget
+      def deadline_for(arrived_at, headers)
+        budget_ms = [@default_ms, requested_ms(headers)].compact.min
+        arrived_at + budget_ms / 1000.0 if budget_ms
+      end
+
+      # Record how long a request waited for a worker. Returns the wait.
+      def dequeued(arrived_at, now = self.class.now)
+        queue_time = now - arrived_at
+        @mutex.synchronize do
+          @dequeued += 1
+          @queue_time_total += queue_time
+          @queue_time_max = queue_time if queue_time > @queue_time_max
+        end
+        queue_time
+      end
+
+      def expired?(deadline, now = self.class.now)
+        !deadline.nil? && now >= deadline
+      end
+
+      def expired!
+        @mutex.synchronize { @expired += 1 }
+      end
+
+      def to_h
+        @mutex.synchronize do
+          {
+            "dequeued" => @dequeued,
+            "expired" => @expired,
+            "avg_ms" => @dequeued.zero? ? 0.0 : (@queue_time_total / @dequeued * 1000).round(3),
+            "max_ms" => (@queue_time_max * 1000).round(3)
+          }
+        end
+      end
+
+      private
+
+      def requested_ms(headers)
+        return unless @header && (value = headers[@header])
+
+        ms = Integer(value.to_s.strip, 10)
+        ms if ms.positive?
+      rescue ArgumentError
+        nil
+      end
+    end
+  end
+end
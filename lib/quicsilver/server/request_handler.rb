@@ -7,15 +7,30 @@ module Quicsilver
 
       attr_reader :adapter
 
-      def initialize(app:, configuration:, request_registry:, cancelled_streams:, cancelled_mutex:)
+      def initialize(configuration:, request_registry:, cancelled_streams:, cancelled_mutex:, app: nil, adapter: nil, cancellations: {}, deadlines: nil, server_push: nil)
         @configuration = configuration
         @request_registry = request_registry
         @cancelled_streams = cancelled_streams
         @cancelled_mutex = cancelled_mutex
-        @adapter = Protocol::Adapter.new(app)
+        @cancellations = cancellations
+        @deadlines = deadlines || RequestDeadlines.new(
+          default_ms: configuration.request_deadline_ms,
+          header: configuration.request_deadline_header
+        )
+        # ServerPush, when the max_pushes_per_request option is set
+        @server_push = server_push
+        # Protocol::Adapter for :rack/:falcon, RackEnvAdapter for :rack_direct,
+        # RawAdapter for :raw
+        @adapter = adapter || Protocol::Adapter.new(app)
       end
 
       def call(connection, stream, early_data: false)
+        # Reset while still queued: don't spend a worker on it
+        if cancelled?(connection, stream)
+          Quicsilver.logger.debug("Dropping queued request for cancelled stream #{stream.stream_id}")
+          return
+        end
+
         request = parse_request(connection, stream, early_data: early_data)
         return unless request
 
@@ -24,6 +39,8 @@ module Quicsilver
         send_response(connection, stream, request, response)
       rescue Server::DrainTimeoutError
         Quicsilver.logger.debug("Request interrupted by drain: stream #{stream.stream_id}")
+      rescue CancelledError
+        Quicsilver.logger.debug("Request abandoned after cancellation: stream #{stream.stream_id}")
       rescue Protocol::FrameError => e
         Quicsilver.logger.error("Frame error: #{e.message} (0x#{e.error_code.to_s(16)})")
         Quicsilver.connection_shutdown(connection.handle, e.error_code, false) rescue nil
@@ -35,13 +52,82 @@ module Quicsilver
         Quicsilver.logger.debug(e.backtrace.first(5).join("\n"))
         connection.send_error(stream, 500, "Internal Server Error") if stream.writable?
       ensure
-        @request_registry.complete(stream.stream_id, connection&.handle) if @request_registry.include?(stream.stream_id, connection&.handle)
-        @cancelled_mutex.synchronize { @cancelled_streams.delete(stream.stream_id) }
-        connection.remove_stream(stream.stream_id) if connection
+        stream.cache_fill&.release
+        stream.body_spool&.close
+        unless revalidation?(stream)
+          @request_registry.complete(stream.stream_id, connection&.handle) if @request_registry.include?(stream.stream_id, connection&.handle)
+          @cancelled_mutex.synchronize do
+            @cancelled_streams.delete([connection&.handle, stream.stream_id])
+            @cancellations.delete([connection&.handle, stream.stream_id])
+          end
+          connection.remove_stream(stream.stream_id) if connection
+        end
+      end
+
+      # Send the app's response on stream. Also used by the server for
+      # streaming requests.
+      def respond(connection, stream, request, response)
+        return if stream.cache_fill && respond_cacheable(connection, stream, response)
+
+        # Raw mode hands back the whole response pre-encoded
+        if @adapter.respond_to?(:encode_response)
+          connection.send_encoded_response(stream, @adapter.encode_response(response, head_request: request.head?))
+          return
+        end
+
+        status, headers, body, trailers = @adapter.response_parts(response)
+
+        if body.is_a?(AsyncBody)
+          connection.send_async_response(stream, status, headers, body, head_request: request.head?)
+        else
+          connection.send_response(stream, status, headers, body || [],
+            head_request: request.head?, trailers: trailers, accept_encoding: accept_encoding(request))
+        end
       end
 
       private
 
+      # For a request filling the response cache: if the response may be
+      # stored, encode it once, store it for the requests waiting on the
+      # fill and send the same bytes. Background revalidations have no
+      # stream handle and only store. Returns false to send it normally.
+      def respond_cacheable(connection, stream, response)
+        status, headers, body, trailers = @adapter.response_parts(response)
+        policy = ResponseCache.policy(status, headers) unless trailers&.any?
+        chunks = cacheable_chunks(body) if policy
+
+        if chunks
+          bytes, headers_size = if @adapter.respond_to?(:encode_response)
+            [@adapter.encode_response(response), @adapter.encode_response(response, head_request: true).bytesize]
+          else
+            connection.encode_response(status, headers, chunks)
+          end
+          stream.cache_fill.complete(bytes, headers_size, policy)
+          connection.send_encoded_response(stream, bytes) if stream.writable?
+        elsif stream.writable?
+          return false
+        end
+
+        body.close if body.respond_to?(:close)
+        true
+      end
+
+      # Bodies already complete in memory; anything else streams past the cache.
+      def cacheable_chunks(body)
+        if body.nil?
+          []
+        elsif body.respond_to?(:to_ary)
+          body.to_ary
+        elsif body.is_a?(::Protocol::HTTP::Body::Buffered)
+          body.chunks
+        end
+      end
+
+      def accept_encoding(request)
+        value = request.headers["accept-encoding"]
+        value.is_a?(Array) ? value.join(",") : value
+      end
+
       def parse_request(connection, stream, early_data: false)
         parser = Protocol::RequestParser.new(
           stream.data,
@@ -67,13 +153,32 @@ module Quicsilver
           return
         end
 
+        if stream.arrived_at
+          queue_time = @deadlines.dequeued(stream.arrived_at)
+          deadline = @deadlines.deadline_for(stream.arrived_at, headers)
+          if @deadlines.expired?(deadline)
+            @deadlines.expired!
+            Quicsilver.logger.debug("Shedding stream #{stream.stream_id}: deadline passed after #{(queue_time * 1000).round}ms in queue")
+            connection.send_error(stream, 503, "Service Unavailable") if stream.writable?
+            return
+          end
+        end
+
+        transport_context = connection.request_context(stream_id: stream.stream_id)
+        transport_context["cancellation"] = stream.cancellation if stream.cancellation
+        transport_context["deadline"] = deadline if deadline
+        transport_context["queue_time"] = queue_time if queue_time
+        if @server_push && (pusher = @server_push.pusher(connection, stream, headers))
+          transport_context["push"] = pusher
+        end
+
         request, body = @adapter.build_request(
           headers,
           remote_address: connection.remote_address,
           remote_port: connection.remote_port,
-          transport_context: connection.request_context(stream_id: stream.stream_id)
+          transport_context: transport_context,
+          early_data: early_data
         )
-        request.headers.add("quicsilver-early-data", early_data.to_s)
 
         # Wire interim_response so apps can send 103 Early Hints.
         # Falcon mode: app calls request.send_interim_response(103, headers)
@@ -82,63 +187,63 @@ module Quicsilver
           connection.send_informational(stream, status, headers)
         }
 
-        if body && parser.body && parser.body.size > 0
-          parser.body.rewind
-          body_data = parser.body.read
-          body.write(body_data) unless body_data.empty?
+        if body && stream.body_spool
+          # Large buffered body already on disk — hand the app the file
+          # rather than copying it back through memory.
+          body.close
+          request.body = stream.body_spool.to_input(headers["content-length"]&.to_i)
+        else
+          if body && parser.body && parser.body.size > 0
+            parser.body.rewind
+            body_data = parser.body.read
+            body.write(body_data) unless body_data.empty?
+          end
+          body&.close_write
         end
-        body&.close_write
 
         connection.apply_stream_priority(stream, parser.priority)
 
-        @request_registry.track(
-          stream.stream_id, connection.handle,
-          path: headers[":path"] || "/", method: method || "GET"
-        )
+        unless revalidation?(stream)
+          @request_registry.track(
+            stream.stream_id, connection.handle,
+            path: headers[":path"] || "/", method: method || "GET"
+          )
+        end
 
         request
       end
 
       def send_response(connection, stream, request, response)
-        if cancelled_stream?(stream.stream_id)
+        if cancelled?(connection, stream)
           Quicsilver.logger.debug("Skipping response for cancelled stream #{stream.stream_id}")
           return
         end
 
-        raise "Stream handle not found for stream #{stream.stream_id}" unless stream.writable?
-
-        headers = response.headers
-
-        # Extract trailers before flattening (Protocol::HTTP::Headers tracks
-        # trailer! state that a plain Hash would lose — needed for gRPC).
-        trailers = if headers.respond_to?(:trailer?) && headers.trailer?
-          trailer_hash = {}
-          headers.trailer.each { |name, value| trailer_hash[name] = value }
-          trailer_hash
+        # A background revalidation (cache_fill, no handle) only stores
+        unless stream.writable? || stream.cache_fill
+          raise "Stream handle not found for stream #{stream.stream_id}"
         end
 
-        response_headers = {}
-        if headers.respond_to?(:header)
-          headers.header.each { |name, value| response_headers[name] = value }
-        else
-          headers&.each { |name, value| response_headers[name] = value }
-        end
+        respond(connection, stream, request, response)
+        return if revalidation?(stream)
 
-        # Protocol-rack moves content-length from headers to body.length —
-        # re-add it so the HTTP/3 response includes the header.
-        if !response_headers.key?("content-length") && response.body&.length
-          response_headers["content-length"] = response.body.length.to_s
-        end
-
-        body = response.body || []
-        connection.send_response(stream, response.status, response_headers, body,
-          head_request: request.head?, trailers: trailers)
         @request_registry.complete(stream.stream_id, connection.handle)
         connection.remove_stream(stream.stream_id)
       end
 
-      def cancelled_stream?(stream_id)
-        @cancelled_mutex.synchronize { @cancelled_streams.include?(stream_id) }
+      def cancelled?(connection, stream)
+        return true if stream.cancellation&.cancelled?
+        return false if revalidation?(stream)
+
+        @cancelled_mutex.synchronize { @cancelled_streams.include?([connection&.handle, stream.stream_id]) }
+      end
+
+      # A background revalidation (cache_fill, no handle) runs under the
+      # stream ID of the request that found the entry stale, which may still
+      # be in flight: the registry entry, cancellation and stream are that
+      # request's to clean up.
+      def revalidation?(stream)
+        stream.cache_fill && !stream.writable?
       end
     end
   end
@@ -0,0 +1,250 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  class Server
+    # Opt-in micro-cache of whole encoded responses (HEADERS + DATA frames)
+    # for GET endpoints, enabled with the response_cache_size option.
+    #
+    # Responses are stored when their Cache-Control allows a shared cache
+    # to (s-maxage, else max-age; no private, no-store or no-cache) and they
+    # carry no Set-Cookie or Vary. Hits are sent from the connection's
+    # callback without going through the scheduler; HEAD is answered from
+    # the GET entry. Within stale-while-revalidate a stale entry is still
+    # sent, and one request runs the app again in the background.
+    #
+    # Concurrent misses for a key are collapsed: the first runs the app (a
+    # Fill), the rest wait for it and get its bytes. If the response turns
+    # out not to be cacheable they all run the app, and the key is passed
+    # straight through for PASS_SECONDS so an uncacheable endpoint isn't
+    # serialized behind its own fills.
+    #
+    # Entries are keyed on authority and path only, are not sent with an
+    # Age header, and are evicted least recently used past max_size bytes.
+    class ResponseCache
+      # RFC 9110 §15.1 (206 Partial Content aside)
+      CACHEABLE_STATUSES = [200, 203, 204, 300, 301, 308, 404, 405, 410, 414, 501].freeze
+
+      PASS_SECONDS = 10
+      MAX_PASS_KEYS = 1024
+
+      Entry = Struct.new(:bytes, :headers_size, :fresh_until, :stale_until, :size) do
+        def fresh?(now = RequestDeadlines.now)
+          now < fresh_until
+        end
+
+        # What to send: the whole response, or just its HEADERS for HEAD.
+        def response(head: false)
+          head ? bytes.byteslice(0, headers_size) : bytes
+        end
+      end
+
+      # One app call filling a key. Finished exactly once: #complete with
+      # the encoded response, or #release if it couldn't be cached.
+      class Fill
+        attr_reader :key, :waiters
+
+        def initialize(cache, key)
+          @cache = cache
+          @key = key
+          @waiters = []
+          @done = false
+        end
+
+        # Store the response and hand it to the waiting requests. Returns
+        # the entry, nil if it was too large to keep.
+        def complete(bytes, headers_size, policy)
+          return if @done
+
+          @done = true
+          entry = @cache.store(@key, bytes, headers_size, policy)
+          @cache.finish(self, entry)
+          entry
+        end
+
+        def release
+          return if @done
+
+          @done = true
+          @cache.finish(self, nil)
+        end
+      end
+
+      attr_reader :max_size, :max_entry_size
+
+      def initialize(max_size:, max_entry_size: nil)
+        @max_size = max_size
+        @max_entry_size = max_entry_size || [max_size / 8, 1].max
+        @entries = {} # key => Entry, least recently used first
+        @fills = {}   # key => Fill in progress
+        @passes = {}  # key => time until which it bypasses collapsing
+        @size = 0
+        @mutex = Mutex.new
+        @hits = 0
+        @stale = 0
+        @misses = 0
+        @collapsed = 0
+      end
+
+      # Freshness a response's headers allow: [ttl, stale_while_revalidate]
+      # in seconds, or nil if it must not be cached.
+      def self.policy(status, headers)
+        return unless CACHEABLE_STATUSES.include?(status.to_i)
+
+        cache_control = nil
+        headers&.each do |name, value|
+          case name.to_s.downcase
+          when "cache-control"
+            cache_control = cache_control ? "#{cache_control},#{Array(value).join(",")}" : Array(value).join(",")
+          when "set-cookie", "vary"
+            return
+          end
+        end
+        return unless cache_control
+
+        max_age = s_maxage = nil
+        stale_while_revalidate = 0
+        cache_control.split(/[,\n]/).each do |directive|
+          name, value = directive.strip.downcase.split("=", 2)
+          case name
+          when "no-store", "no-cache", "private" then return
+          when "s-maxage" then s_maxage = seconds(value)
+          when "max-age" then max_age = seconds(value)
+          when "stale-while-revalidate" then stale_while_revalidate = seconds(value) || 0
+          end
+        end
+
+        ttl = s_maxage || max_age
+        [ttl, stale_while_revalidate] if ttl&.positive?
+      end
+
+      def self.seconds(value)
+        Integer(value.to_s.delete('"'), 10)
+      rescue ArgumentError
+        nil
+      end
+      private_class_method :seconds
+
+      # Cache key for a request that may be answered from the cache, nil
+      # for one that must reach the app (RFC 9111 §3.5, §5.2.1.4).
+      def key(headers)
+        method = headers[":method"]
+        return unless method == "GET" || method == "HEAD"
+        return if headers["authorization"]
+        return if (cache_control = headers["cache-control"]) && cache_control.match?(/no-cache|no-store/i)
+
+        "#{headers[":authority"]}#{headers[":path"]}"
+      end
+
+      # The entry to send for key — fresh, or stale within its
+      # stale-while-revalidate window — or nil.
+      def lookup(key, now = RequestDeadlines.now)
+        @mutex.synchronize do
+          entry = @entries.delete(key)
+          if entry.nil? || now >= entry.stale_until
+            @size -= entry.size if entry
+            @misses += 1
+            return
+          end
+
+          @entries[key] = entry
+          entry.fresh?(now) ? @hits += 1 : @stale += 1
+          entry
+        end
+      end
+
+      # Start filling key. Returns the Fill, or nil if one is already in
+      # progress — then waiter (if given) is called with its entry, or with
+      # nil if the response couldn't be cached.
+      def begin_fill(key, &waiter)
+        @mutex.synchronize do
+          if (fill = @fills[key])
+            if waiter
+              fill.waiters << waiter
+              @collapsed += 1
+            end
+            return
+          end
+
+          @fills[key] = Fill.new(self, key)
+        end
+      end
+
+      # Stop waiting on key's fill (the request went away). Returns false
+      # if the fill already finished and waiter has run or is about to.
+      def cancel_wait(key, waiter)
+        @mutex.synchronize do
+          waiters = @fills[key]&.waiters
+          !!waiters&.delete(waiter)
+        end
+      end
+
+      # True while key is known to be uncacheable.
+      def pass?(key, now = RequestDeadlines.now)
+        @mutex.synchronize do
+          pass_until = @passes[key]
+          return false unless pass_until
+          return true if now < pass_until
+
+          @passes.delete(key)
+          false
+        end
+      end
+
+      def store(key, bytes, headers_size, policy, now = RequestDeadlines.now)
+        size = key.bytesize + bytes.bytesize
+        return if size > @max_entry_size
+
+        ttl, stale_while_revalidate = policy
+        entry = Entry.new(bytes.frozen? ? bytes : bytes.dup.freeze, headers_size,
+          now + ttl, now + ttl + stale_while_revalidate, size)
+
+        @mutex.synchronize do
+          if (old = @entries.delete(key))
+            @size -= old.size
+          end
+          @entries[key] = entry
+          @size += size
+          while @size > @max_size
+            _key, evicted = @entries.shift
+            @size -= evicted.size
+          end
+        end
+        entry
+      end
+
+      # Called by Fill: stop collapsing on key and serve its waiters.
+      def finish(fill, entry, now = RequestDeadlines.now)
+        waiters = @mutex.synchronize do
+          @fills.delete(fill.key) if @fills[fill.key].equal?(fill)
+          unless entry
+            @passes.delete(fill.key)
+            @passes[fill.key] = now + PASS_SECONDS
+            @passes.shift while @passes.size > MAX_PASS_KEYS
+          end
+          fill.waiters.dup.tap { fill.waiters.clear }
+        end
+
+        waiters.each do |waiter|
+          waiter.call(entry)
+        rescue => e
+          Quicsilver.logger.error("Response cache waiter failed: #{e.class} - #{e.message}")
+        end
+      end
+
+      def to_h
+        @mutex.synchronize do
+          {
+            "entries" => @entries.size,
+            "bytes" => @size,
+            "max_bytes" => @max_size,
+            "hits" => @hits,
+            "stale" => @stale,
+            "misses" => @misses,
+            "collapsed" => @collapsed,
+            "filling" => @fills.size
+          }
+        end
+      end
+    end
+  end
+end
@@ -26,6 +26,12 @@ module Quicsilver
         raise NotImplementedError
       end
 
+      # Would a request's work unit be taken now? Schedulers that queue
+      # per client can refuse one client while still taking another's.
+      def admit?(work)
+        !full?
+      end
+
       # Number of pending work units.
       def pending
         raise NotImplementedError
@@ -45,6 +51,16 @@ module Quicsilver
       def stop
         raise NotImplementedError
       end
+
+      # Live workers, for stats. nil when the scheduler doesn't track them.
+      def workers
+        nil
+      end
+
+      # Connections with queued work, for stats. nil when not tracked.
+      def queues
+        nil
+      end
     end
   end
 end
@@ -0,0 +1,101 @@
+# frozen_string_literal: true
+
+require_relative "../scheduler"
+
+module Quicsilver
+  class Server
+    module Schedulers
+      # Runs each request as a fiber on the event-loop thread, with the
+      # MsQuic poll loop itself driven by a Fiber::Scheduler. No worker
+      # threads and no cross-thread handoff: a request that waits on I/O
+      # (a database socket, an HTTP call, send backpressure) yields back to
+      # polling and to the other requests.
+      #
+      #   Server.new(4433, app: app, scheduler: Schedulers::EventLoopScheduler,
+      #     threads: 200)  # concurrent request fibers
+      #
+      # Needs a fiber-aware app: CPU-bound work, or a C extension blocking
+      # without the scheduler's hooks, stalls every connection. Uses the
+      # async gem's scheduler unless FIBER_SCHEDULER is replaced with another
+      # factory.
+      class EventLoopScheduler < Scheduler
+        FIBER_SCHEDULER = -> {
+          require "async"
+          Async::Scheduler.new
+        }
+
+        def initialize(concurrency:, max_queue_size:, event_loop: nil, fiber_scheduler: FIBER_SCHEDULER, &handler)
+          @concurrency = concurrency
+          @max_queue_size = max_queue_size
+          @event_loop = event_loop
+          @fiber_scheduler = fiber_scheduler
+          @handler = handler
+          @queue = []   # waiting for a free slot
+          @active = 0   # request fibers running
+        end
+
+        # Called from MsQuic callbacks on the loop thread.
+        def enqueue(work)
+          @queue << work
+          fill
+        end
+
+        def full?
+          @queue.size >= @max_queue_size
+        end
+
+        def pending
+          @queue.size
+        end
+
+        def workers
+          @active
+        end
+
+        def start
+          event_loop.start(fiber_scheduler: @fiber_scheduler)
+          fill
+        end
+
+        def drain(timeout: 5)
+          deadline = Time.now + timeout
+          while @queue.size > 0 && Time.now < deadline
+            sleep 0.05
+          end
+        end
+
+        # Lets running and queued requests finish (up to 2s).
+        def stop
+          deadline = Time.now + 2
+          sleep 0.01 while (@active > 0 || !@queue.empty?) && Time.now < deadline
+        end
+
+        private
+
+        def event_loop
+          @event_loop ||= Quicsilver.event_loop
+        end
+
+        def fill
+          return unless event_loop.fiber_scheduler?
+
+          while @active < @concurrency && !@queue.empty?
+            @active += 1
+            spawn(@queue.shift)
+          end
+        end
+
+        def spawn(work)
+          event_loop.spawn { run(work) }
+        end
+
+        def run(work)
+          @handler.call(work)
+        ensure
+          @active -= 1
+          fill
+        end
+      end
+    end
+  end
+end
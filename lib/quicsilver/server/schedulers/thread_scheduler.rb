@@ -5,56 +5,229 @@ require_relative "../scheduler"
 module Quicsilver
   class Server
     module Schedulers
-      # Thread-based scheduler — uses a thread pool with Thread::Queue.
+      # Thread-based scheduler — a thread pool fed from a FIFO queue.
+      #
+      # With a fair_key the queue is split per key (the server uses the
+      # connection) and workers take from the sub-queues in weighted round
+      # robin: up to weight.call(key) items (default 1) from one before
+      # moving to the next. A client with a hundred queued streams then
+      # delays others by a round, not by a hundred requests. Admission is
+      # fair too: a key may hold an even share of max_queue_size (at least
+      # one place), and while the queue is full only a key with nothing
+      # queued gets in, so the queue runs over by at most one per key.
+      #
+      # With min_concurrency below concurrency the pool autoscales: a
+      # supervisor adds workers (up to concurrency) once the oldest queued
+      # request has waited scale_up_wait seconds with no idle worker to take
+      # it, and workers above the minimum exit after idle_timeout seconds
+      # without work. Without it the pool is fixed at concurrency threads.
       class ThreadScheduler < Scheduler
-        def initialize(concurrency:, max_queue_size:, &handler)
-          @size = concurrency
+        DEFAULT_SCALE_UP_WAIT = 0.01 # 10ms
+        DEFAULT_IDLE_TIMEOUT = 60    # seconds
+
+        attr_reader :min_concurrency, :max_concurrency
+
+        def initialize(concurrency:, max_queue_size:, min_concurrency: nil,
+                       scale_up_wait: DEFAULT_SCALE_UP_WAIT, idle_timeout: DEFAULT_IDLE_TIMEOUT,
+                       fair_key: nil, weight: nil, &handler)
+          @max_concurrency = concurrency
+          @min_concurrency = (min_concurrency || concurrency).clamp(1, concurrency)
           @max_queue_size = max_queue_size
+          @scale_up_wait = scale_up_wait
+          @idle_timeout = idle_timeout
           @handler = handler
-          @queue = Queue.new
+          @fair_key = fair_key
+          @weight = weight
+          @queues = {}           # key => [[work, enqueued_at], ...]
+          @ring = []             # keys with queued work, in service order
+          @weights = {}          # key => weight, while the key is queued
+          @served = 0            # taken from @ring.first this turn
+          @size = 0
           @threads = []
+          @idle = 0              # workers waiting for work
+          @running = false
           @mutex = Mutex.new
+          @available = ConditionVariable.new
+          @tick = ConditionVariable.new
+          @supervisor = nil
         end
 
         def enqueue(work)
-          @queue.push(work)
+          key = @fair_key&.call(work)
+          # The weight is app code: never run it under the lock
+          weight = @weight ? [@weight.call(key).to_i, 1].max : 1
+          @mutex.synchronize do
+            unless (queue = @queues[key])
+              queue = @queues[key] = []
+              @ring << key
+              @weights[key] = weight
+            end
+            queue << [work, now]
+            @size += 1
+            @available.signal
+            grow if @running
+          end
         end
 
         def full?
-          @queue.size >= @max_queue_size
+          @size >= @max_queue_size
+        end
+
+        def admit?(work)
+          return !full? unless @fair_key
+
+          key = @fair_key.call(work)
+          @mutex.synchronize do
+            queued = @queues[key]&.size || 0
+            return queued.zero? if @size >= @max_queue_size
+
+            keys = @queues.size + (queued.zero? ? 1 : 0)
+            queued < [@max_queue_size / keys, 1].max
+          end
         end
 
         def pending
-          @queue.size
+          @size
+        end
+
+        # Keys (connections) with queued work.
+        def queues
+          @queues.size
+        end
+
+        def workers
+          @threads.size
+        end
+
+        def idle_workers
+          @idle
+        end
+
+        def autoscaling?
+          @min_concurrency < @max_concurrency
         end
 
         def start
-          @size.times do
-            thread = Thread.new do
-              while (work = @queue.pop)
-                break if work == :shutdown
-                @handler.call(work)
-              end
-            end
-            @mutex.synchronize { @threads << thread }
+          @mutex.synchronize do
+            @running = true
+            @min_concurrency.times { spawn_worker }
+          end
+          if autoscaling?
+            @supervisor = Thread.new { supervise }
+            @supervisor.name = "quicsilver-scheduler"
           end
         end
 
         def drain(timeout: 5)
           deadline = Time.now + timeout
-          while @queue.size > 0 && Time.now < deadline
+          while @size > 0 && Time.now < deadline
             sleep 0.05
           end
         end
 
+        # Workers finish what is already queued, then exit.
         def stop
-          @size.times { @queue.push(:shutdown) }
+          threads = @mutex.synchronize do
+            @running = false
+            @available.broadcast
+            @tick.broadcast
+            @threads.dup
+          end
+          @supervisor&.join(2)
+          @supervisor = nil
+          threads.each { |t| t.join(2) }
+          threads.each { |t| t.raise(DrainTimeoutError, "drain timeout") if t.alive? }
+          @mutex.synchronize { @threads.clear }
+        end
+
+        private
+
+        def run_worker
+          while (work = next_work)
+            @handler.call(work)
+          end
+        ensure
+          @mutex.synchronize { @threads.delete(Thread.current) }
+        end
+
+        # Next work unit, or nil once this worker should exit: the
+        # scheduler stopped with nothing left to do, or it was idle for
+        # idle_timeout while the pool is above its minimum.
+        def next_work
+          @mutex.synchronize do
+            idle_since = now
+            while @size.zero?
+              return nil unless @running
+              if @threads.size > @min_concurrency && now - idle_since >= @idle_timeout
+                @threads.delete(Thread.current) # before releasing the lock, so two can't both leave
+                return nil
+              end
+
+              @idle += 1
+              begin
+                @available.wait(@mutex, autoscaling? ? @idle_timeout : nil)
+              ensure
+                @idle -= 1
+              end
+            end
+            shift
+          end
+        end
+
+        # Called with the mutex held and work queued.
+        def shift
+          key = @ring.first
+          queue = @queues[key]
+          work, = queue.shift
+          @size -= 1
+          @served += 1
+
+          if queue.empty?
+            @queues.delete(key)
+            @weights.delete(key)
+            @ring.shift
+            @served = 0
+          elsif @served >= @weights[key]
+            @ring.rotate!
+            @served = 0
+          end
+          work
+        end
+
+        def supervise
           @mutex.synchronize do
-            @threads.each { |t| t.join(2) }
-            @threads.each { |t| t.raise(DrainTimeoutError, "drain timeout") if t.alive? }
-            @threads.clear
+            while @running
+              @tick.wait(@mutex, @scale_up_wait)
+              grow if @running
+            end
           end
         end
+
+        # Called with the mutex held. Adds a worker per queued request that
+        # no idle worker will pick up, once the oldest has waited long
+        # enough (immediately if the pool is somehow empty).
+        def grow
+          spare = @max_concurrency - @threads.size
+          backlog = @size - @idle
+          return if spare <= 0 || backlog <= 0
+          return unless @threads.empty? || now - oldest_enqueued_at >= @scale_up_wait
+
+          [spare, backlog].min.times { spawn_worker }
+        end
+
+        def oldest_enqueued_at
+          @queues.each_value.map { |queue| queue.first[1] }.min
+        end
+
+        def spawn_worker
+          thread = Thread.new { run_worker }
+          thread.name = "quicsilver-worker"
+          @threads << thread
+        end
+
+        def now
+          Process.clock_gettime(Process::CLOCK_MONOTONIC)
+        end
       end
     end
   end
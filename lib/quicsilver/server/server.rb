@@ -2,6 +2,7 @@
 
 require_relative "scheduler"
 require_relative "schedulers/thread_scheduler"
+require_relative "schedulers/event_loop_scheduler"
 require_relative "web_transport_session"
 require_relative "web_transport_stream"
 
@@ -27,22 +28,38 @@ module Quicsilver
     DrainTimeoutError = Class.new(Quicsilver::Error)
 
     # Tracks an in-flight streaming request between RECEIVE and RECEIVE_FIN.
-    # The stream handle arrives at RECEIVE_FIN; the worker thread waits for it.
-    PendingStream = Struct.new(:connection, :body, :request, :stream_id, :stream_handle, :handle_ready, :frame_buffer, :priority, keyword_init: true) do
+    # The stream handle arrives with the first RECEIVE, so the response is
+    # writable while the request body is still uploading (full duplex).
+    # Once the response is done, any remaining body is discarded.
+    PendingStream = Struct.new(:connection, :body, :request, :stream_id, :stream_handle, :handle_ready, :frame_buffer, :priority,
+      :fin_received, :discarding, :cancellation, :arrived_at, :deadline, :cache_fill, keyword_init: true) do
       def initialize(**)
         super
         self.handle_ready = Queue.new
-        self.frame_buffer = "".b
+        self.frame_buffer = Protocol::ChunkBuffer.new
+        self.fin_received = false
+        self.discarding = false
+        handle_ready.push(true) if stream_handle
       end
 
-      # Called by RECEIVE_FIN handler to provide the stream handle
+      # Stream IDs repeat across connections, so pending streams are
+      # tracked per connection.
+      def key
+        [connection.handle, stream_id]
+      end
+
+      # Called by RECEIVE_FIN handler. The FIN event's handle replaces the one
+      # from the first RECEIVE (they're the same stream; nil means keep ours).
       def complete(handle)
-        self.stream_handle = handle
+        self.stream_handle = handle if handle
+        self.fin_received = true
         handle_ready.push(true)
       end
 
-      # Called by worker thread to wait for the stream handle
+      # Called by worker thread when the first RECEIVE carried no handle
       def wait_for_handle(timeout: 30)
+        return stream_handle if stream_handle
+
         handle_ready.pop(timeout: timeout)
         stream_handle
       end
@@ -73,7 +90,7 @@ module Quicsilver
     # If you need IPv6, either:
     #   1. Add "::1 your-hostname" to /etc/hosts, OR
     #   2. Run two server instances (one IPv4, one IPv6) like Caddy/ngtcp2
-    def initialize(port = 4433, address: "0.0.0.0", app: nil, server_configuration: nil, threads: DEFAULT_THREAD_POOL_SIZE, max_queue_size: nil, max_connections: DEFAULT_MAX_CONNECTIONS, scheduler: nil)
+    def initialize(port = 4433, address: "0.0.0.0", app: nil, server_configuration: nil, threads: DEFAULT_THREAD_POOL_SIZE, min_threads: nil, thread_idle_timeout: nil, thread_scale_up_wait: nil, fair_queuing: true, connection_weight: nil, max_queue_size: nil, max_connections: DEFAULT_MAX_CONNECTIONS, scheduler: nil)
       @port = port
       @address = address
       @app = app || default_rack_app
@@ -85,12 +102,28 @@ module Quicsilver
       @connections = {}
       @request_registry = RequestRegistry.new
       @thread_pool_size = threads
+      # min_threads below threads makes the pool autoscale between the two
+      @min_threads = min_threads || threads
+      unless @min_threads.is_a?(Integer) && @min_threads.between?(1, threads)
+        raise ServerConfigurationError, "min_threads must be an integer between 1 and threads (#{threads})"
+      end
+      @thread_idle_timeout = thread_idle_timeout
+      @thread_scale_up_wait = thread_scale_up_wait
+      # Queued work is served round robin per connection; connection_weight
+      # (->(connection) { Integer }) lets some clients take more turns.
+      @fair_queuing = fair_queuing
+      @connection_weight = connection_weight
       @max_queue_size = max_queue_size || threads * DEFAULT_QUEUE_MULTIPLIER
       @scheduler = build_scheduler(scheduler)
       @max_connections = max_connections
-      @cancelled_streams = Set.new
+      @cancelled_streams = Set.new  # [connection_handle, stream_id] reset by the peer
       @cancelled_mutex = Mutex.new
-      @pending_streams = {}  # stream_id => PendingStream (for streaming dispatch)
+      @cancellations = {}  # [connection_handle, stream_id] => Cancellation
+      @deadlines = RequestDeadlines.new(
+        default_ms: @server_configuration.request_deadline_ms,
+        header: @server_configuration.request_deadline_header
+      )
+      @pending_streams = {}  # [connection_handle, stream_id] => PendingStream (for streaming dispatch)
       @pending_mutex = Mutex.new
       @datagram_callback = nil
       @connection_callback = nil
@@ -98,15 +131,32 @@ module Quicsilver
       @connection_migrated_callback = nil
       @connection_error_callback = nil
       @webtransport = WebTransportManager.new
-
-      protocol_app = wrap_app(@app, @server_configuration.mode)
+      @qpack_encoder = Protocol::Qpack::Encoder.new  # shared by all connections
+      @memory_budget = Transport::MemoryBudget.new(
+        limit: @server_configuration.memory_budget,
+        connection_limit: @server_configuration.connection_memory_budget
+      )
+      if (encodings = @server_configuration.response_compression)
+        @response_compression = Protocol::ResponseCompression.new(encodings: encodings == true ? nil : encodings)
+      end
+      if (cache_size = @server_configuration.response_cache_size)
+        @response_cache = ResponseCache.new(max_size: cache_size)
+      end
+      if (max_pushes = @server_configuration.max_pushes_per_request)
+        @server_push = ServerPush.new(max_per_request: max_pushes, scheduler: @scheduler, encoder: @qpack_encoder) do |connection, stream|
+          dispatch_request(connection, stream)
+        end
+      end
 
       @request_handler = RequestHandler.new(
-        app: protocol_app,
+        adapter: build_adapter(@app, @server_configuration.mode),
         configuration: @server_configuration,
         request_registry: @request_registry,
         cancelled_streams: @cancelled_streams,
-        cancelled_mutex: @cancelled_mutex
+        cancelled_mutex: @cancelled_mutex,
+        cancellations: @cancellations,
+        deadlines: @deadlines,
+        server_push: @server_push
       )
 
       self.class.instance = self
@@ -183,6 +233,9 @@ module Quicsilver
       @config_handle = Quicsilver.create_server_configuration(@server_configuration.to_h)
       raise ServerConfigurationError, "Failed to create server configuration" unless @config_handle
 
+      Quicsilver.configure_connection_limits(@server_configuration.connection_limits(@max_connections))
+      Quicsilver.configure_send_limits(@server_configuration.send_high_water_mark,
+        @server_configuration.connection_send_high_water_mark)
       create_listener
       configure_listener
       start_listener
@@ -267,15 +320,22 @@ module Quicsilver
           "max" => @max_connections
         },
         "requests" => {
-          "active" => @request_registry.active_count
+          "active" => @request_registry.active_count,
+          "async" => async_responses
         },
         "scheduler" => {
           "threads" => @thread_pool_size,
+          "min_threads" => @min_threads,
+          "workers" => @scheduler.workers,
+          "queues" => @scheduler.queues,
           "pending" => @scheduler.pending,
           "max_queue_size" => @max_queue_size,
-          "full" => @scheduler.full?
+          "full" => @scheduler.full?,
+          "queue_time" => @deadlines.to_h
         },
-        "transport" => transport_counters
+        "transport" => transport_counters,
+        "memory" => @memory_budget.to_h,
+        "response_cache" => @response_cache&.to_h
       }
     end
 
@@ -283,15 +343,18 @@ module Quicsilver
       @connections.values.map(&:to_h)
     end
 
-    def cancelled_stream?(stream_id)
-      @cancelled_mutex.synchronize { @cancelled_streams.include?(stream_id) }
+    def cancelled_stream?(stream_id, connection_handle)
+      @cancelled_mutex.synchronize { @cancelled_streams.include?([connection_handle, stream_id]) }
     end
 
-    # Wait for work queue to drain, then shut down the scheduler
+    # Wait for work queue to drain, then shut down the scheduler. Async
+    # bodies outlive the worker that started them: wait for those too.
     def drain(timeout: 5)
+      deadline = Time.now + timeout
       Quicsilver.logger.debug("Draining work queue (#{@scheduler.pending} pending)")
       @scheduler.drain(timeout: timeout)
       @scheduler.stop
+      sleep 0.05 while async_responses > 0 && Time.now < deadline
     end
 
     # Graceful shutdown: send GOAWAY, drain requests, then stop
@@ -326,6 +389,9 @@ module Quicsilver
           Quicsilver.logger.warn("Force-closing request: #{req[:method]} #{req[:path]} (stream: #{stream_id}, elapsed: #{elapsed.round(2)}s)")
         end
       end
+      if (async = async_responses) > 0
+        Quicsilver.logger.warn("Force-closing #{async} async response(s)")
+      end
 
       # Phase 3: Shutdown connections
       @connections.each_value(&:shutdown)
@@ -343,6 +409,9 @@ module Quicsilver
 
       case event
       when STREAM_EVENT_CONNECTION_ESTABLISHED
+        # max_connections is enforced natively before the handshake (see
+        # Configuration#connection_limits); this catches anything that slips
+        # through, e.g. limits changed while connections were handshaking.
         if @connections.size >= @max_connections
           Quicsilver.logger.warn("Connection limit reached (#{@max_connections}), rejecting connection")
           Quicsilver.connection_shutdown(connection_handle, Protocol::H3_EXCESSIVE_LOAD, false)
@@ -356,7 +425,15 @@ module Quicsilver
           connection_data,
           max_header_size: @server_configuration.max_header_size,
           connection_id: connection_id,
-          transport_server_id: @server_configuration.transport_server_id
+          transport_server_id: @server_configuration.transport_server_id,
+          spool_threshold: @server_configuration.request_body_spool_threshold,
+          max_body_size: @server_configuration.max_body_size,
+          max_frame_payload_size: @server_configuration.max_frame_payload_size,
+          coalesce_size: @server_configuration.response_coalesce_size,
+          coalesce_delay: @server_configuration.response_coalesce_delay_ms / 1000.0,
+          qpack_encoder: @qpack_encoder,
+          compression: @response_compression,
+          memory: @memory_budget.account(connection_handle)
         )
         connection.resolve_remote_address!
         @connections[connection_handle] = connection
@@ -370,14 +447,36 @@ module Quicsilver
           @webtransport.unregister(sid)
         end
         @connection_closed_callback&.call(connection) if connection
+        cancel_connection_requests(connection_handle)
+        connection&.close_async_bodies(RuntimeError.new("Connection closed"))
         connection&.streams&.clear
+        connection&.discard_buffers
+        connection&.memory&.close
         Quicsilver.close_server_connection(connection_handle)
       when STREAM_EVENT_SEND_COMPLETE
-        # Buffer cleanup handled in C extension
+        # Buffer cleanup and send-window accounting handled in C extension.
+        # Unacknowledged response bytes count against the memory budget too,
+        # so a peer that only reads is held to it without sending more data.
+        return unless @memory_budget.enforced? && (connection = @connections[connection_handle])
+        enforce_memory_budget(connection, connection_handle, stream_id, data.unpack1("Q<"))
       when STREAM_EVENT_SHUTDOWN_COMPLETE
+        # The handle is about to be freed; async bodies must stop writing to it
+        @connections[connection_handle]&.close_async_body(stream_id, RuntimeError.new("Stream #{stream_id} shut down"))
+        @connections[connection_handle]&.release_push(stream_id) if @server_push
         if @webtransport.shutdown_stream(stream_id)
           connection.remove_stream(stream_id) if connection
         end
+        pending = @pending_mutex.synchronize do
+          pending = @pending_streams[[connection_handle, stream_id]]
+          # Responded early and the peer never sent FIN — stop tracking it now
+          @pending_streams.delete([connection_handle, stream_id]) if pending&.discarding
+          pending
+        end
+        # Gone before the body finished: fail the reader rather than let it
+        # resume receives on a handle MsQuic is about to free.
+        if pending && !pending.fin_received && !pending.discarding
+          pending.body&.close(RuntimeError.new("Stream #{stream_id} shut down"))
+        end
       when STREAM_EVENT_RECEIVE
         return unless (connection = @connections[connection_handle])
         handle_receive(connection, connection_handle, stream_id, data, early_data: early_data)
@@ -481,6 +580,12 @@ module Quicsilver
       end
     end
 
+    # Open async bodies across connections. Hash#values snapshots the
+    # connections the poll thread adds and removes.
+    def async_responses
+      @connections.values.sum(&:async_responses)
+    end
+
     def transport_counters
       Quicsilver.transport_counters
     rescue RuntimeError => error
@@ -490,20 +595,46 @@ module Quicsilver
     end
 
     def cancel_stream(connection, stream_id)
-      @cancelled_mutex.synchronize { @cancelled_streams.add(stream_id) }
-      pending = @pending_mutex.synchronize { @pending_streams.delete(stream_id) }
+      cancellation = @cancelled_mutex.synchronize do
+        @cancelled_streams.add([connection.handle, stream_id])
+        @cancellations[[connection.handle, stream_id]]
+      end
+      cancellation&.cancel("Stream #{stream_id} cancelled by peer")
+      pending = @pending_mutex.synchronize { @pending_streams.delete([connection.handle, stream_id]) }
       pending&.body&.close(RuntimeError.new("Stream #{stream_id} cancelled"))
+      release_frame_buffer(pending) if pending
+      connection.discard_buffer(stream_id)
+      connection.close_async_body(stream_id, RuntimeError.new("Stream #{stream_id} cancelled"))
       @request_registry.complete(stream_id, connection.handle)
       connection.remove_stream(stream_id)
     end
 
-    # Wrap the user's app for the configured mode.
+    # Created at dispatch so a request can be cancelled while still queued.
+    # Removed by whichever worker finishes the request.
+    def track_cancellation(connection, stream_id)
+      cancellation = Cancellation.new
+      @cancelled_mutex.synchronize { @cancellations[[connection.handle, stream_id]] = cancellation }
+      cancellation
+    end
+
+    def cancel_connection_requests(connection_handle)
+      cancellations = @cancelled_mutex.synchronize do
+        @cancellations.select { |(handle, _), _| handle == connection_handle }.values
+      end
+      cancellations.each { |cancellation| cancellation.cancel("Connection closed") }
+    end
+
+    # Adapter between HTTP/3 requests and the user's app for the configured mode.
     # Rack mode: inject rack.early_hints support, then wrap with protocol-rack.
+    # Rack direct mode: Rack env built straight from the decoded headers.
+    # Raw mode: app called with (stream, flat headers, body), no env at all.
     # Falcon mode: pass through as-is (native protocol-http app).
-    def wrap_app(app, mode)
+    def build_adapter(app, mode)
       case mode
-      when :falcon then app
-      else Server::RackAdapter.new(app)
+      when :falcon then Protocol::Adapter.new(app, encoder: @qpack_encoder)
+      when :rack_direct then RackEnvAdapter.new(app)
+      when :raw then RawAdapter.new(app, encoder: @qpack_encoder)
+      else Protocol::Adapter.new(Server::RackAdapter.new(app), encoder: @qpack_encoder)
       end
     end
 
@@ -561,13 +692,15 @@ module Quicsilver
     end
 
     def handle_bidi_receive(connection, connection_handle, stream_id, stream_handle, payload, early_data: false)
-      pending = @pending_mutex.synchronize { @pending_streams[stream_id] }
+      pending = @pending_mutex.synchronize { @pending_streams[[connection_handle, stream_id]] }
       if (wt_payload = @webtransport.pending_payload(stream_id, stream_handle, payload))
         accept_webtransport_stream(connection, stream_id, stream_handle, wt_payload)
       elsif @webtransport.pending_stream?(stream_id)
       elsif pending
-        pending.frame_buffer << payload
-        drain_data_frames(pending)
+        unless pending.discarding
+          receive_frames(pending, payload)
+          enforce_memory_budget(connection, connection_handle, stream_id, stream_handle)
+        end
       elsif (wt_stream = @webtransport.active_stream(stream_id))
         wt_stream.receive_data(payload)
       elsif (wt_session = @webtransport.session(stream_id))
@@ -577,10 +710,25 @@ module Quicsilver
       elsif contains_headers_frame?(payload)
         dispatch_streaming(connection, connection_handle, stream_id, payload, stream_handle: stream_handle, early_data: early_data)
       else
-        connection.buffer_data(stream_id, payload)
+        buffer_request_data(connection, connection_handle, stream_id, stream_handle, payload)
       end
     end
 
+    # Requests whose first RECEIVE doesn't start with HEADERS are buffered
+    # until FIN; large ones are spooled to disk by the connection.
+    def buffer_request_data(connection, connection_handle, stream_id, stream_handle, payload)
+      connection.buffer_data(stream_id, payload)
+      enforce_memory_budget(connection, connection_handle, stream_id, stream_handle)
+    rescue Protocol::FrameError => e
+      Quicsilver.logger.error("Frame error: #{e.message}")
+      connection.discard_buffer(stream_id)
+      Quicsilver.connection_shutdown(connection_handle, e.error_code, false) rescue nil
+    rescue Protocol::MessageError => e
+      Quicsilver.logger.error("Message error on stream #{stream_id}: #{e.message}")
+      connection.discard_buffer(stream_id)
+      Quicsilver.stream_reset(stream_handle, e.error_code) rescue nil
+    end
+
     def handle_receive_fin(connection, connection_handle, stream_id, data, early_data: false)
       event = Transport::StreamEvent.new(data, "RECEIVE_FIN")
 
@@ -598,7 +746,7 @@ module Quicsilver
         return
       end
 
-      pending = @pending_mutex.synchronize { @pending_streams[stream_id] }
+      pending = @pending_mutex.synchronize { @pending_streams[[connection_handle, stream_id]] }
       if pending
         complete_streaming_request(pending, event)
       else
@@ -607,19 +755,27 @@ module Quicsilver
     end
 
     def complete_streaming_request(pending, event)
-      if event.data && !event.data.empty?
-        pending.frame_buffer << event.data
-        drain_data_frames(pending)
+      discarded = @pending_mutex.synchronize do
+        pending.complete(event.handle)
+        @pending_streams.delete(pending.key) if pending.discarding
+        pending.discarding
       end
+      return if discarded
+
+      receive_frames(pending, event.data) if event.data && !event.data.empty?
       pending.body.close_write
-      pending.complete(event.handle)
     end
 
     def complete_buffered_request(connection, connection_handle, stream_id, event, early_data: false)
       full_data = connection.complete_stream(stream_id, event.data)
       stream = Transport::InboundStream.new(stream_id)
       stream.stream_handle = event.handle
-      stream.append_data(full_data)
+      if full_data.is_a?(Protocol::RequestSpool)
+        stream.body_spool = full_data
+        stream.append_data(full_data.head)
+      else
+        stream.append_data(full_data)
+      end
 
       if stream.bidirectional?
         connection.track_client_stream(stream_id)
@@ -636,24 +792,127 @@ module Quicsilver
           Quicsilver.connection_shutdown(connection_handle, e.error_code, false) rescue nil
         end
       end
+    rescue Protocol::FrameError => e
+      Quicsilver.logger.error("Frame error: #{e.message}")
+      Quicsilver.connection_shutdown(connection_handle, e.error_code, false) rescue nil
+    rescue Protocol::MessageError => e
+      # Spooled body over max_body_size
+      Quicsilver.logger.error("Message error on stream #{stream_id}: #{e.message}")
+      Quicsilver.stream_reset(event.handle, e.error_code) rescue nil
     end
 
     def dispatch_request(connection, stream, early_data: false)
-      if @scheduler.full?
+      if @response_cache && (headers = cacheable_request_headers(stream))
+        cache_key = @response_cache.key(headers)
+        return if cache_key && serve_cached(connection, stream, cache_key, headers, stream.data, early_data)
+      end
+
+      work = [connection, stream, early_data]
+      if !@scheduler.admit?(work)
         Quicsilver.logger.warn("Work queue full (#{@max_queue_size}), rejecting request")
+        stream.body_spool&.close
         connection.send_error(stream, 503, "Service Unavailable") if stream.writable?
       else
-        @scheduler.enqueue([connection, stream, early_data])
+        stream.cancellation = track_cancellation(connection, stream.stream_id)
+        stream.arrived_at = RequestDeadlines.now
+        if cache_key && headers[":method"] == "GET"
+          fill_or_wait(cache_key, work, stream.cancellation) do |entry|
+            connection.send_encoded_response(stream, entry.response) if entry
+            @cancelled_mutex.synchronize do
+              @cancelled_streams.delete([connection.handle, stream.stream_id])
+              @cancellations.delete([connection.handle, stream.stream_id])
+            end
+            connection.remove_stream(stream.stream_id)
+          end
+        else
+          @scheduler.enqueue(work)
+        end
+      end
+    end
+
+    # Buffered requests are parsed on the worker; with the response cache
+    # on, their headers are read here too so hits skip the queue.
+    def cacheable_request_headers(stream)
+      return if stream.body_spool
+
+      parser = Protocol::RequestParser.new(
+        stream.data,
+        max_header_size: @server_configuration.max_header_size,
+        max_header_count: @server_configuration.max_header_count,
+        max_frame_payload_size: @server_configuration.max_frame_payload_size
+      )
+      parser.parse
+      parser.headers
+    rescue Protocol::FrameError, Protocol::MessageError
+      nil # the worker parses it again and answers the error
+    end
+
+    # Answer a request from the response cache. A stale entry is sent
+    # too, and a GET for it refreshes the entry in the background.
+    # request_data: the request's HEADERS, for that revalidation.
+    def serve_cached(connection, stream, cache_key, headers, request_data, early_data)
+      entry = @response_cache.lookup(cache_key)
+      return false unless entry
+
+      head = headers[":method"] == "HEAD"
+      connection.send_encoded_response(stream, entry.response(head: head), wait: false)
+      revalidate(connection, stream.stream_id, cache_key, request_data, early_data) unless head || entry.fresh?
+      true
+    end
+
+    # The revalidating request has no stream handle: RequestHandler stores
+    # its response and sends nothing.
+    def revalidate(connection, stream_id, cache_key, request_data, early_data)
+      return if @scheduler.full?
+      return unless (fill = @response_cache.begin_fill(cache_key))
+
+      stream = Transport::InboundStream.new(stream_id)
+      stream.append_data(request_data)
+      stream.cache_fill = fill
+      stream.arrived_at = RequestDeadlines.now
+      @scheduler.enqueue([connection, stream, early_data])
+    end
+
+    # Cache miss on a GET: run the app to fill cache_key, or, if another
+    # request already is, wait for it — serve is called with its entry. If
+    # that response can't be cached, waiting requests run the app after all.
+    # A waiter whose request is cancelled leaves the fill and serve is
+    # called with nil, to clean up without sending.
+    def fill_or_wait(cache_key, work, cancellation, &serve)
+      return @scheduler.enqueue(work) if @response_cache.pass?(cache_key)
+
+      waiter = lambda do |entry|
+        if entry.nil?
+          @scheduler.enqueue(work)
+        else
+          serve.call(cancellation.cancelled? ? nil : entry)
+        end
+      end
+
+      if (fill = @response_cache.begin_fill(cache_key, &waiter))
+        work[1].cache_fill = fill
+        @scheduler.enqueue(work)
+      else
+        cancellation.on_cancel { serve.call(nil) if @response_cache.cancel_wait(cache_key, waiter) }
       end
     end
 
     def build_scheduler(scheduler_class)
       klass = scheduler_class || Schedulers::ThreadScheduler
 
-      klass.new(
-        concurrency: @thread_pool_size,
-        max_queue_size: @max_queue_size
-      ) do |work|
+      options = { concurrency: @thread_pool_size, max_queue_size: @max_queue_size }
+      # Custom schedulers keep the plain (concurrency:, max_queue_size:) signature
+      if klass <= Schedulers::ThreadScheduler
+        options[:min_concurrency] = @min_threads
+        options[:idle_timeout] = @thread_idle_timeout if @thread_idle_timeout
+        options[:scale_up_wait] = @thread_scale_up_wait if @thread_scale_up_wait
+        if @fair_queuing
+          options[:fair_key] = ->(work) { work[0] == :streaming ? work[1].connection : work[0] }
+          options[:weight] = @connection_weight
+        end
+      end
+
+      klass.new(**options) do |work|
         if work.is_a?(Array) && work[0] == :streaming
           handle_streaming_request(work[1])
         else
@@ -705,13 +964,50 @@ module Quicsilver
         return
       end
 
+      if @response_cache && stream_handle && (cache_key = @response_cache.key(headers))
+        stream = Transport::InboundStream.new(stream_id)
+        stream.stream_handle = stream_handle
+        if serve_cached(connection, stream, cache_key, headers, data, early_data)
+          connection.track_client_stream(stream_id)
+          # Drop whatever else arrives for the request until FIN
+          pending = PendingStream.new(connection: connection, stream_id: stream_id, stream_handle: stream_handle)
+          @pending_mutex.synchronize { @pending_streams[pending.key] = pending }
+          finish_streaming_request(pending)
+          return
+        end
+      end
+
+      cancellation = Cancellation.new
+      arrived_at = RequestDeadlines.now
+      deadline = @deadlines.deadline_for(arrived_at, headers)
+      transport_context = connection.request_context(stream_id: stream_id)
+      transport_context["cancellation"] = cancellation
+      transport_context["deadline"] = deadline if deadline
+      if @server_push && stream_handle
+        request_stream = Transport::InboundStream.new(stream_id)
+        request_stream.stream_handle = stream_handle
+        pusher = @server_push.pusher(connection, request_stream, headers)
+        transport_context["push"] = pusher if pusher
+      end
+
       request, body = @request_handler.adapter.build_request(
         headers,
         remote_address: connection.remote_address,
         remote_port: connection.remote_port,
-        transport_context: connection.request_context(stream_id: stream_id)
+        transport_context: transport_context,
+        early_data: early_data
       )
-      request.headers.add("quicsilver-early-data", early_data.to_s)
+
+      # Backpressure: pause MsQuic receives while the app is behind (or the
+      # connection is over its memory budget) so the client is held by flow
+      # control instead of filling our memory.
+      body&.charge_to(connection.memory)
+      if body && stream_handle && (limit = @server_configuration.request_body_buffer_size)
+        body.flow_control(limit) do |enabled|
+          Quicsilver.logger.debug("Stream #{stream_id} request body #{enabled ? "resumed" : "paused"}")
+          Quicsilver.stream_receive_set_enabled(stream_handle, enabled)
+        end
+      end
 
       # Feed body data from the first RECEIVE.
       # The parser consumed complete frames (HEADERS + any complete DATA frames).
@@ -729,27 +1025,44 @@ module Quicsilver
         body: body,
         request: request,
         stream_id: stream_id,
-        priority: parser.priority
+        stream_handle: stream_handle,
+        priority: parser.priority,
+        cancellation: cancellation,
+        arrived_at: arrived_at,
+        deadline: deadline
       )
 
       # Unconsumed bytes go into the frame buffer for incremental parsing
       remainder = data.byteslice(parser.bytes_consumed..-1)
-      if remainder && remainder.bytesize > 0
-        pending.frame_buffer << remainder
-        drain_data_frames(pending)
-      end
-      @pending_mutex.synchronize { @pending_streams[stream_id] = pending }
+      receive_frames(pending, remainder) if remainder && remainder.bytesize > 0
+      @pending_mutex.synchronize { @pending_streams[pending.key] = pending }
 
       connection.track_client_stream(stream_id)
       @request_registry.track(stream_id, connection_handle,
         path: headers[":path"] || "/", method: method || "GET")
 
-      if @scheduler.full?
+      if !@scheduler.admit?([:streaming, pending])
         Quicsilver.logger.warn("Work queue full (#{@max_queue_size}), rejecting request")
-        body&.close
-        @pending_mutex.synchronize { @pending_streams.delete(stream_id) }
+        if stream_handle
+          stream = Transport::InboundStream.new(stream_id)
+          stream.stream_handle = stream_handle
+          connection.send_error(stream, 503, "Service Unavailable")
+        end
+        release_streaming_request(pending)
       else
-        @scheduler.enqueue([:streaming, pending])
+        @cancelled_mutex.synchronize { @cancellations[[connection_handle, stream_id]] = cancellation }
+        if cache_key && method == "GET"
+          fill_or_wait(cache_key, [:streaming, pending], cancellation) do |entry|
+            if entry
+              stream = Transport::InboundStream.new(stream_id)
+              stream.stream_handle = stream_handle
+              connection.send_encoded_response(stream, entry.response)
+            end
+            release_streaming_request(pending)
+          end
+        else
+          @scheduler.enqueue([:streaming, pending])
+        end
       end
     rescue Protocol::FrameError => e
       Quicsilver.logger.error("Frame error: #{e.message}")
@@ -761,43 +1074,48 @@ module Quicsilver
     end
 
     def handle_streaming_request(pending)
+      # Reset while still queued: don't spend a worker on it
+      if pending.cancellation&.cancelled?
+        Quicsilver.logger.debug("Dropping queued request for cancelled stream #{pending.stream_id}")
+        return
+      end
+
+      if pending.arrived_at
+        queue_time = @deadlines.dequeued(pending.arrived_at)
+        pending.request.transport_context["queue_time"] = queue_time
+        if @deadlines.expired?(pending.deadline)
+          @deadlines.expired!
+          Quicsilver.logger.debug("Shedding stream #{pending.stream_id}: deadline passed after #{(queue_time * 1000).round}ms in queue")
+          if pending.stream_handle
+            stream = Transport::InboundStream.new(pending.stream_id)
+            stream.stream_handle = pending.stream_handle
+            pending.connection.send_error(stream, 503, "Service Unavailable")
+          end
+          return
+        end
+      end
+
       response = @request_handler.adapter.call(pending.request)
 
-      # Wait for RECEIVE_FIN to provide the stream handle
+      # The handle normally came with HEADERS, so this doesn't block and the
+      # response can go out while the client is still uploading.
       stream_handle = pending.wait_for_handle(timeout: 30)
       unless stream_handle
         Quicsilver.logger.error("Timed out waiting for stream handle on stream #{pending.stream_id}")
         return
       end
 
-      return if cancelled_stream?(pending.stream_id)
-
-      headers = response.headers
-
-      trailers = if headers.respond_to?(:trailer?) && headers.trailer?
-        trailer_hash = {}
-        headers.trailer.each { |name, value| trailer_hash[name] = value }
-        trailer_hash
-      end
-
-      response_headers = {}
-      if headers.respond_to?(:header)
-        headers.header.each { |name, value| response_headers[name] = value }
-      else
-        headers&.each { |name, value| response_headers[name] = value }
-      end
-
-      if !response_headers.key?("content-length") && response.body&.length
-        response_headers["content-length"] = response.body.length.to_s
-      end
+      return if pending.cancellation&.cancelled? || cancelled_stream?(pending.stream_id, pending.connection.handle)
 
       stream = Transport::InboundStream.new(pending.stream_id)
       stream.stream_handle = stream_handle
+      stream.cache_fill = pending.cache_fill
 
       pending.connection.apply_stream_priority(stream, pending.priority)
-      pending.connection.send_response(stream, response.status, response_headers, response.body,
-        head_request: pending.request.method == "HEAD", trailers: trailers)
+      @request_handler.respond(pending.connection, stream, pending.request, response)
       @request_registry.complete(pending.stream_id, pending.connection.handle)
+    rescue CancelledError
+      Quicsilver.logger.debug("Request abandoned after cancellation: stream #{pending.stream_id}")
     rescue => e
       Quicsilver.logger.error("Streaming request error: #{e.class} - #{e.message}")
       if pending.stream_handle
@@ -806,53 +1124,89 @@ module Quicsilver
         pending.connection.send_error(stream, 500, "Internal Server Error") if stream.writable?
       end
     ensure
-      @pending_mutex.synchronize { @pending_streams.delete(pending.stream_id) }
-      @cancelled_mutex.synchronize { @cancelled_streams.delete(pending.stream_id) }
+      pending.cache_fill&.release
+      release_streaming_request(pending)
+    end
+
+    def release_streaming_request(pending)
+      finish_streaming_request(pending)
+      pending.body&.release_memory
+      release_frame_buffer(pending)
+      @cancelled_mutex.synchronize do
+        @cancelled_streams.delete([pending.connection.handle, pending.stream_id])
+        @cancellations.delete([pending.connection.handle, pending.stream_id])
+      end
       @request_registry.complete(pending.stream_id, pending.connection.handle)
       pending.connection.remove_stream(pending.stream_id)
     end
 
-    # Incrementally extract complete DATA frame payloads from the frame buffer.
-    # Handles MsQuic splitting frames across RECEIVE callbacks — partial frames
-    # remain in the buffer until the next callback completes them.
-    def drain_data_frames(pending)
-      buf = pending.frame_buffer
-
-      while buf.bytesize >= 2
-        type_byte = buf.getbyte(0)
-        if type_byte < 0x40
-          type = type_byte
-          type_len = 1
-        else
-          type, type_len = Protocol.decode_varint_str(buf, 0)
-          break if type_len == 0
-        end
-
-        len_byte = buf.getbyte(type_len)
-        break unless len_byte
-        if len_byte < 0x40
-          length = len_byte
-          length_len = 1
+    # The response is done. If the request body is still arriving, nobody will
+    # read it: ask the client to stop (RFC 9114 §4.1 — H3_NO_ERROR after a
+    # complete response) and drop whatever is already in flight. The entry
+    # stays registered until RECEIVE_FIN or reset so late RECEIVEs aren't
+    # mistaken for a new request.
+    def finish_streaming_request(pending)
+      still_receiving = @pending_mutex.synchronize do
+        if pending.fin_received || !@pending_streams.key?(pending.key)
+          @pending_streams.delete(pending.key)
+          false
         else
-          length, length_len = Protocol.decode_varint_str(buf, type_len)
-          break if length_len == 0
+          pending.discarding = true
         end
+      end
+      return unless still_receiving
 
-        header_len = type_len + length_len
-        total = header_len + length
+      pending.body&.close
+      if pending.stream_handle
+        Quicsilver.stream_stop_sending(pending.stream_handle, Protocol::H3_NO_ERROR) rescue nil
+      end
+    end
 
-        # Incomplete frame — wait for more data
-        break if buf.bytesize < total
+    # Partial frames waiting in the frame buffer count against the
+    # connection's memory budget, like the body data they become.
+    def receive_frames(pending, data)
+      buffer = pending.frame_buffer
+      held = buffer.bytesize
+      buffer << data
+      drain_data_frames(pending)
+      pending.connection.memory.adjust(buffer.bytesize - held)
+    end
 
-        if type == Protocol::FRAME_DATA
-          pending.body.write(buf.byteslice(header_len, length))
-        end
-        # Skip non-DATA frames (e.g. unknown extension frames)
+    def release_frame_buffer(pending)
+      pending.connection.memory.release(pending.frame_buffer.bytesize)
+      pending.frame_buffer = Protocol::ChunkBuffer.new
+    end
 
-        buf = buf.byteslice(total..-1) || "".b
+    # Past the :pause level of Transport::MemoryBudget (carried out by
+    # StreamInput flow control), reset the stream that just received or
+    # completed sending data, or close its connection.
+    def enforce_memory_budget(connection, connection_handle, stream_id, stream_handle)
+      case (level = connection.memory.level)
+      when :reset
+        Quicsilver.logger.warn("Memory budget exceeded, resetting stream #{stream_id}")
+        Quicsilver.stream_reset(stream_handle, Protocol::H3_EXCESSIVE_LOAD) rescue nil
+        Quicsilver.stream_stop_sending(stream_handle, Protocol::H3_EXCESSIVE_LOAD) rescue nil
+        cancel_stream(connection, stream_id)
+      when :close
+        Quicsilver.logger.warn("Memory budget exceeded, closing connection")
+        Quicsilver.connection_shutdown(connection_handle, Protocol::H3_EXCESSIVE_LOAD, false) rescue nil
+      else
+        return
       end
+      @memory_budget.enforced!(level)
+    end
 
-      pending.frame_buffer = buf
+    # Incrementally extract complete DATA frame payloads from the frame buffer.
+    # Handles MsQuic splitting frames across RECEIVE callbacks — partial frames
+    # remain in the buffer until the next callback completes them.
+    def drain_data_frames(pending)
+      buf = pending.frame_buffer
+
+      while (frame = buf.shift_frame)
+        type, payload = frame
+        pending.body.write(payload) if type == Protocol::FRAME_DATA
+        # Skip non-DATA frames (e.g. unknown extension frames)
+      end
     end
 
     # Heuristic: check if raw data starts with an HTTP/3 HEADERS frame (type 0x01).
@@ -870,7 +1224,8 @@ module Quicsilver
       session = WebTransportSession.new(
         connection: connection,
         stream: stream,
-        headers: headers
+        headers: headers,
+        encoder: @qpack_encoder
       )
 
       dispatch_webtransport_to_rack(connection, stream_id, headers, session, early_data: early_data)
@@ -902,9 +1257,10 @@ module Quicsilver
 
       @webtransport.register(session)
       response = @request_handler.adapter.call(request)
+      status, = @request_handler.adapter.response_parts(response)
 
       Quicsilver.logger.debug(
-        "WebTransport Rack response stream=#{stream_id} status=#{response.status.inspect} " \
+        "WebTransport Rack response stream=#{stream_id} status=#{status.inspect} " \
         "accepted=#{session.accepted?}"
       )
 
@@ -912,7 +1268,7 @@ module Quicsilver
         connection.track_client_stream(stream_id)
       else
         @webtransport.unregister(stream_id)
-        session.reject!(response.status)
+        session.reject!(status)
       end
     end
 
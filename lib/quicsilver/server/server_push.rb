@@ -0,0 +1,124 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  class Server
+    # HTTP/3 server push (RFC 9114 §4.6), on with the max_pushes_per_request
+    # option. Apps push subresources from a request through its Pusher:
+    # env["quicsilver.push"] in the Rack modes,
+    # request.transport_context["push"] in falcon mode, stream.push in raw
+    # mode. It is nil when the client doesn't accept pushes.
+    #
+    #   if (push = env["quicsilver.push"])
+    #     push.push("/assets/app.css")
+    #     push.push("/assets/app.js", "accept" => "*/*")
+    #   end
+    #
+    # Each push sends PUSH_PROMISE on the request stream straight away,
+    # then runs the promised GET through the app like any other request
+    # and sends its response on a push stream, so the pushed resources go
+    # out alongside the page rather than a round trip after it. The
+    # promised request has the page's :scheme and :authority and copies
+    # its INHERITED_HEADERS.
+    #
+    # Nothing is promised past the client's MAX_PUSH_ID, a path is pushed
+    # at most once per connection, and a request makes at most
+    # max_per_request pushes. The client declines a push with CANCEL_PUSH
+    # or by stopping its stream; either resets the push stream and cancels
+    # the pushed request.
+    class ServerPush
+      INHERITED_HEADERS = %w[accept-encoding accept-language user-agent].freeze
+
+      # Handed to the app: pushes on behalf of one request.
+      class Pusher
+        attr_reader :pushed
+
+        def initialize(server_push, connection, stream, headers)
+          @server_push = server_push
+          @connection = connection
+          @stream = stream
+          @headers = headers
+          @pushed = []
+        end
+
+        # Promise path (same authority) and push its response. Returns the
+        # push ID, or nil if it wasn't pushed.
+        def push(path, headers = nil)
+          return if @pushed.size >= @server_push.max_per_request
+
+          push_id = @server_push.push(@connection, @stream, @headers, path, headers)
+          @pushed << push_id if push_id
+          push_id
+        end
+        alias_method :call, :push
+
+        # Withdraw a push this request made.
+        def cancel(push_id)
+          return false unless @pushed.include?(push_id)
+
+          @connection.cancel_push(push_id)
+          true
+        end
+      end
+
+      attr_reader :max_per_request
+
+      # dispatch is called with (connection, push stream) to run the
+      # promised request.
+      def initialize(max_per_request:, scheduler:, encoder:, &dispatch)
+        @max_per_request = max_per_request
+        @scheduler = scheduler
+        @encoder = encoder
+        @dispatch = dispatch
+      end
+
+      # A Pusher for a request on stream, or nil if the client takes no
+      # pushes. Pushed responses can't push.
+      def pusher(connection, stream, headers)
+        return unless stream.writable? && stream.push_id.nil?
+        return unless connection.push_enabled?
+
+        Pusher.new(self, connection, stream, headers)
+      end
+
+      def push(connection, stream, request_headers, path, headers = nil)
+        path = path.to_s
+        return unless path.start_with?("/")
+        return if @scheduler.full?
+
+        pairs = promised_headers(request_headers, path, headers)
+        field_section = @encoder.encode(pairs)
+        push_id = connection.promise_push(stream, field_section, "#{request_headers[":authority"]}#{path}")
+        return unless push_id
+
+        begin
+          push_stream = connection.open_push_stream(push_id)
+        rescue RuntimeError => e
+          Quicsilver.logger.debug("Failed to open push stream for push #{push_id}: #{e.message}")
+          connection.cancel_push(push_id)
+          return
+        end
+
+        push_stream.append_data(Protocol.build_frame(Protocol::FRAME_HEADERS, field_section))
+        @dispatch.call(connection, push_stream)
+        push_id
+      end
+
+      private
+
+      def promised_headers(request_headers, path, headers)
+        pairs = [
+          [":method", "GET"],
+          [":scheme", request_headers[":scheme"] || "https"],
+          [":authority", request_headers[":authority"].to_s],
+          [":path", path]
+        ]
+        INHERITED_HEADERS.each do |name|
+          value = request_headers[name]
+          pairs << [name, value.is_a?(Array) ? value.join(", ") : value] if value
+        end
+        headers&.each { |name, value| pairs << [name.to_s.downcase, value.to_s] }
+        pairs
+      end
+    end
+  end
+end
@@ -56,8 +56,9 @@ module Quicsilver
         [session_id, payload.byteslice(sid_len..-1) || "".b]
       end
 
-      def initialize(connection:, stream:, headers:)
+      def initialize(connection:, stream:, headers:, encoder:)
         @connection = connection
+        @encoder = encoder
         @stream = stream
         @stream_id = stream.stream_id
         @path = headers[":path"]
@@ -78,7 +79,7 @@ module Quicsilver
       def accept!
         return if @accepted
 
-        frame = Protocol.build_headers_frame([[:":status", "200"]])
+        frame = Protocol.build_headers_frame([[:":status", "200"]], encoder: @encoder)
         @stream.send(frame, fin: false)
         @accepted = true
         @open = true
@@ -175,7 +176,7 @@ module Quicsilver
 
         response_headers = [[":status", status.to_i.to_s]]
         headers.each { |name, value| response_headers << [name.to_s.downcase, value.to_s] }
-        @stream.send(Protocol.build_headers_frame(response_headers), fin: true)
+        @stream.send(Protocol.build_headers_frame(response_headers, encoder: @encoder), fin: true)
         @open = false
       end
 
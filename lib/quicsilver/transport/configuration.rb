@@ -8,7 +8,16 @@ module Quicsilver
         :pacing_enabled, :send_buffering_enabled, :initial_rtt_ms, :initial_window_packets, :max_ack_delay_ms,
         :keep_alive_interval_ms, :congestion_control_algorithm, :migration_enabled,
         :disconnect_timeout_ms, :handshake_idle_timeout_ms,
+        :max_connections_per_ip, :ipv4_prefix_length, :ipv6_prefix_length, :retry_under_load,
+        :handshake_rate_limit, :retry_memory_percent,
+        :request_rate_limit, :request_rate_limit_per_ip, :byte_rate_limit, :byte_rate_limit_per_ip,
         :max_body_size, :max_header_size, :max_header_count, :max_frame_payload_size,
+        :request_body_buffer_size, :request_body_spool_threshold,
+        :response_coalesce_size, :response_coalesce_delay_ms, :response_cache_size, :response_compression,
+        :max_pushes_per_request,
+        :send_high_water_mark, :connection_send_high_water_mark,
+        :connection_memory_budget, :memory_budget,
+        :request_deadline_ms, :request_deadline_header,
         :early_data_policy,
         :cibir_id, :transport_server_id,
         :mode
@@ -42,6 +51,13 @@ module Quicsilver
       DEFAULT_MAX_HEADER_SIZE = 65_536           # 64KB — matches Envoy/nginx defaults
       DEFAULT_MAX_HEADER_COUNT = 100             # Matches nginx default
       DEFAULT_MAX_FRAME_PAYLOAD_SIZE = 1_048_576 # 1MB — single frame can't exceed this
+      DEFAULT_REQUEST_BODY_BUFFER_SIZE = 262_144 # 256KB unread per upload — one stream receive window
+      DEFAULT_REQUEST_BODY_SPOOL_THRESHOLD = 1_048_576 # 1MB — larger buffered bodies go to a temp file
+      DEFAULT_RESPONSE_COALESCE_SIZE = 16_384 # 16KB — ~12 full packets per send
+      DEFAULT_RESPONSE_COALESCE_DELAY_MS = 5
+      DEFAULT_SEND_HIGH_WATER_MARK = 1_048_576 # 1MB unacknowledged per stream
+      DEFAULT_CONNECTION_SEND_HIGH_WATER_MARK = 16_777_216 # 16MB — matches the connection flow control window
+      DEFAULT_REQUEST_DEADLINE_HEADER = "x-request-timeout-ms"
 
 
       # Connection management defaults
@@ -51,6 +67,10 @@ module Quicsilver
       DEFAULT_DISCONNECT_TIMEOUT_MS = 16_000     # How long to wait for ACK before path declared dead
       DEFAULT_HANDSHAKE_IDLE_TIMEOUT_MS = 10_000 # Handshake timeout (separate from connection idle)
 
+      # Admission control — enforced natively before the TLS handshake
+      DEFAULT_IPV4_PREFIX_LENGTH = 32            # Per-address
+      DEFAULT_IPV6_PREFIX_LENGTH = 64            # Per-subnet — one host usually owns a whole /64
+
       def initialize(cert_file = nil, key_file = nil, options = {})
         @idle_timeout_ms = options.fetch(:idle_timeout_ms, 10000)
         @server_resumption_level = options.fetch(:server_resumption_level, QUIC_SERVER_RESUME_AND_ZERORTT)
@@ -85,6 +105,37 @@ module Quicsilver
         @disconnect_timeout_ms = options.fetch(:disconnect_timeout_ms, DEFAULT_DISCONNECT_TIMEOUT_MS)
         @handshake_idle_timeout_ms = options.fetch(:handshake_idle_timeout_ms, DEFAULT_HANDSHAKE_IDLE_TIMEOUT_MS)
 
+        # Admission control. Connections from one source prefix beyond
+        # max_connections_per_ip (nil = unlimited) are refused before any
+        # handshake work, as are connections over the server's max_connections.
+        # retry_under_load: once 75% of max_connections are in use, new clients
+        # must complete a stateless Retry (address validation) first.
+        @max_connections_per_ip = options.fetch(:max_connections_per_ip, nil)
+        @ipv4_prefix_length = options.fetch(:ipv4_prefix_length, DEFAULT_IPV4_PREFIX_LENGTH)
+        @ipv6_prefix_length = options.fetch(:ipv6_prefix_length, DEFAULT_IPV6_PREFIX_LENGTH)
+        @retry_under_load = options.fetch(:retry_under_load, false)
+
+        # Handshake-flood defense. retry_memory_percent: share of MsQuic's
+        # handshake memory in use before it answers with stateless Retry
+        # (nil keeps MsQuic's 65%; 0 = always retry). handshake_rate_limit:
+        # handshake attempts (new connections and Retries sent) per second
+        # above which the server switches to "under attack" mode and
+        # requires Retry until the flood subsides.
+        @retry_memory_percent = options.fetch(:retry_memory_percent, nil)
+        @handshake_rate_limit = options.fetch(:handshake_rate_limit, nil)
+
+        # Request rate limits, enforced natively before a request reaches
+        # Ruby (nil = unlimited). request_rate_limit: request streams per
+        # second per connection, *_per_ip per source prefix; a stream over
+        # it is answered with a 429. byte_rate_limit: request bytes per
+        # second; a stream over it is reset with H3_EXCESSIVE_LOAD. Bursts
+        # of up to one second's worth are allowed.
+        @request_rate_limit = options.fetch(:request_rate_limit, nil)
+        @request_rate_limit_per_ip = options.fetch(:request_rate_limit_per_ip, nil)
+        @byte_rate_limit = options.fetch(:byte_rate_limit, nil)
+        @byte_rate_limit_per_ip = options.fetch(:byte_rate_limit_per_ip, nil)
+        validate_admission_limits!
+
         # HTTP/3 parser limits — sensible defaults prevent OOM from malicious clients.
         # RFC 9114 §4.2.2: SETTINGS_MAX_FIELD_SECTION_SIZE limits header block size.
         # Override with nil to disable (not recommended in production).
@@ -93,6 +144,105 @@ module Quicsilver
         @max_header_count = options.fetch(:max_header_count, DEFAULT_MAX_HEADER_COUNT)
         @max_frame_payload_size = options.fetch(:max_frame_payload_size, DEFAULT_MAX_FRAME_PAYLOAD_SIZE)
 
+        # Streaming request bodies: once this many bytes are waiting for the
+        # app to read them, the server stops consuming from MsQuic so QUIC
+        # flow control holds back the client, and resumes as the app reads.
+        # nil = unbounded (the whole upload may sit in memory).
+        @request_body_buffer_size = options.fetch(:request_body_buffer_size, DEFAULT_REQUEST_BODY_BUFFER_SIZE)
+        unless @request_body_buffer_size.nil? || (@request_body_buffer_size.is_a?(Integer) && @request_body_buffer_size.positive?)
+          raise ServerConfigurationError, "request_body_buffer_size must be a positive integer or nil"
+        end
+
+        # Buffered (non-streaming) requests larger than this are written to an
+        # unlinked temp file as they arrive, and the app reads the body from
+        # it. nil = always buffer in memory (up to max_body_size).
+        @request_body_spool_threshold = options.fetch(:request_body_spool_threshold, DEFAULT_REQUEST_BODY_SPOOL_THRESHOLD)
+        unless @request_body_spool_threshold.nil? || (@request_body_spool_threshold.is_a?(Integer) && @request_body_spool_threshold.positive?)
+          raise ServerConfigurationError, "request_body_spool_threshold must be a positive integer or nil"
+        end
+
+        # Streamed (non-array) response bodies: small chunks are merged into
+        # one DATA frame until this many bytes are pending or the delay has
+        # passed since the first of them. text/event-stream responses are
+        # always sent per chunk. nil size = one frame per chunk.
+        @response_coalesce_size = options.fetch(:response_coalesce_size, DEFAULT_RESPONSE_COALESCE_SIZE)
+        unless @response_coalesce_size.nil? || (@response_coalesce_size.is_a?(Integer) && @response_coalesce_size.positive?)
+          raise ServerConfigurationError, "response_coalesce_size must be a positive integer or nil"
+        end
+        @response_coalesce_delay_ms = options.fetch(:response_coalesce_delay_ms, DEFAULT_RESPONSE_COALESCE_DELAY_MS)
+        unless @response_coalesce_delay_ms.is_a?(Numeric) && @response_coalesce_delay_ms >= 0
+          raise ServerConfigurationError, "response_coalesce_delay_ms must be a non-negative number"
+        end
+
+        # Micro-cache for GET responses the app marks cacheable by a shared
+        # cache (Server::ResponseCache): up to this many bytes of encoded
+        # responses, served without running the app. nil = off.
+        @response_cache_size = options.fetch(:response_cache_size, nil)
+        unless @response_cache_size.nil? || (@response_cache_size.is_a?(Integer) && @response_cache_size.positive?)
+          raise ServerConfigurationError, "response_cache_size must be a positive integer or nil"
+        end
+
+        # Response content-coding (Protocol::ResponseCompression), negotiated
+        # on accept-encoding. true = every coding the extension was built
+        # with (zstd, br, gzip), or a list in order of preference. nil = off.
+        @response_compression = options.fetch(:response_compression, nil)
+        unless @response_compression.nil? || @response_compression == true ||
+               (@response_compression.is_a?(Array) && !@response_compression.empty? &&
+                (@response_compression - Protocol::ResponseCompression::PREFERENCE).empty?)
+          raise ServerConfigurationError, "response_compression must be true, nil or a list of \"zstd\", \"br\" and \"gzip\""
+        end
+
+        # HTTP/3 server push (Server::ServerPush): how many pushes one
+        # request may make, for clients that accept them. nil = off.
+        @max_pushes_per_request = options.fetch(:max_pushes_per_request, nil)
+        unless @max_pushes_per_request.nil? || (@max_pushes_per_request.is_a?(Integer) && @max_pushes_per_request.positive?)
+          raise ServerConfigurationError, "max_pushes_per_request must be a positive integer or nil"
+        end
+
+        # Send backpressure: a stream write waits while more than this many
+        # bytes sent on the stream (or on its connection) are still
+        # unacknowledged, resuming at half. Applies to response bodies,
+        # WebTransport streams and client uploads alike. nil = unlimited.
+        # Process-wide — the last server started sets it.
+        @send_high_water_mark = options.fetch(:send_high_water_mark, DEFAULT_SEND_HIGH_WATER_MARK)
+        unless @send_high_water_mark.nil? || (@send_high_water_mark.is_a?(Integer) && @send_high_water_mark.positive?)
+          raise ServerConfigurationError, "send_high_water_mark must be a positive integer or nil"
+        end
+        @connection_send_high_water_mark = options.fetch(:connection_send_high_water_mark, DEFAULT_CONNECTION_SEND_HIGH_WATER_MARK)
+        unless @connection_send_high_water_mark.nil? || (@connection_send_high_water_mark.is_a?(Integer) && @connection_send_high_water_mark.positive?)
+          raise ServerConfigurationError, "connection_send_high_water_mark must be a positive integer or nil"
+        end
+
+        # Memory budgets (Transport::MemoryBudget): bytes a connection, or
+        # the whole server, may hold in request buffers and unacknowledged
+        # responses. Over budget the server holds back streaming uploads;
+        # further over it resets streams, then closes the connection.
+        # nil = not enforced (still measured for stats).
+        @connection_memory_budget = options.fetch(:connection_memory_budget, nil)
+        unless @connection_memory_budget.nil? || (@connection_memory_budget.is_a?(Integer) && @connection_memory_budget.positive?)
+          raise ServerConfigurationError, "connection_memory_budget must be a positive integer or nil"
+        end
+        @memory_budget = options.fetch(:memory_budget, nil)
+        unless @memory_budget.nil? || (@memory_budget.is_a?(Integer) && @memory_budget.positive?)
+          raise ServerConfigurationError, "memory_budget must be a positive integer or nil"
+        end
+
+        # Request deadlines, measured from when the request is dispatched to
+        # the worker queue. A request still queued when its deadline passes
+        # is answered with 503 instead of running the app. The client (or a
+        # proxy) may send a shorter budget in request_deadline_header, in
+        # milliseconds; it can never extend the server's. nil = no default /
+        # ignore the header.
+        @request_deadline_ms = options.fetch(:request_deadline_ms, nil)
+        unless @request_deadline_ms.nil? || (@request_deadline_ms.is_a?(Numeric) && @request_deadline_ms.positive?)
+          raise ServerConfigurationError, "request_deadline_ms must be a positive number or nil"
+        end
+        @request_deadline_header = options.fetch(:request_deadline_header, DEFAULT_REQUEST_DEADLINE_HEADER)
+        unless @request_deadline_header.nil? || @request_deadline_header.is_a?(String)
+          raise ServerConfigurationError, "request_deadline_header must be a string or nil"
+        end
+        @request_deadline_header = @request_deadline_header&.downcase
+
         # 0-RTT early data policy (RFC 8470)
         # :reject (default) — send 425 Too Early for unsafe methods on 0-RTT
         # :allow — pass all 0-RTT requests to the Rack app with env["quicsilver.early_data"]
@@ -112,10 +262,14 @@ module Quicsilver
 
         # Application interface mode:
         # :rack (default) — app is a Rack app, auto-wrapped with Protocol::Rack::Adapter
+        # :rack_direct — app is a Rack app, env built directly from the HTTP/3
+        #   headers without protocol-http (Server::RackEnvAdapter)
         # :falcon — app is a native protocol-http app, used directly
+        # :raw — app is called with (stream, headers, body) and returns
+        #   [status, headers, body_string] (Server::RawAdapter)
         @mode = options.fetch(:mode, :rack)
-        unless %i[rack falcon].include?(@mode)
-          raise ServerConfigurationError, "Invalid mode: #{@mode.inspect} (must be :rack or :falcon)"
+        unless %i[rack rack_direct falcon raw].include?(@mode)
+          raise ServerConfigurationError, "Invalid mode: #{@mode.inspect} (must be :rack, :rack_direct, :falcon or :raw)"
         end
 
         validate_certificate_paths!(cert_file, key_file)
@@ -143,6 +297,23 @@ module Quicsilver
         [@cibir_id].pack("H*") if @cibir_id
       end
 
+      # Limits for Quicsilver.configure_connection_limits. 0 = unlimited.
+      def connection_limits(max_connections)
+        {
+          max_connections: max_connections || 0,
+          max_connections_per_prefix: @max_connections_per_ip || 0,
+          ipv4_prefix_length: @ipv4_prefix_length,
+          ipv6_prefix_length: @ipv6_prefix_length,
+          retry_under_load: @retry_under_load ? 1 : 0,
+          handshake_rate_limit: @handshake_rate_limit || 0,
+          retry_memory_percent: @retry_memory_percent,
+          request_rate_limit: @request_rate_limit || 0,
+          prefix_request_rate_limit: @request_rate_limit_per_ip || 0,
+          byte_rate_limit: @byte_rate_limit || 0,
+          prefix_byte_rate_limit: @byte_rate_limit_per_ip || 0
+        }
+      end
+
       def to_h
         {
           cert_file: @cert_file,
@@ -193,6 +364,30 @@ module Quicsilver
           value.downcase
         end
 
+        def validate_admission_limits!
+          unless @max_connections_per_ip.nil? || (@max_connections_per_ip.is_a?(Integer) && @max_connections_per_ip.positive?)
+            raise ServerConfigurationError, "max_connections_per_ip must be a positive integer or nil"
+          end
+          unless @ipv4_prefix_length.is_a?(Integer) && @ipv4_prefix_length.between?(0, 32)
+            raise ServerConfigurationError, "ipv4_prefix_length must be between 0 and 32"
+          end
+          unless @ipv6_prefix_length.is_a?(Integer) && @ipv6_prefix_length.between?(0, 128)
+            raise ServerConfigurationError, "ipv6_prefix_length must be between 0 and 128"
+          end
+          unless @retry_memory_percent.nil? || (@retry_memory_percent.is_a?(Integer) && @retry_memory_percent.between?(0, 100))
+            raise ServerConfigurationError, "retry_memory_percent must be between 0 and 100 or nil"
+          end
+          unless @handshake_rate_limit.nil? || (@handshake_rate_limit.is_a?(Integer) && @handshake_rate_limit.positive?)
+            raise ServerConfigurationError, "handshake_rate_limit must be a positive integer or nil"
+          end
+          { request_rate_limit: @request_rate_limit, request_rate_limit_per_ip: @request_rate_limit_per_ip,
+            byte_rate_limit: @byte_rate_limit, byte_rate_limit_per_ip: @byte_rate_limit_per_ip }.each do |name, value|
+            unless value.nil? || (value.is_a?(Integer) && value.positive?)
+              raise ServerConfigurationError, "#{name} must be a positive integer or nil"
+            end
+          end
+        end
+
         def validate_certificate_paths!(cert_file, key_file)
           cert_file_missing = cert_file.to_s.empty?
           key_file_missing = key_file.to_s.empty?
@@ -10,19 +10,39 @@ module Quicsilver
       # client has reset or closed the stream.
       MSQUIC_INVALID_STATE = "0x59"
 
+      # Bound on paths remembered per connection so each is pushed once.
+      MAX_PUSHED_PATHS = 1024
+
       attr_reader :handle, :data, :streams
       attr_reader :control_stream_id, :qpack_encoder_stream_id, :qpack_decoder_stream_id
       attr_reader :server_control_stream
       attr_reader :peer_goaway_id, :local_goaway_id
       attr_reader :stream_priorities
       attr_reader :remote_address, :remote_port, :session_resumed
-      def initialize(handle, data, max_header_size: nil, connection_id: nil, transport_server_id: nil)
+      attr_reader :max_push_id
+      # MemoryBudget::Account for request data held on this connection
+      attr_reader :memory
+      def initialize(handle, data, max_header_size: nil, connection_id: nil, transport_server_id: nil,
+                     spool_threshold: nil, max_body_size: nil, max_frame_payload_size: nil,
+                     coalesce_size: nil, coalesce_delay: nil, qpack_encoder: nil, compression: nil, memory: nil)
         @handle = handle
         @data = data
         @max_header_size = max_header_size
+        @spool_threshold = spool_threshold
+        @max_body_size = max_body_size
+        @max_frame_payload_size = max_frame_payload_size
+        @coalesce_size = coalesce_size
+        @coalesce_delay = coalesce_delay
+        # Shared with the server's other connections so repeated response
+        # header sets are encoded once.
+        @qpack_encoder = qpack_encoder || Protocol::Qpack::Encoder.new
+        # Protocol::ResponseCompression, also shared; nil = never compress
+        @compression = compression
+        @memory = memory || MemoryBudget.new.account
         @connection_id = hex_string(connection_id)
         @transport_server_id = transport_server_id
         @streams = {}
+        @async_bodies = {}  # stream_id => body the app writes to after returning
         @response_buffers = {}
         @mutex = Mutex.new
 
@@ -39,6 +59,12 @@ module Quicsilver
         @peer_goaway_id = nil
         @local_goaway_id = nil
         @stream_priorities = {}
+        @send_scheduler = SendScheduler.new
+        # Server push (RFC 9114 §4.6): off until the client sends MAX_PUSH_ID
+        @max_push_id = nil
+        @next_push_id = 0
+        @pushes = {}       # push_id => InboundStream carrying the pushed response
+        @pushed_paths = {} # authority + path => true, oldest first
         @session_resumed = @data[2] == true
         @remote_address = nil
         @remote_port = 0
@@ -119,6 +145,8 @@ module Quicsilver
       end
 
       def remove_stream(stream_id)
+        @send_scheduler.remove(stream_id)
+        @stream_priorities.delete(stream_id)
         @streams.delete(stream_id)
       end
 
@@ -128,17 +156,58 @@ module Quicsilver
 
       # === Data Handling ===
 
+      # Buffers past spool_threshold move to a RequestSpool, which keeps the
+      # body in a temp file instead of memory. Only bytes still in memory
+      # count against the connection's budget.
       def buffer_data(stream_id, data)
         @mutex.synchronize do
-          (@response_buffers[stream_id] ||= "".b) << data
+          buffer = (@response_buffers[stream_id] ||= Protocol::ChunkBuffer.new)
+          buffer << data
+          next unless buffer.is_a?(Protocol::ChunkBuffer)
+
+          @memory.reserve(data.bytesize)
+          if @spool_threshold && buffer.bytesize > @spool_threshold
+            @response_buffers[stream_id] = spool(buffer)
+            @memory.release(buffer.bytesize)
+          end
         end
       end
 
+      # Returns the whole stream as a String, or the RequestSpool it was
+      # moved to. Segments are joined once, here.
       def complete_stream(stream_id, final_data)
         @mutex.synchronize do
           buffer = @response_buffers.delete(stream_id)
-          (buffer || "".b) + (final_data || "".b)
+          case buffer
+          when Protocol::RequestSpool
+            begin
+              buffer << final_data if final_data && !final_data.empty?
+            rescue
+              buffer.close
+              raise
+            end
+            buffer
+          when Protocol::ChunkBuffer
+            @memory.release(buffer.bytesize)
+            (buffer << final_data).to_s
+          else
+            # Whole request in the FIN event — the common case, no copy
+            final_data&.encoding == Encoding::BINARY ? final_data : (final_data || "").b
+          end
+        end
+      end
+
+      # Drop a partially received stream's buffer (reset, connection closed).
+      def discard_buffer(stream_id)
+        buffer = @mutex.synchronize { @response_buffers.delete(stream_id) }
+        release_buffer(buffer)
+      end
+
+      def discard_buffers
+        buffers = @mutex.synchronize do
+          @response_buffers.values.tap { @response_buffers.clear }
         end
+        buffers.each { |buffer| release_buffer(buffer) }
       end
 
       # === HTTP/3 Frames ===
@@ -167,18 +236,33 @@ module Quicsilver
       # Send an informational (1xx) response before the final response.
       # RFC 9114 §4.1: encoded as a HEADERS frame, no FIN.
       def send_informational(stream, status, headers)
-        data = Protocol::ResponseEncoder.encode_informational(status, headers)
+        data = Protocol::ResponseEncoder.encode_informational(status, headers, encoder: @qpack_encoder)
         stream.send(data, fin: false)
       rescue RuntimeError => e
         raise unless stream_send_error?(e)
       end
 
-      def send_response(stream, status, headers, body, head_request: false, trailers: nil)
+      # accept_encoding is the request's accept-encoding header, for
+      # response compression.
+      def send_response(stream, status, headers, body, head_request: false, trailers: nil, accept_encoding: nil)
         body = [] if body.nil?
-        encoder = Protocol::ResponseEncoder.new(status, headers, body, head_request: head_request, trailers: trailers)
+        if @compression && accept_encoding
+          if head_request
+            headers = @compression.apply_head(status, headers, body, accept_encoding)
+          else
+            headers, body = @compression.apply(status, headers, body, accept_encoding)
+          end
+        end
+        encoder = Protocol::ResponseEncoder.new(status, headers, body, encoder: @qpack_encoder, head_request: head_request, trailers: trailers)
 
         if body.respond_to?(:to_ary)
           stream.send(encoder.encode, fin: true)
+        elsif coalesce?(headers)
+          # Timed flushes run on the shared flusher thread and never wait
+          writer = Protocol::CoalescingWriter.new(max_size: @coalesce_size, max_delay: @coalesce_delay) do |bytes, fin, wait|
+            stream.send(bytes, fin: fin, wait: wait) unless bytes.empty? && !fin
+          end
+          encoder.stream_to(writer)
         else
           encoder.stream_encode do |frame_data, fin|
             stream.send(frame_data, fin: fin) unless frame_data.empty? && !fin
@@ -191,12 +275,129 @@ module Quicsilver
         body.close if body.respond_to?(:close)
       end
 
+      # Send a response the adapter (or the response cache) already encoded
+      # as HEADERS (+ DATA).
+      def send_encoded_response(stream, data, wait: true)
+        stream.send(data, fin: true, wait: wait)
+      rescue RuntimeError => e
+        raise unless stream_send_error?(e)
+      end
+
+      # A buffered response as one HEADERS + DATA buffer, with the size of
+      # its HEADERS frame — what Server::ResponseCache stores.
+      def encode_response(status, headers, body)
+        encoder = Protocol::ResponseEncoder.new(status, headers, body, encoder: @qpack_encoder)
+        [encoder.encode, encoder.encode_headers.bytesize]
+      end
+
+      # Send HEADERS for a body the app keeps writing to after returning
+      # (Server::AsyncBody) and return immediately. Later writes go out from
+      # the writing thread; the connection only tracks the body so it can be
+      # closed when the client goes away.
+      def send_async_response(stream, status, headers, body, head_request: false)
+        encoder = Protocol::ResponseEncoder.new(status, headers, body, encoder: @qpack_encoder, head_request: head_request)
+
+        if head_request
+          stream.send(encoder.encode_headers, fin: true)
+          body.close
+          return
+        end
+
+        stream.send(encoder.encode_headers, fin: false)
+        stream_id = stream.stream_id
+        @mutex.synchronize { @async_bodies[stream_id] = body }
+        body.on_close { @mutex.synchronize { @async_bodies.delete(stream_id) } }
+        body.attach do |chunk, fin|
+          next if chunk.empty? && !fin
+
+          # Never park on send backpressure here: the event loop closes
+          # async bodies, and it would wait on the body's lock.
+          stream.send(chunk.empty? ? chunk.b : Protocol.build_frame(Protocol::FRAME_DATA, chunk), fin: fin, wait: false)
+        end
+      rescue RuntimeError => e
+        raise unless stream_send_error?(e)
+        body.close(e)
+      end
+
+      # === Server Push (RFC 9114 §4.6) ===
+
+      # True while the client's MAX_PUSH_ID leaves a push ID to promise.
+      def push_enabled?
+        @mutex.synchronize { !@max_push_id.nil? && @next_push_id <= @max_push_id }
+      end
+
+      # Send PUSH_PROMISE for a request on its stream. key (authority +
+      # path) is pushed at most once per connection. Returns the push ID,
+      # or nil if nothing was promised.
+      def promise_push(stream, field_section, key)
+        push_id = @mutex.synchronize do
+          next if @max_push_id.nil? || @next_push_id > @max_push_id || @pushed_paths.key?(key)
+
+          @pushed_paths[key] = true
+          @pushed_paths.shift if @pushed_paths.size > MAX_PUSHED_PATHS
+          @next_push_id += 1
+          @next_push_id - 1
+        end
+        return unless push_id
+
+        stream.send(Protocol.build_push_promise_frame(push_id, field_section), fin: false)
+        push_id
+      rescue RuntimeError => e
+        raise unless stream_send_error?(e)
+      end
+
+      # Open the push stream fulfilling push_id. The pushed response goes
+      # out on the returned stream like any other, after the stream header.
+      def open_push_stream(push_id)
+        quic_stream = open_stream(unidirectional: true)
+        quic_stream.send(Protocol.encode_varint(Protocol::UnidirectionalStream::PUSH) + Protocol.encode_varint(push_id))
+
+        stream = InboundStream.new(quic_stream.stream_id, is_unidirectional: true)
+        stream.stream_handle = quic_stream.handle
+        stream.push_id = push_id
+        @mutex.synchronize { @pushes[push_id] = stream }
+        stream
+      end
+
+      # Withdraw a promise: CANCEL_PUSH, and the push stream (if open) is
+      # reset with its request cancelled.
+      def cancel_push(push_id)
+        abort_push(push_id, "Push #{push_id} cancelled")
+        @server_control_stream&.send(Protocol.build_cancel_push_frame(push_id))
+      rescue RuntimeError => e
+        raise unless stream_send_error?(e)
+      end
+
+      # The push stream shut down (SHUTDOWN_COMPLETE).
+      def release_push(stream_id)
+        @mutex.synchronize { @pushes.delete_if { |_, stream| stream.stream_id == stream_id } }
+      end
+
+      def active_pushes
+        @mutex.synchronize { @pushes.size }
+      end
+
+      def async_responses
+        @mutex.synchronize { @async_bodies.size }
+      end
+
+      # The stream was reset or shut down under an async body.
+      def close_async_body(stream_id, error)
+        body = @mutex.synchronize { @async_bodies.delete(stream_id) }
+        body&.close(error)
+      end
+
+      def close_async_bodies(error)
+        bodies = @mutex.synchronize { @async_bodies.values.tap { @async_bodies.clear } }
+        bodies.each { |body| body.close(error) }
+      end
+
       def send_error(stream, status, message)
         body = ["#{status} #{message}"]
         headers = { "content-type" => "text/plain" }
         # RFC 9110 §15.6.4: 503 responses SHOULD include Retry-After
         headers["retry-after"] = "1" if status == 503
-        encoder = Protocol::ResponseEncoder.new(status, headers, body)
+        encoder = Protocol::ResponseEncoder.new(status, headers, body, encoder: @qpack_encoder)
         stream.send(encoder.encode, fin: true)
       rescue RuntimeError => e
         raise unless stream_send_error?(e)
@@ -337,18 +538,15 @@ module Quicsilver
         @stream_priorities[stream_id] || Protocol::Priority.new
       end
 
-      # Apply priority to a QUIC stream via MsQuic.
-      # MsQuic: 0 = lowest, 0xFFFF = highest.
-      # HTTP urgency: 0 = highest, 7 = lowest.
-      # Maps urgency into evenly spaced bands across the uint16 range.
-      # The priority is queued and applied on the MsQuic event thread.
+      # Apply priority to a response stream via MsQuic, urgency and
+      # incremental both (see SendScheduler). A PRIORITY_UPDATE already
+      # received for the stream wins over the request's priority header
+      # (RFC 9218 §7).
       def apply_stream_priority(stream, priority)
         handle = stream.respond_to?(:stream_handle) ? stream.stream_handle : nil
         return unless handle
-        quic_priority = (7 - priority.urgency) * 0x2000
-        Quicsilver.set_stream_priority(handle, quic_priority)
-      rescue => e
-        Quicsilver.logger.debug("Failed to set stream priority: #{e.message}")
+
+        @send_scheduler.apply(stream.stream_id, handle, @stream_priorities[stream.stream_id] || priority)
       end
 
       def uni_stream_type(stream_id)
@@ -368,9 +566,10 @@ module Quicsilver
         Quicsilver.connection_shutdown(@handle, error_code, false)
       end
 
-      # Returns QUIC transport statistics for this connection.
+      # Returns QUIC transport statistics for this connection, with the
+      # request bytes it holds.
       def stats
-        ConnectionStats.from_hash(Quicsilver.connection_statistics(@handle))
+        ConnectionStats.from_hash(Quicsilver.connection_statistics(@handle), receive_buffered_bytes: @memory.buffered)
       end
 
       def open_stream(unidirectional: false)
@@ -380,6 +579,22 @@ module Quicsilver
 
       private
 
+      def spool(buffer)
+        spool = Protocol::RequestSpool.new(max_body_size: @max_body_size, max_frame_payload_size: @max_frame_payload_size)
+        buffer.each_chunk { |chunk| spool << chunk }
+        spool
+      rescue
+        spool&.close
+        raise
+      end
+
+      def release_buffer(buffer)
+        case buffer
+        when Protocol::RequestSpool then buffer.close
+        when Protocol::ChunkBuffer then @memory.release(buffer.bytesize)
+        end
+      end
+
       def hex_string(value)
         value.unpack1("H*") if value
       end
@@ -394,6 +609,17 @@ module Quicsilver
         [@transport_server_id, connection_id, stream_id].compact.join(":")
       end
 
+      # Event streams must reach the client chunk by chunk, so they're never
+      # coalesced.
+      def coalesce?(headers)
+        return false unless @coalesce_size
+
+        headers.each do |name, value|
+          return false if name.to_s.casecmp?("content-type") && value.to_s.start_with?("text/event-stream")
+        end
+        true
+      end
+
       # Stream may have been reset by client — expected during normal operation.
       def stream_send_error?(error)
         return false unless error.message.include?(MSQUIC_INVALID_STATE) || error.message.include?("StreamSend failed")
@@ -432,18 +658,55 @@ module Quicsilver
         case type
         when Protocol::FRAME_PRIORITY_UPDATE
           parse_priority_update(payload)
-        when Protocol::FRAME_CANCEL_PUSH, Protocol::FRAME_MAX_PUSH_ID
-          # No-op: we don't implement server push (RFC 9114 §7.2.3, §7.2.7).
-          # These are valid on the control stream — accept and ignore.
+        when Protocol::FRAME_MAX_PUSH_ID
+          parse_max_push_id(payload)
+        when Protocol::FRAME_CANCEL_PUSH
+          parse_cancel_push(payload)
+        end
+      end
+
+      # RFC 9114 §7.2.7: MAX_PUSH_ID must not go down.
+      def parse_max_push_id(payload)
+        push_id, _ = Protocol.decode_varint(payload.bytes, 0)
+        @mutex.synchronize do
+          if @max_push_id && push_id < @max_push_id
+            raise Protocol::FrameError.new("MAX_PUSH_ID #{push_id} is below previous #{@max_push_id}",
+              error_code: Protocol::H3_ID_ERROR)
+          end
+          @max_push_id = push_id
         end
       end
 
+      # RFC 9114 §7.2.3: the client declines a push. A push ID never
+      # promised is a connection error.
+      def parse_cancel_push(payload)
+        push_id, _ = Protocol.decode_varint(payload.bytes, 0)
+        if @mutex.synchronize { push_id >= @next_push_id }
+          raise Protocol::FrameError.new("CANCEL_PUSH for unpromised push ID #{push_id}",
+            error_code: Protocol::H3_ID_ERROR)
+        end
+
+        abort_push(push_id, "Push #{push_id} cancelled by peer")
+      end
+
+      def abort_push(push_id, reason)
+        stream = @mutex.synchronize { @pushes.delete(push_id) }
+        return unless stream
+
+        stream.cancellation&.cancel(reason)
+        stream.reset(Protocol::H3_REQUEST_CANCELLED)
+      rescue RuntimeError => e
+        raise unless stream_send_error?(e)
+      end
+
       # RFC 9218 §7: Parse PRIORITY_UPDATE frame.
       # Payload is a stream ID varint followed by a Priority Field Value string.
       def parse_priority_update(payload)
         stream_id, consumed = Protocol.decode_varint(payload.bytes, 0)
         priority_value = payload[consumed..]
-        @stream_priorities[stream_id] = Protocol::Priority.parse(priority_value)
+        priority = Protocol::Priority.parse(priority_value)
+        @stream_priorities[stream_id] = priority
+        @send_scheduler.update(stream_id, priority)
       end
 
       # RFC 9204 §4.1.3: Validate QPACK encoder stream instructions.
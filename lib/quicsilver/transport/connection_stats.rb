@@ -31,13 +31,26 @@ module Quicsilver
       :recv_decryption_failures, :recv_valid_ack_frames,
 
       # Misc
-      :key_update_count
+      :key_update_count,
+
+      # Memory (bytes): responses MsQuic hasn't completed, and request data
+      # the server is holding (see MemoryBudget; 0 on clients)
+      :send_buffered_bytes, :receive_buffered_bytes
     ) do
-      # Build from the hash returned by the C extension.
-      def self.from_hash(hash)
+      # Build from the hash returned by the C extension, plus any values
+      # kept on the Ruby side.
+      def self.from_hash(hash, **extra)
         return nil unless hash
 
-        new(**hash.transform_keys(&:to_sym))
+        new(**hash.transform_keys(&:to_sym), **extra)
+      end
+
+      def initialize(send_buffered_bytes: 0, receive_buffered_bytes: 0, **)
+        super
+      end
+
+      def buffered_bytes
+        send_buffered_bytes + receive_buffered_bytes
       end
 
       def resumed?
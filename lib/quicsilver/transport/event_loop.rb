@@ -3,19 +3,43 @@
 module Quicsilver
   module Transport
     class EventLoop
+      # Seconds to wait for events when MsQuic has no timer pending — the
+      # same safety net the blocking poll uses.
+      MAX_FIBER_WAIT = 1.0
+
       def initialize
         @running = false
         @thread = nil
         @mutex = Mutex.new
+        @fiber_scheduler = nil
+        @spawned = []
+        @polling = false
       end
 
-      def start
+      # Without a fiber_scheduler the loop blocks in Quicsilver.poll on its
+      # own thread. With one (a callable returning a Fiber::Scheduler, built
+      # on the loop thread), the poll loop runs as a fiber under it and
+      # #spawn runs work as fibers alongside it: a fiber that waits on I/O
+      # (or on send backpressure) yields to polling instead of blocking it.
+      #
+      # A plain #start on a running loop is a no-op; starting it with a
+      # different fiber_scheduler restarts it in that mode.
+      def start(fiber_scheduler: nil)
         @mutex.synchronize do
-          return if @running
+          return if @running && (fiber_scheduler.nil? || fiber_scheduler.equal?(@fiber_scheduler))
 
+          restart_locked if @running
           @running = true
-          @thread = Thread.new do
-            Quicsilver.poll while @running
+          @fiber_scheduler = fiber_scheduler
+          @thread = if fiber_scheduler
+            Thread.new do
+              Fiber.set_scheduler(fiber_scheduler.call)
+              Fiber.schedule { run_fibers }
+            end
+          else
+            Thread.new do
+              Quicsilver.poll while @running
+            end
           end
         end
       end
@@ -29,6 +53,47 @@ module Quicsilver
       def join
         @thread&.join
       end
+
+      def fiber_scheduler?
+        !@fiber_scheduler.nil?
+      end
+
+      # Run the block in a new fiber on the loop thread. Safe to call from
+      # MsQuic callbacks: the fiber starts once the current poll returns.
+      def spawn(&block)
+        raise Error, "EventLoop#spawn requires a fiber scheduler" unless fiber_scheduler?
+
+        @spawned << block
+        Quicsilver.wake unless @polling
+      end
+
+      private
+
+      def restart_locked
+        @running = false
+        Quicsilver.wake
+        @thread&.join(2)
+      end
+
+      def run_fibers
+        events = IO.for_fd(Quicsilver.event_queue_fd, autoclose: false)
+        while @running
+          @polling = true
+          wait_ms = begin
+            Quicsilver.poll_nowait
+          ensure
+            @polling = false
+          end
+
+          Fiber.schedule(&@spawned.shift) until @spawned.empty?
+
+          if wait_ms == 0
+            sleep 0 # let ready fibers run, then poll again
+          else
+            events.wait_readable(wait_ms ? wait_ms / 1000.0 : MAX_FIBER_WAIT)
+          end
+        end
+      end
     end
   end
 
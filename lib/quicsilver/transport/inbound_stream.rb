@@ -5,12 +5,28 @@ module Quicsilver
     class InboundStream
       attr_reader :stream_id, :is_unidirectional, :buffer
       attr_accessor :stream_handle
+      # Protocol::RequestSpool holding the body when it was too large to
+      # buffer in memory; #data then holds only the HEADERS frames.
+      attr_accessor :body_spool
+      # Server::Cancellation fired if the client gives up on the request.
+      attr_accessor :cancellation
+      # Monotonic time the request was handed to the worker queue.
+      attr_accessor :arrived_at
+      # Server::ResponseCache::Fill this request's response completes.
+      attr_accessor :cache_fill
+      # Push ID when this is a server push stream carrying a pushed response.
+      attr_accessor :push_id
 
       def initialize(stream_id, is_unidirectional: nil)
         @stream_id = stream_id
         @is_unidirectional = is_unidirectional.nil? ? !bidirectional? : is_unidirectional
         @buffer = StringIO.new.tap { |io| io.set_encoding(Encoding::ASCII_8BIT) }
         @stream_handle = nil
+        @body_spool = nil
+        @cancellation = nil
+        @arrived_at = nil
+        @cache_fill = nil
+        @push_id = nil
       end
 
       def bidirectional?
@@ -29,9 +45,15 @@ module Quicsilver
         @buffer.string
       end
 
-      def send(data, fin: false)
+      # wait: false skips send backpressure — for writers that hold a lock
+      # the event loop may need (see Server::AsyncBody).
+      def send(data, fin: false, wait: true)
         return unless writable?
-        Quicsilver.send_stream(@stream_handle, data, fin)
+        if wait
+          Quicsilver.send_stream(@stream_handle, data, fin)
+        else
+          Quicsilver.send_stream(@stream_handle, data, fin, false, false)
+        end
       end
 
       def reset(error_code = Protocol::H3_REQUEST_CANCELLED)
@@ -0,0 +1,185 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  module Transport
+    # Byte accounting for what a server holds on its peers' behalf: request
+    # data buffered until FIN, partial frames, streamed request bodies the
+    # app hasn't read yet, and response bytes MsQuic hasn't completed
+    # (Quicsilver.send_buffered). One budget per server, one Account per
+    # connection.
+    #
+    # A budget is enforced in steps, from the level reached after data
+    # arrives on a stream:
+    #
+    #   :ok     within budget
+    #   :pause  over budget — streamed request bodies stop being read from
+    #           the peer, so QUIC flow control holds the client back
+    #   :reset  over RESET_RATIO × budget — the stream that brought the
+    #           data is reset with H3_EXCESSIVE_LOAD
+    #   :close  over CLOSE_RATIO × budget — the connection is closed
+    #
+    # The higher of the connection's and the server's level applies. Past
+    # :pause, the server's level only applies to connections holding more
+    # than an even share of the server budget, so the heavy users are reset
+    # or closed rather than whichever connection received data next. Bytes
+    # are counted with or without budgets, for stats.
+    class MemoryBudget
+      RESET_RATIO = 1.5
+      CLOSE_RATIO = 2
+      LEVELS = %i[ok pause reset close].freeze
+
+      attr_reader :limit, :connection_limit
+
+      def initialize(limit: nil, connection_limit: nil)
+        @limit = limit
+        @connection_limit = connection_limit
+        @buffered = 0
+        @peak = 0
+        @streams_reset = 0
+        @connections_closed = 0
+        @accounts = 0
+        @mutex = Mutex.new
+      end
+
+      def account(connection_handle = nil)
+        @mutex.synchronize { @accounts += 1 }
+        Account.new(self, connection_handle)
+      end
+
+      # Open accounts, i.e. connections.
+      def accounts
+        @mutex.synchronize { @accounts }
+      end
+
+      # Received bytes held across all connections.
+      def buffered
+        @mutex.synchronize { @buffered }
+      end
+
+      def enforced?
+        !@limit.nil? || !@connection_limit.nil?
+      end
+
+      def level(account)
+        return :ok unless enforced?
+
+        held = account.buffered + account.send_buffered
+        step = @connection_limit ? step_for(held, @connection_limit) : 0
+        if @limit
+          server_step = step_for(buffered + Quicsilver.send_buffered, @limit)
+          server_step = 1 if server_step > 1 && held <= fair_share
+          step = server_step if server_step > step
+        end
+        LEVELS[step]
+      end
+
+      # Count a :reset or :close carried out by the server.
+      def enforced!(level)
+        @mutex.synchronize do
+          case level
+          when :reset then @streams_reset += 1
+          when :close then @connections_closed += 1
+          end
+        end
+      end
+
+      def to_h
+        @mutex.synchronize do
+          {
+            "limit" => @limit,
+            "connection_limit" => @connection_limit,
+            "receive_buffered" => @buffered,
+            "receive_peak" => @peak,
+            "streams_reset" => @streams_reset,
+            "connections_closed" => @connections_closed
+          }
+        end
+      end
+
+      def closed(account) # :nodoc:
+        @mutex.synchronize { @accounts -= 1 }
+      end
+
+      def adjust(bytes) # :nodoc:
+        @mutex.synchronize do
+          @buffered += bytes
+          @peak = @buffered if @buffered > @peak
+        end
+      end
+
+      # Received bytes held for one connection. Charged on the poll thread,
+      # released by whichever thread consumes the data. Releases never go
+      # below zero, so a late release after #close is harmless.
+      class Account
+        def initialize(budget, connection_handle)
+          @budget = budget
+          @connection_handle = connection_handle
+          @buffered = 0
+          @closed = false
+          @mutex = Mutex.new
+        end
+
+        def buffered
+          @mutex.synchronize { @buffered }
+        end
+
+        # Response bytes MsQuic still holds for this connection.
+        def send_buffered
+          @connection_handle ? Quicsilver.connection_send_inflight(@connection_handle) || 0 : 0
+        end
+
+        def reserve(bytes)
+          return if bytes <= 0
+
+          @mutex.synchronize { @buffered += bytes }
+          @budget.adjust(bytes)
+        end
+
+        def release(bytes)
+          return if bytes <= 0
+
+          released = @mutex.synchronize do
+            bytes = @buffered if bytes > @buffered
+            @buffered -= bytes
+            bytes
+          end
+          @budget.adjust(-released)
+        end
+
+        # Charge or release the change in a buffer's size.
+        def adjust(delta)
+          delta.negative? ? release(-delta) : reserve(delta)
+        end
+
+        def level
+          @budget.level(self)
+        end
+
+        def over_budget?
+          level != :ok
+        end
+
+        # The connection closed: whatever it still held is gone.
+        def close
+          was_closed = @mutex.synchronize { @closed.tap { @closed = true } }
+          release(buffered)
+          @budget.closed(self) unless was_closed
+        end
+      end
+
+      private
+
+      def fair_share
+        @limit / [accounts, 1].max
+      end
+
+      def step_for(bytes, limit)
+        if bytes > limit * CLOSE_RATIO then 3
+        elsif bytes > limit * RESET_RATIO then 2
+        elsif bytes > limit then 1
+        else 0
+        end
+      end
+    end
+  end
+end
@@ -0,0 +1,78 @@
+# frozen_string_literal: true
+
+module Quicsilver
+  module Transport
+    # Orders a connection's response streams for MsQuic's sender by their
+    # RFC 9218 priority. MsQuic sends strictly by 16-bit stream priority,
+    # highest first, and — with the round-robin scheme the extension sets
+    # on server connections — streams of equal priority take turns a fixed
+    # batch of packets at a time.
+    #
+    # Each urgency gets a BAND of values, urgency 0 on top. Within a band,
+    # non-incremental streams come first and go one after another in
+    # stream order: each gets its own value, earlier streams higher.
+    # Incremental streams share the bottom value of the band, so they are
+    # interleaved (RFC 9218 §10). A PRIORITY_UPDATE for a stream that is
+    # already sending moves it (#update).
+    class SendScheduler
+      BAND = 0x2000
+      # Distinct values for sequential (non-incremental) streams per band;
+      # stream order wraps around past this many.
+      SEQUENTIAL_SLOTS = 0x1000
+
+      def self.quic_priority(stream_id, priority)
+        band = (Protocol::Priority::MAX_URGENCY - priority.urgency) * BAND
+        return band if priority.incremental
+
+        band + (2 * SEQUENTIAL_SLOTS) - 1 - ((stream_id >> 2) % SEQUENTIAL_SLOTS)
+      end
+
+      def initialize
+        @streams = {} # stream_id => [handle, quic priority]
+        @mutex = Mutex.new
+      end
+
+      # Set the priority of a response stream and keep it for updates.
+      def apply(stream_id, handle, priority)
+        quic_priority = self.class.quic_priority(stream_id, priority)
+        @mutex.synchronize { @streams[stream_id] = [handle, quic_priority] }
+        set(handle, quic_priority)
+      end
+
+      # Re-sort a stream still sending after a PRIORITY_UPDATE. Returns
+      # true if it moved; streams not sending yet pick the update up when
+      # their response starts.
+      def update(stream_id, priority)
+        quic_priority = self.class.quic_priority(stream_id, priority)
+        handle = @mutex.synchronize do
+          entry = @streams[stream_id]
+          next unless entry && entry[1] != quic_priority
+
+          entry[1] = quic_priority
+          entry[0]
+        end
+        return false unless handle
+
+        set(handle, quic_priority)
+        true
+      end
+
+      def remove(stream_id)
+        @mutex.synchronize { @streams.delete(stream_id) }
+      end
+
+      def size
+        @mutex.synchronize { @streams.size }
+      end
+
+      private
+
+      # The priority is queued and applied on the MsQuic event thread.
+      def set(handle, quic_priority)
+        Quicsilver.set_stream_priority(handle, quic_priority)
+      rescue => e
+        Quicsilver.logger.debug("Failed to set stream priority: #{e.message}")
+      end
+    end
+  end
+end
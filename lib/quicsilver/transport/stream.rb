@@ -18,8 +18,14 @@ module Quicsilver
         Quicsilver.get_stream_id(@handle)
       end
 
-      def send(data, fin: false)
-        Quicsilver.send_stream(@handle, data, fin)
+      # early_data: true allows the data to go out in 0-RTT packets while a
+      # resumed connection is still handshaking.
+      def send(data, fin: false, early_data: false)
+        if early_data
+          Quicsilver.send_stream(@handle, data, fin, true)
+        else
+          Quicsilver.send_stream(@handle, data, fin)
+        end
       end
 
       def reset(error_code = Protocol::H3_REQUEST_CANCELLED)
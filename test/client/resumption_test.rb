@@ -109,4 +109,51 @@ class ClientResumptionTest < Minitest::Test
     client1&.disconnect
     client2&.disconnect
   end
+
+  def test_clients_sharing_a_ticket_store_resume_each_other
+    store = Quicsilver::Client::MemoryTicketStore.new
+    client1 = Quicsilver::Client.new("127.0.0.1", @port, unsecure: true, ticket_store: store)
+    client1.open_connection
+    client1.get("/")
+    client1.disconnect
+
+    refute_nil store.fetch(client1.ticket_key), "Ticket should be written to the store"
+
+    sleep 0.1
+
+    client2 = Quicsilver::Client.new("127.0.0.1", @port, unsecure: true, ticket_store: store)
+    client2.open_connection
+    response = client2.get("/")
+
+    assert_equal 200, response.status
+    assert client2.stats.resumed?, "Fresh client should resume from the shared ticket store"
+  ensure
+    client1&.disconnect
+    client2&.disconnect
+  end
+  def test_resumed_request_is_sent_as_early_data
+    app = ->(env) { [200, { "content-type" => "text/plain" }, [env["HTTP_QUICSILVER_EARLY_DATA"].to_s]] }
+    @server.stop
+    @server_thread.join(2)
+    config = Quicsilver::Transport::Configuration.new(cert_file_path, key_file_path)
+    @server = Quicsilver::Server.new(@port, app: app, server_configuration: config)
+    @server_thread = Thread.new { @server.start }
+    wait_for_server(@server)
+
+    client = Quicsilver::Client.new("127.0.0.1", @port, unsecure: true)
+    assert_equal "false", client.get("/").body
+    client.disconnect
+
+    sleep 0.1
+
+    # No explicit open_connection — the GET opens the connection and rides in 0-RTT
+    request = client.build_request("GET", "/")
+    assert request.early_data?
+    response = request.response
+
+    assert_equal 200, response.status
+    assert_equal "true", response.body
+  ensure
+    client&.disconnect
+  end
 end
@@ -0,0 +1,113 @@
+# frozen_string_literal: true
+
+require "test_helper"
+require "tmpdir"
+
+class TicketStoreTest < Minitest::Test
+  parallelize_me!
+
+  def test_key_includes_host_port_and_alpn
+    assert_equal "example.com:443:h3", Quicsilver::Client::TicketStore.key_for("example.com", 443, "h3")
+  end
+
+  def test_client_ticket_key
+    client = Quicsilver::Client.new("example.com", 8443)
+    assert_equal "example.com:8443:h3", client.ticket_key
+  end
+
+  def test_client_has_no_ticket_store_by_default
+    assert_nil Quicsilver::Client.new("example.com").ticket_store
+  end
+
+  def test_client_accepts_ticket_store
+    store = Quicsilver::Client::MemoryTicketStore.new
+    assert_same store, Quicsilver::Client.new("example.com", ticket_store: store).ticket_store
+  end
+
+  def test_pool_shares_one_store_by_default
+    pool = Quicsilver::Client::ConnectionPool.new
+    assert_kind_of Quicsilver::Client::MemoryTicketStore, pool.ticket_store
+  end
+
+  def test_memory_store_round_trip
+    store = Quicsilver::Client::MemoryTicketStore.new
+    store.store("a:1:h3", "ticket".b)
+    assert_equal "ticket".b, store.fetch("a:1:h3")
+    assert_nil store.fetch("b:1:h3")
+  end
+
+  def test_memory_store_ignores_empty_tickets
+    store = Quicsilver::Client::MemoryTicketStore.new
+    store.store("a:1:h3", nil)
+    store.store("a:1:h3", "")
+    assert_equal 0, store.size
+  end
+
+  def test_memory_store_evicts_least_recently_used
+    store = Quicsilver::Client::MemoryTicketStore.new(max_size: 2)
+    store.store("a", "1")
+    store.store("b", "2")
+    store.fetch("a") # a is now most recent
+    store.store("c", "3")
+
+    assert_equal "1", store.fetch("a")
+    assert_nil store.fetch("b")
+    assert_equal "3", store.fetch("c")
+  end
+
+  def test_memory_store_expires_entries
+    store = Quicsilver::Client::MemoryTicketStore.new(max_age: -1)
+    store.store("a", "1")
+    assert_nil store.fetch("a")
+  end
+
+  def test_memory_store_delete
+    store = Quicsilver::Client::MemoryTicketStore.new
+    store.store("a", "1")
+    store.delete("a")
+    assert_nil store.fetch("a")
+  end
+
+  def test_file_store_persists_across_instances
+    Dir.mktmpdir do |dir|
+      path = File.join(dir, "tickets")
+      ticket = (0..255).map(&:chr).join.b
+
+      Quicsilver::Client::FileTicketStore.new(path).store("a:1:h3", ticket)
+
+      assert_equal ticket, Quicsilver::Client::FileTicketStore.new(path).fetch("a:1:h3")
+      assert_equal 0o600, File.stat(path).mode & 0o777
+    end
+  end
+
+  def test_file_store_sees_writes_from_other_instances
+    Dir.mktmpdir do |dir|
+      path = File.join(dir, "tickets")
+      reader = Quicsilver::Client::FileTicketStore.new(path)
+      writer = Quicsilver::Client::FileTicketStore.new(path)
+
+      assert_nil reader.fetch("a")
+      writer.store("a", "1")
+      writer.store("b", "2")
+
+      assert_equal "1", reader.fetch("a")
+      assert_equal "2", reader.fetch("b")
+    end
+  end
+
+  def test_file_store_skips_corrupt_lines
+    Dir.mktmpdir do |dir|
+      path = File.join(dir, "tickets")
+      File.write(path, "garbage\nb\t#{Time.now.to_f + 60}\t#{["2"].pack("m0")}\n")
+
+      store = Quicsilver::Client::FileTicketStore.new(path)
+      assert_equal "2", store.fetch("b")
+    end
+  end
+
+  def test_file_store_tolerates_unwritable_path
+    store = Quicsilver::Client::FileTicketStore.new("/proc/quicsilver/tickets")
+    store.store("a", "1")
+    assert_nil store.fetch("b")
+  end
+end
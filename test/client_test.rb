@@ -80,6 +80,44 @@ class ClientTest < Minitest::Test
     assert_kind_of Quicsilver::Error, err
     assert_equal 0x59, err.status
   end
+
+  def test_early_data_eligible_for_small_safe_requests
+    client = Quicsilver::Client.new("localhost", 4433)
+
+    assert client.send(:early_data_eligible?, "GET", "/", {}, nil)
+    assert client.send(:early_data_eligible?, "OPTIONS", "/", {}, nil)
+    refute client.send(:early_data_eligible?, "PUT", "/items/1", {}, "x" * 100)
+    refute client.send(:early_data_eligible?, "DELETE", "/items/1", {}, nil)
+    refute client.send(:early_data_eligible?, "POST", "/", {}, nil)
+    refute client.send(:early_data_eligible?, "PATCH", "/", {}, nil)
+  end
+
+  def test_idempotent_early_data_methods_are_opt_in
+    client = Quicsilver::Client.new("localhost", 4433, early_data_methods: %w[GET PUT])
+
+    assert client.send(:early_data_eligible?, "PUT", "/items/1", {}, "x" * 100)
+    refute client.send(:early_data_eligible?, "DELETE", "/items/1", {}, nil)
+  end
+
+  def test_early_data_not_eligible_for_large_or_streamed_bodies
+    client = Quicsilver::Client.new("localhost", 4433, max_early_data_size: 1024, early_data_methods: %w[PUT])
+
+    refute client.send(:early_data_eligible?, "PUT", "/", {}, "x" * 2048)
+    refute client.send(:early_data_eligible?, "PUT", "/", {}, :stream)
+  end
+
+  def test_early_data_sizes_array_bodies_as_sent
+    client = Quicsilver::Client.new("localhost", 4433, max_early_data_size: 1024, early_data_methods: %w[PUT])
+
+    assert client.send(:early_data_eligible?, "PUT", "/", {}, ["x"] * 400)
+    refute client.send(:early_data_eligible?, "PUT", "/", {}, ["x" * 600] * 2)
+  end
+
+  def test_early_data_can_be_disabled
+    client = Quicsilver::Client.new("localhost", 4433, early_data: false)
+
+    refute client.send(:early_data_eligible?, "GET", "/", {}, nil)
+  end
 end
 
 class ClientOpenStreamErrorTest < Minitest::Test
@@ -59,6 +59,78 @@ class ConnectionTest < Minitest::Test
     assert_equal "\x01\x02\x03\x04".b, result.b
   end
 
+  def test_buffer_data_spools_past_threshold
+    conn = Quicsilver::Transport::Connection.new(12345, [12345, 67890], spool_threshold: 64)
+    request = Quicsilver::Protocol::RequestEncoder.new(method: "POST", path: "/", body: "z" * 200, encoder: qpack_encoder).encode
+    conn.buffer_data(4, request.byteslice(0, 100))
+    result = conn.complete_stream(4, request.byteslice(100..))
+
+    assert_instance_of Quicsilver::Protocol::RequestSpool, result
+    assert_equal 200, result.body_size
+  ensure
+    result.close if result.respond_to?(:close)
+  end
+
+  def test_buffer_data_below_threshold_stays_in_memory
+    conn = Quicsilver::Transport::Connection.new(12345, [12345, 67890], spool_threshold: 64)
+    conn.buffer_data(4, "small".b)
+
+    assert_equal "small!".b, conn.complete_stream(4, "!".b)
+  end
+
+  def test_buffered_request_data_counts_against_memory_account
+    account = Quicsilver::Transport::MemoryBudget.new.account
+    conn = Quicsilver::Transport::Connection.new(12345, [12345, 67890], memory: account)
+    conn.buffer_data(4, "abcd".b)
+    conn.buffer_data(8, "efgh".b)
+    assert_equal 8, account.buffered
+
+    conn.complete_stream(4, "!".b)
+    assert_equal 4, account.buffered
+    conn.discard_buffers
+    assert_equal 0, account.buffered
+  end
+
+  def test_spooled_request_data_leaves_memory_account
+    account = Quicsilver::Transport::MemoryBudget.new.account
+    conn = Quicsilver::Transport::Connection.new(12345, [12345, 67890], spool_threshold: 64, memory: account)
+    request = Quicsilver::Protocol::RequestEncoder.new(method: "POST", path: "/", body: "z" * 200, encoder: qpack_encoder).encode
+    conn.buffer_data(4, request.byteslice(0, 100))
+    conn.buffer_data(4, request.byteslice(100..))
+
+    assert_equal 0, account.buffered
+  ensure
+    conn&.discard_buffers
+  end
+
+  def test_send_response_coalesces_enumerable_body
+    conn = Quicsilver::Transport::Connection.new(12345, [12345, 67890], coalesce_size: 1024, coalesce_delay: nil)
+    stream = recording_stream
+    conn.send_response(stream, 200, { "content-type" => "text/html" }, %w[<p> hi </p>].each)
+
+    assert_equal 1, stream.sent.size
+    assert stream.sent[0][1]
+    assert_equal "<p>hi</p>", parse_response(stream.sent[0][0]).body.read
+  end
+
+  def test_send_response_never_coalesces_event_streams
+    conn = Quicsilver::Transport::Connection.new(12345, [12345, 67890], coalesce_size: 1024, coalesce_delay: nil)
+    stream = recording_stream
+    conn.send_response(stream, 200, { "Content-Type" => "text/event-stream" }, ["data: 1\n\n", "data: 2\n\n"].each)
+
+    assert_equal 3, stream.sent.size, "HEADERS, then each event in its own send"
+  end
+
+  def test_connections_share_the_qpack_encoder
+    encoder = Quicsilver::Protocol::Qpack::Encoder.new
+    2.times do |i|
+      conn = Quicsilver::Transport::Connection.new(i, [i, 67890], qpack_encoder: encoder)
+      conn.send_response(recording_stream, 200, { "content-type" => "text/html" }, ["hi"])
+    end
+
+    assert_equal 1, encoder.cache_sizes["blocks"]
+  end
+
   # === Control stream validation (#7, #8, #9) ===
 
   def test_complete_stream_returns_binary_encoding
@@ -532,6 +604,33 @@ class ConnectionTest < Minitest::Test
     refute priority.incremental
   end
 
+  def test_priority_update_resorts_a_stream_already_sending
+    stream = Quicsilver::Transport::InboundStream.new(4)
+    stream.stream_handle = 0xA
+    set = []
+
+    Quicsilver.stub(:set_stream_priority, ->(handle, value) { set << [handle, value] }) do
+      @connection.apply_stream_priority(stream, Quicsilver::Protocol::Priority.new)
+      @connection.set_control_stream(1, build_settings_frame + build_priority_update_frame(4, "u=1, i"))
+    end
+
+    expected = Quicsilver::Transport::SendScheduler.quic_priority(4, Quicsilver::Protocol::Priority.parse("u=1, i"))
+    assert_equal [0xA, expected], set.last
+  end
+
+  def test_priority_update_received_first_wins_over_the_header
+    stream = Quicsilver::Transport::InboundStream.new(8)
+    stream.stream_handle = 0xA
+    set = []
+
+    Quicsilver.stub(:set_stream_priority, ->(handle, value) { set << value }) do
+      @connection.set_control_stream(1, build_settings_frame + build_priority_update_frame(8, "u=6"))
+      @connection.apply_stream_priority(stream, Quicsilver::Protocol::Priority.parse("u=0"))
+    end
+
+    assert_equal [Quicsilver::Transport::SendScheduler.quic_priority(8, Quicsilver::Protocol::Priority.new(urgency: 6))], set
+  end
+
   # === Stream accounting ===
 
   def test_active_request_streams_counts_client_bidirectional_streams
@@ -619,13 +718,16 @@ class ConnectionTest < Minitest::Test
     assert_equal Quicsilver::Protocol::H3_STREAM_CREATION_ERROR, error.error_code
   end
 
-  def test_cancel_push_accepted_on_control_stream
-    # CANCEL_PUSH (0x03) is valid on control stream — should not raise
+  def test_cancel_push_for_unpromised_push_id_is_id_error
+    # RFC 9114 §7.2.3: CANCEL_PUSH is valid on the control stream, but only
+    # for push IDs the server has promised
     cancel_push_frame = encode_varint(Quicsilver::Protocol::FRAME_CANCEL_PUSH) +
                         encode_varint(1) + "\x00".b
     data = build_settings_frame + cancel_push_frame
-    @connection.set_control_stream(1, data)  # should not raise
-    assert @connection.control_stream_id
+    error = assert_raises(Quicsilver::Protocol::FrameError) do
+      @connection.set_control_stream(1, data)
+    end
+    assert_equal Quicsilver::Protocol::H3_ID_ERROR, error.error_code
   end
 
   def test_max_push_id_accepted_on_control_stream
@@ -637,6 +739,66 @@ class ConnectionTest < Minitest::Test
     assert @connection.control_stream_id
   end
 
+  # === Server push ===
+
+  def test_push_disabled_until_max_push_id
+    refute @connection.push_enabled?
+    assert_nil @connection.promise_push(push_request_stream, "".b, "localhost/app.css")
+
+    open_push_control_stream(Quicsilver::Protocol.build_max_push_id_frame(1))
+
+    assert_equal 1, @connection.max_push_id
+    assert @connection.push_enabled?
+  end
+
+  def test_max_push_id_must_not_decrease
+    open_push_control_stream(Quicsilver::Protocol.build_max_push_id_frame(5))
+
+    error = assert_raises(Quicsilver::Protocol::FrameError) do
+      @connection.receive_unidirectional_data(2, Quicsilver::Protocol.build_max_push_id_frame(4))
+    end
+    assert_equal Quicsilver::Protocol::H3_ID_ERROR, error.error_code
+  end
+
+  def test_promise_push_up_to_max_push_id_once_per_path
+    open_push_control_stream(Quicsilver::Protocol.build_max_push_id_frame(1))
+    sent = []
+
+    Quicsilver.stub(:send_stream, ->(_handle, data, *) { sent << data }) do
+      assert_equal 0, @connection.promise_push(push_request_stream, "section".b, "localhost/app.css")
+      assert_nil @connection.promise_push(push_request_stream, "section".b, "localhost/app.css")
+      assert_equal 1, @connection.promise_push(push_request_stream, "section".b, "localhost/app.js")
+      assert_nil @connection.promise_push(push_request_stream, "section".b, "localhost/logo.svg")
+    end
+
+    refute @connection.push_enabled?
+    assert_equal Quicsilver::Protocol.build_push_promise_frame(0, "section".b), sent.first
+  end
+
+  def test_cancel_push_from_client_resets_push_stream
+    open_push_control_stream(Quicsilver::Protocol.build_max_push_id_frame(8))
+    resets = []
+
+    push_stream = Quicsilver.stub(:send_stream, ->(*) {}) do
+      Quicsilver.stub(:open_stream, ->(*) { 0xD00D }) do
+        Quicsilver.stub(:get_stream_id, ->(*) { 15 }) do
+          @connection.promise_push(push_request_stream, "".b, "localhost/app.css")
+          @connection.open_push_stream(0)
+        end
+      end
+    end
+    push_stream.cancellation = Quicsilver::Server::Cancellation.new
+
+    Quicsilver.stub(:stream_reset, ->(handle, code) { resets << [handle, code] }) do
+      @connection.receive_unidirectional_data(2, Quicsilver::Protocol.build_cancel_push_frame(0))
+    end
+
+    assert_equal 0, push_stream.push_id
+    assert_equal [[0xD00D, Quicsilver::Protocol::H3_REQUEST_CANCELLED]], resets
+    assert push_stream.cancellation.cancelled?
+    assert_equal 0, @connection.active_pushes
+  end
+
   def test_datagram_send_requires_peer_settings
     # Connection without SETTINGS_H3_DATAGRAM should reject datagram_send
     # (settings hash is empty by default)
@@ -648,7 +810,8 @@ class ConnectionTest < Minitest::Test
     # We can't easily test the wire output without a real stream,
     # but we verify the ResponseEncoder receives the header
     encoder = Quicsilver::Protocol::ResponseEncoder.new(
-      503, { "content-type" => "text/plain", "retry-after" => "1" }, ["503 Service Unavailable"]
+      503, { "content-type" => "text/plain", "retry-after" => "1" }, ["503 Service Unavailable"],
+      encoder: qpack_encoder
     )
     data = encoder.encode
     parser = Quicsilver::Protocol::ResponseParser.new(data)
@@ -659,6 +822,20 @@ class ConnectionTest < Minitest::Test
 
   private
 
+  RecordingStream = Struct.new(:sent) do
+    def send(data, fin: false)
+      sent << [data, fin]
+    end
+  end
+
+  def recording_stream
+    RecordingStream.new([])
+  end
+
+  def parse_response(data)
+    Quicsilver::Protocol::ResponseParser.new(data).tap(&:parse)
+  end
+
   def encode_varint(value)
     Quicsilver::Protocol.encode_varint(value)
   end
@@ -681,6 +858,16 @@ class ConnectionTest < Minitest::Test
       settings_payload
   end
 
+  def open_push_control_stream(frames)
+    @connection.receive_unidirectional_data(2, "\x00".b + build_settings_frame + frames)
+  end
+
+  def push_request_stream
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+    stream
+  end
+
   def build_unidirectional_stream(type)
     stream = Quicsilver::Transport::InboundStream.new(3, is_unidirectional: true) # odd stream_id = uni
     stream.append_data([type].pack("C"))
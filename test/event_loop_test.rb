@@ -55,6 +55,45 @@ class EventLoopTest < Minitest::Test
     end
   end
 
+  def test_spawn_requires_a_fiber_scheduler
+    loop_instance = Quicsilver::Transport::EventLoop.new
+
+    refute loop_instance.fiber_scheduler?
+    assert_raises(Quicsilver::Error) { loop_instance.spawn {} }
+  end
+
+  def test_fiber_mode_runs_spawned_work_on_the_loop_thread
+    begin
+      require "async"
+    rescue LoadError
+      skip "async gem not available"
+    end
+
+    reader, writer = IO.pipe
+    loop_instance = Quicsilver::Transport::EventLoop.new
+    ran_on = Queue.new
+
+    Quicsilver.stub(:event_queue_fd, reader.fileno) do
+      Quicsilver.stub(:poll_nowait, -> { reader.read_nonblock(64, exception: false); nil }) do
+        Quicsilver.stub(:wake, -> { writer.write(".") }) do
+          loop_instance.start(fiber_scheduler: -> { Async::Scheduler.new })
+          assert loop_instance.fiber_scheduler?
+
+          loop_instance.spawn { ran_on << [Thread.current, Fiber.current.blocking?] }
+          thread, blocking = ran_on.pop(timeout: 2)
+
+          assert_same loop_instance.instance_variable_get(:@thread), thread
+          refute blocking, "spawned work should run in a non-blocking fiber"
+        ensure
+          loop_instance.stop
+        end
+      end
+    end
+  ensure
+    reader&.close
+    writer&.close
+  end
+
   private
 
   def create_server(port)
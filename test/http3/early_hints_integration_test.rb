@@ -85,7 +85,8 @@ class EarlyHintsIntegrationTest < Minitest::Test
 
   def simulate_request(app, sent_frames)
     request_data = Quicsilver::Protocol::RequestEncoder.new(
-      method: "GET", path: "/", scheme: "https", authority: "localhost:4433"
+      method: "GET", path: "/", scheme: "https", authority: "localhost:4433",
+      encoder: qpack_encoder
     ).encode
 
     stream = Quicsilver::Transport::InboundStream.new(4)
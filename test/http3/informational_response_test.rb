@@ -125,11 +125,11 @@ class InformationalResponseTest < Minitest::Test
   private
 
   def encode_informational(status, headers)
-    Quicsilver::Protocol::ResponseEncoder.encode_informational(status, headers)
+    Quicsilver::Protocol::ResponseEncoder.encode_informational(status, headers, encoder: qpack_encoder)
   end
 
   def encode_final(status, headers, body)
-    Quicsilver::Protocol::ResponseEncoder.new(status, headers, body).encode
+    Quicsilver::Protocol::ResponseEncoder.new(status, headers, body, encoder: qpack_encoder).encode
   end
 
   def parse_frames(data)
@@ -180,7 +180,8 @@ class RequestEncoderTest < Minitest::Test
       scheme: scheme,
       authority: authority,
       headers: headers,
-      body: body
+      body: body,
+      encoder: qpack_encoder
     )
   end
 
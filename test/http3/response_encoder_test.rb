@@ -335,6 +335,20 @@ class ResponseEncoderTest < Minitest::Test
     assert_equal "abc123", parser.trailers["x-checksum"]
   end
 
+  def test_stream_to_coalesces_chunks_with_trailers
+    enc = encoder(200, { "content-type" => "text/plain" }, ["chunk1", "chunk2", "chunk3"],
+                  trailers: { "x-checksum" => "abc123" })
+    sent = []
+    writer = Quicsilver::Protocol::CoalescingWriter.new(max_size: 1024, max_delay: nil) { |data, fin| sent << [data, fin] }
+    enc.stream_to(writer)
+
+    assert_equal 1, sent.size, "HEADERS, body and trailers should go out in one send"
+    assert sent[0][1]
+    parser = parse_response(sent[0][0])
+    assert_equal "chunk1chunk2chunk3", parser.body.read
+    assert_equal "abc123", parser.trailers["x-checksum"]
+  end
+
   def test_encode_without_trailers_unchanged
     data = encoder(200, {}, ["body"]).encode
     parser = parse_response(data)
@@ -396,7 +410,7 @@ class ResponseEncoderTest < Minitest::Test
   end
 
   def encoder(status, headers, body, head_request: false, trailers: nil)
-    Quicsilver::Protocol::ResponseEncoder.new(status, headers, body, head_request: head_request, trailers: trailers)
+    Quicsilver::Protocol::ResponseEncoder.new(status, headers, body, head_request: head_request, trailers: trailers, encoder: qpack_encoder)
   end
 
   def parse_response(data)
@@ -424,7 +438,7 @@ class ResponseEncoderTest < Minitest::Test
 
   def test_auto_content_length_for_array_body
     body = ["hello", " world"]
-    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, {}, body)
+    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, {}, body, encoder: qpack_encoder)
     data = encoder.encode
     parser = parse_response(data)
     assert_equal "11", parser.headers["content-length"]
@@ -432,14 +446,14 @@ class ResponseEncoderTest < Minitest::Test
 
   def test_no_auto_content_length_when_already_set
     body = ["hello"]
-    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, { "content-length" => "5" }, body)
+    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, { "content-length" => "5" }, body, encoder: qpack_encoder)
     data = encoder.encode
     parser = parse_response(data)
     assert_equal "5", parser.headers["content-length"]
   end
 
   def test_no_auto_content_length_for_204
-    encoder = Quicsilver::Protocol::ResponseEncoder.new(204, {}, [])
+    encoder = Quicsilver::Protocol::ResponseEncoder.new(204, {}, [], encoder: qpack_encoder)
     data = encoder.encode
     parser = parse_response(data)
     assert_nil parser.headers["content-length"]
@@ -447,7 +461,7 @@ class ResponseEncoderTest < Minitest::Test
 
   def test_no_auto_content_length_for_head_request
     body = ["hello"]
-    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, {}, body, head_request: true)
+    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, {}, body, head_request: true, encoder: qpack_encoder)
     data = encoder.encode
     parser = parse_response(data)
     # HEAD responses should not auto-set content-length from body
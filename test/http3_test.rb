@@ -207,7 +207,7 @@ class HTTP3Test < Minitest::Test
   # control stream SETTINGS), not per response — matching quiche's behaviour.
   # ResponseEncoder no longer includes GREASE frames.
   def test_response_does_not_include_grease_frame
-    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, { "content-type" => "text/plain" }, ["hello"])
+    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, { "content-type" => "text/plain" }, ["hello"], encoder: qpack_encoder)
     data = encoder.encode
 
     frames = parse_frames(data)
@@ -216,7 +216,7 @@ class HTTP3Test < Minitest::Test
   end
 
   def test_response_starts_with_headers_frame
-    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, {}, ["body"])
+    encoder = Quicsilver::Protocol::ResponseEncoder.new(200, {}, ["body"], encoder: qpack_encoder)
     data = encoder.encode
 
     frames = parse_frames(data)
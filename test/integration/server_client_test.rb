@@ -778,6 +778,24 @@ class ServerClientIntegrationTest < Minitest::Test
     client.disconnect
   end
 
+  def test_per_ip_limit_refuses_connection_before_handshake
+    start_server(->(env) { [200, {}, ["OK"]] }, max_connections_per_ip: 1, handshake_idle_timeout_ms: 1000)
+
+    first = Quicsilver::Client.new("127.0.0.1", @port, unsecure: true)
+    assert_equal 200, first.get("/").status
+
+    second = Quicsilver::Client.new("127.0.0.1", @port, unsecure: true, connection_timeout: 1000)
+    assert_raises(Quicsilver::ConnectionError, Quicsilver::TimeoutError) { second.get("/") }
+
+    counters = @server.stats["transport"]
+    refute_nil counters, "transport counters should be available"
+    assert_operator counters["connections_prefix_rejected"], :>=, 1
+    assert_equal 1, @server.connections.size
+  ensure
+    first&.disconnect
+    second&.disconnect
+  end
+
   private
 
   def start_server(app, **options)
@@ -0,0 +1,125 @@
+# frozen_string_literal: true
+
+require "test_helper"
+
+class MemoryBudgetTest < Minitest::Test
+  MemoryBudget = Quicsilver::Transport::MemoryBudget
+
+  def test_counts_bytes_without_budgets
+    budget = MemoryBudget.new
+    first = budget.account
+    second = budget.account
+
+    first.reserve(100)
+    second.reserve(50)
+    first.release(30)
+
+    assert_equal 70, first.buffered
+    assert_equal 120, budget.buffered
+    assert_equal :ok, first.level
+    assert_equal 150, budget.to_h["receive_peak"]
+  end
+
+  def test_releases_never_go_below_zero
+    budget = MemoryBudget.new
+    account = budget.account
+    other = budget.account
+    account.reserve(10)
+    other.reserve(5)
+
+    account.close
+    account.release(10)
+
+    assert_equal 0, account.buffered
+    assert_equal 5, budget.buffered
+  end
+
+  def test_connection_budget_escalates
+    budget = MemoryBudget.new(connection_limit: 100)
+    account = budget.account
+
+    account.reserve(100)
+    assert_equal :ok, account.level
+    account.reserve(1)
+    assert_equal :pause, account.level
+    assert account.over_budget?
+    account.reserve(50)
+    assert_equal :reset, account.level
+    account.reserve(50)
+    assert_equal :close, account.level
+    assert_equal :ok, budget.account.level, "other connections are within their own budget"
+  end
+
+  def test_connection_budget_includes_unsent_response_bytes
+    budget = MemoryBudget.new(connection_limit: 100)
+    account = budget.account(0xAB)
+    account.reserve(60)
+
+    Quicsilver.stub(:connection_send_inflight, ->(handle) { handle == 0xAB ? 100 : 0 }) do
+      assert_equal :reset, account.level
+    end
+  end
+
+  def test_server_budget_pauses_every_connection
+    budget = MemoryBudget.new(limit: 100)
+    busy = budget.account
+    idle = budget.account
+    busy.reserve(101)
+
+    Quicsilver.stub(:send_buffered, 0) do
+      assert_equal :pause, busy.level
+      assert_equal :pause, idle.level
+    end
+  end
+
+  def test_server_budget_resets_and_closes_only_heavy_connections
+    budget = MemoryBudget.new(limit: 100)
+    busy = budget.account
+    idle = budget.account
+    busy.reserve(160)
+
+    Quicsilver.stub(:send_buffered, 0) do
+      assert_equal :reset, busy.level
+      assert_equal :pause, idle.level, "a connection holding nothing is not reset"
+    end
+    Quicsilver.stub(:send_buffered, 50) do
+      assert_equal :close, busy.level
+      assert_equal :pause, idle.level, "a connection holding nothing is not closed"
+    end
+  end
+
+  def test_fair_share_follows_open_connections
+    budget = MemoryBudget.new(limit: 100)
+    first = budget.account
+    second = budget.account
+    first.reserve(120)
+    second.reserve(40)
+
+    Quicsilver.stub(:send_buffered, 0) do
+      assert_equal :reset, first.level
+      assert_equal :pause, second.level, "within an even share of 50"
+      budget.account # a third connection lowers the share to 33
+      assert_equal :reset, second.level
+    end
+
+    second.close
+    second.close
+    assert_equal 2, budget.accounts
+  end
+
+  def test_to_h_reports_enforcement
+    budget = MemoryBudget.new(limit: 1_000, connection_limit: 100)
+    budget.enforced!(:reset)
+    budget.enforced!(:reset)
+    budget.enforced!(:close)
+
+    assert_equal({
+      "limit" => 1_000,
+      "connection_limit" => 100,
+      "receive_buffered" => 0,
+      "receive_peak" => 0,
+      "streams_reset" => 2,
+      "connections_closed" => 1
+    }, budget.to_h)
+  end
+end
@@ -212,7 +212,8 @@ class Quicsilver::Protocol::AdapterTest < Minitest::Test
     # Encode and parse round-trip
     body = Protocol::HTTP::Body::Buffered.wrap("grpc-payload")
     encoder = Quicsilver::Protocol::ResponseEncoder.new(
-      200, response_headers, body, trailers: trailers
+      200, response_headers, body, trailers: trailers,
+      encoder: qpack_encoder
     )
     data = encoder.encode
 
@@ -0,0 +1,83 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class Quicsilver::Protocol::ChunkBufferTest < Minitest::Test
+  def test_append_keeps_segments_and_to_s_joins_once
+    buffer = Quicsilver::Protocol::ChunkBuffer.new
+    buffer << "abc".b << "".b << "def".b
+
+    assert_equal 6, buffer.bytesize
+    flat = buffer.to_s
+    assert_equal "abcdef", flat
+    assert_same flat, buffer.to_s
+  end
+
+  def test_single_segment_to_s_is_not_copied
+    data = "whole".b
+    buffer = Quicsilver::Protocol::ChunkBuffer.new(data)
+
+    assert_same data, buffer.to_s
+  end
+
+  def test_getbyte_and_byteslice_across_segments
+    buffer = Quicsilver::Protocol::ChunkBuffer.new
+    buffer << "ab".b << "cd".b << "ef".b
+
+    assert_equal "c".ord, buffer.getbyte(2)
+    assert_nil buffer.getbyte(6)
+    assert_equal "bcde", buffer.byteslice(1, 4)
+    assert_equal "ef", buffer.byteslice(4, 10)
+    assert_equal Encoding::BINARY, buffer.byteslice(1, 4).encoding
+  end
+
+  def test_consume_across_segments
+    buffer = Quicsilver::Protocol::ChunkBuffer.new
+    buffer << "ab".b << "cd".b << "ef".b
+    buffer.consume(3)
+
+    assert_equal 3, buffer.bytesize
+    assert_equal "def", buffer.to_s
+    buffer.consume(10)
+    assert_empty buffer
+  end
+
+  def test_shift_frame_across_segment_boundaries
+    frames = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "x" * 100) +
+      Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "tail")
+    buffer = Quicsilver::Protocol::ChunkBuffer.new
+    frames.each_char { |c| buffer << c.b }
+
+    assert_equal [Quicsilver::Protocol::FRAME_DATA, "x" * 100], buffer.shift_frame
+    assert_equal [Quicsilver::Protocol::FRAME_DATA, "tail"], buffer.shift_frame
+    assert_nil buffer.shift_frame
+    assert_empty buffer
+  end
+
+  def test_incomplete_frame_stays_buffered
+    frame = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "hello")
+    buffer = Quicsilver::Protocol::ChunkBuffer.new(frame.byteslice(0, 4))
+
+    assert_nil buffer.shift_frame
+    assert_equal 4, buffer.bytesize
+
+    buffer << frame.byteslice(4..)
+    assert_equal [Quicsilver::Protocol::FRAME_DATA, "hello"], buffer.shift_frame
+  end
+
+  def test_peek_frame_does_not_consume
+    frame = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_HEADERS, "hdr")
+    buffer = Quicsilver::Protocol::ChunkBuffer.new(frame)
+
+    assert_equal [Quicsilver::Protocol::FRAME_HEADERS, "hdr", frame.bytesize], buffer.peek_frame
+    assert_equal frame.bytesize, buffer.bytesize
+  end
+
+  def test_multibyte_varints
+    buffer = Quicsilver::Protocol::ChunkBuffer.new
+    buffer << "\x7b".b << "\xbd".b # 2-byte varint 15293 (RFC 9000 §A.1)
+
+    assert_equal [15_293, 2], buffer.varint(0)
+    assert_equal [0, 0], Quicsilver::Protocol::ChunkBuffer.new("\x7b".b).varint(0)
+  end
+end
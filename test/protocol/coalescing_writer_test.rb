@@ -0,0 +1,146 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+require "timeout"
+
+class Quicsilver::Protocol::CoalescingWriterTest < Minitest::Test
+  def test_small_chunks_share_one_data_frame
+    sent = []
+    writer = build_writer(sent, max_size: 1024, max_delay: nil)
+    %w[a b c].each { |chunk| writer.write(chunk) }
+    writer.close
+
+    assert_equal 1, sent.size
+    assert_equal [[Quicsilver::Protocol::FRAME_DATA, "abc"]], frames(sent[0][0])
+    assert sent[0][1], "close should send FIN"
+  end
+
+  def test_flushes_once_max_size_is_buffered
+    sent = []
+    writer = build_writer(sent, max_size: 4, max_delay: nil)
+    writer.write("ab")
+    assert_empty sent
+    writer.write("cd")
+
+    assert_equal 1, sent.size
+    assert_equal [[Quicsilver::Protocol::FRAME_DATA, "abcd"]], frames(sent[0][0])
+    refute sent[0][1]
+  end
+
+  def test_headers_frame_goes_out_with_first_data
+    sent = []
+    writer = build_writer(sent, max_size: 1024, max_delay: nil)
+    writer.write_frame(Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_HEADERS, "hdr"))
+    writer.write("body")
+    writer.close(Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_HEADERS, "trl"))
+
+    assert_equal 1, sent.size
+    assert_equal [
+      [Quicsilver::Protocol::FRAME_HEADERS, "hdr"],
+      [Quicsilver::Protocol::FRAME_DATA, "body"],
+      [Quicsilver::Protocol::FRAME_HEADERS, "trl"]
+    ], frames(sent[0][0])
+  end
+
+  def test_empty_chunk_flushes
+    sent = []
+    writer = build_writer(sent, max_size: 1024, max_delay: nil)
+    writer.write("event")
+    writer.write("")
+
+    assert_equal 1, sent.size
+    refute sent[0][1]
+  end
+
+  def test_close_with_nothing_pending_sends_bare_fin
+    sent = []
+    writer = build_writer(sent, max_size: 1024, max_delay: nil)
+    writer.write("x")
+    writer.flush
+    writer.close
+
+    assert_equal ["".b, true], sent.last
+    assert writer.closed?
+  end
+
+  def test_max_delay_flushes_without_another_write
+    sent = Queue.new
+    writer = Quicsilver::Protocol::CoalescingWriter.new(max_size: 1024, max_delay: 0.01) do |bytes, fin|
+      sent << [bytes, fin]
+    end
+    writer.write("late")
+
+    bytes, fin = Timeout.timeout(2) { sent.pop }
+    assert_equal [[Quicsilver::Protocol::FRAME_DATA, "late"]], frames(bytes)
+    refute fin
+  end
+
+  def test_stalled_writer_does_not_hold_up_timed_flushes_of_others
+    stall = Queue.new
+    waits = []
+    flushed = Queue.new
+    # Stands in for a stream above its send high-water mark: a send that
+    # is allowed to wait parks until the peer catches up.
+    stalled = Quicsilver::Protocol::CoalescingWriter.new(max_size: 1024, max_delay: 0.001) do |_bytes, _fin, wait|
+      waits << wait
+      stall.pop if wait
+      flushed << :stalled
+    end
+    other = Quicsilver::Protocol::CoalescingWriter.new(max_size: 1024, max_delay: 0.001) do |_bytes, _fin, _wait|
+      flushed << :other
+    end
+
+    stalled.write("slow client")
+    other.write("fast client")
+
+    assert_equal [:stalled, :other], Timeout.timeout(2) { [flushed.pop, flushed.pop] }
+    assert_equal [false], waits
+  ensure
+    stall&.close
+  end
+
+  def test_response_thread_flushes_may_wait
+    waits = []
+    writer = Quicsilver::Protocol::CoalescingWriter.new(max_size: 4, max_delay: nil) { |_bytes, _fin, wait| waits << wait }
+    writer.write("abcd")
+    writer.close
+
+    assert_equal [true, true], waits
+  end
+
+  def test_error_from_timed_flush_raises_on_next_write
+    writer = Quicsilver::Protocol::CoalescingWriter.new(max_size: 1024, max_delay: 0.001) do |_bytes, _fin|
+      raise "StreamSend failed, 0x1!"
+    end
+    writer.write("x")
+    sleep 0.1
+
+    error = assert_raises(RuntimeError) { writer.write("y") }
+    assert_equal "StreamSend failed, 0x1!", error.message
+  end
+
+  def test_utf8_chunks_are_appended_as_bytes
+    sent = []
+    writer = build_writer(sent, max_size: 1024, max_delay: nil)
+    writer.write("ünï".b)
+    writer.write("çødé")
+    writer.close
+
+    assert_equal "ünïçødé".b, frames(sent[0][0]).first[1]
+  end
+
+  private
+
+  def build_writer(sent, **options)
+    Quicsilver::Protocol::CoalescingWriter.new(**options) { |bytes, fin| sent << [bytes, fin] }
+  end
+
+  def frames(bytes)
+    buffer = Quicsilver::Protocol::ChunkBuffer.new(bytes)
+    result = []
+    while (frame = buffer.shift_frame)
+      result << frame
+    end
+    result
+  end
+end
@@ -0,0 +1,95 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class Quicsilver::Protocol::RequestSpoolTest < Minitest::Test
+  def setup
+    @spool = Quicsilver::Protocol::RequestSpool.new
+  end
+
+  def teardown
+    @spool.close
+  end
+
+  def test_splits_headers_from_body
+    @spool << post_request("hello world")
+
+    parser = Quicsilver::Protocol::RequestParser.new(@spool.head)
+    parser.parse
+    assert_equal "POST", parser.headers[":method"]
+    assert_equal 11, @spool.body_size
+    assert_equal "hello world", read_all(@spool.to_input)
+  end
+
+  def test_frames_split_across_writes
+    data = post_request("x" * 1000)
+    data.each_char.each_slice(7) { |slice| @spool << slice.join.b }
+
+    assert_equal 1000, @spool.body_size
+    assert_equal "x" * 1000, read_all(@spool.to_input)
+  end
+
+  def test_multiple_data_frames_and_trailers
+    headers = post_request(nil)
+    data = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "abc") +
+      Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "def")
+    trailers = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_HEADERS,
+      Quicsilver::Protocol::Qpack::Encoder.new.encode([["x-checksum", "1"]]))
+    @spool << headers + data + trailers
+
+    parser = Quicsilver::Protocol::RequestParser.new(@spool.head)
+    parser.parse
+    assert_equal "1", parser.trailers["x-checksum"]
+    assert_equal "abcdef", read_all(@spool.to_input)
+  end
+
+  def test_body_is_not_held_in_memory
+    @spool << post_request("y" * 100_000)
+
+    assert_operator @spool.head.bytesize, :<, 100
+  end
+
+  def test_max_body_size
+    spool = Quicsilver::Protocol::RequestSpool.new(max_body_size: 10)
+
+    assert_raises(Quicsilver::Protocol::MessageError) { spool << post_request("x" * 11) }
+  ensure
+    spool.close
+  end
+
+  def test_data_before_headers_is_a_frame_error
+    assert_raises(Quicsilver::Protocol::FrameError) do
+      @spool << Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "x")
+    end
+  end
+
+  def test_content_length_mismatch
+    @spool << post_request("hello")
+
+    assert_raises(Quicsilver::Protocol::MessageError) { @spool.to_input(10) }
+    assert_equal 5, @spool.to_input(5).length
+  end
+
+  def test_input_rewinds
+    @spool << post_request("again")
+    input = @spool.to_input
+
+    assert_equal "again", read_all(input)
+    assert input.rewind
+    assert_equal "again", read_all(input)
+  end
+
+  private
+
+  def post_request(body)
+    Quicsilver::Protocol::RequestEncoder.new(method: "POST", path: "/upload", body: body, encoder: qpack_encoder).encode
+  end
+
+  def read_all(input)
+    buffer = "".b
+    while (chunk = input.read)
+      buffer << chunk
+    end
+    buffer
+  end
+end
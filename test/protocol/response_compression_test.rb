@@ -0,0 +1,176 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+require "tempfile"
+require "zlib"
+
+class ResponseCompressionTest < Minitest::Test
+  JSON_BODY = ("{\"flag\":true}," * 200).freeze
+
+  def setup
+    @compression = Quicsilver::Protocol::ResponseCompression.new(encodings: %w[gzip])
+  end
+
+  def test_negotiation
+    compression = Quicsilver::Protocol::ResponseCompression.new(encodings: %w[br gzip])
+
+    assert_equal "br", compression.negotiate("gzip, deflate, br")
+    assert_equal "gzip", compression.negotiate("br;q=0.5, gzip")
+    assert_equal "br", compression.negotiate("*")
+    assert_equal "gzip", compression.negotiate("x-gzip")
+    assert_nil compression.negotiate("br;q=0, gzip;q=0")
+    assert_nil compression.negotiate("identity")
+    assert_nil compression.negotiate("")
+  end
+
+  def test_buffered_body_is_compressed
+    headers, body = @compression.apply(200,
+      { "content-type" => "application/json", "content-length" => JSON_BODY.bytesize.to_s, "etag" => "\"v1\"" },
+      [JSON_BODY], "gzip")
+    fields = headers.to_h
+
+    assert_equal "gzip", fields["content-encoding"]
+    assert_equal "accept-encoding", fields["vary"]
+    assert_equal "W/\"v1\"", fields["etag"]
+    assert_equal body.first.bytesize.to_s, fields["content-length"]
+    assert_equal JSON_BODY, Zlib.gunzip(body.first)
+  end
+
+  def test_responses_left_alone
+    json = { "content-type" => "application/json" }
+
+    assert_uncompressed(200, { "content-type" => "image/png" }, [JSON_BODY], "gzip")
+    assert_uncompressed(200, json, ["{}"], "gzip")
+    assert_uncompressed(200, json, [JSON_BODY], "br")
+    assert_uncompressed(200, json.merge("content-encoding" => "br"), [JSON_BODY], "gzip")
+    assert_uncompressed(200, json.merge("cache-control" => "no-transform"), [JSON_BODY], "gzip")
+    assert_uncompressed(206, json, [JSON_BODY], "gzip")
+  end
+
+  def test_existing_vary_is_extended
+    headers, = @compression.apply(200, { "content-type" => "text/html", "vary" => "origin" }, [JSON_BODY], "gzip")
+
+    assert_equal "origin, accept-encoding", headers.to_h["vary"]
+  end
+
+  def test_streamed_body_is_compressed_per_chunk
+    chunks = Array.new(50) { |i| "line #{i}\n" * 20 }
+    enumerable = Enumerator.new { |yielder| chunks.each { |chunk| yielder << chunk } }
+    headers, body = @compression.apply(200, { "content-type" => "text/plain" }, enumerable, "gzip")
+
+    out = +"".b
+    body.each { |chunk| out << chunk }
+    body.close
+
+    refute headers.to_h.key?("content-length")
+    assert_equal chunks.join, Zlib.gunzip(out)
+  end
+
+  def test_event_streams_are_flushed_per_event
+    events = Enumerator.new { |yielder| 3.times { |i| yielder << "data: #{i}\n\n" } }
+    _headers, body = @compression.apply(200, { "content-type" => "text/event-stream" }, events, "gzip")
+
+    out = []
+    body.each { |chunk| out << chunk }
+
+    # One flushed block per event, then the gzip trailer
+    assert_equal 4, out.size
+    assert_equal "data: 0\n\n", Zlib::Inflate.new(Zlib::MAX_WBITS + 16).inflate(out.first)
+  end
+
+  def test_immutable_bodies_are_compressed_once
+    headers = { "content-type" => "application/javascript", "cache-control" => "public, max-age=31536000, immutable" }
+
+    _, first = @compression.apply(200, headers, [JSON_BODY.dup], "gzip")
+    _, second = @compression.apply(200, headers, [JSON_BODY.dup], "gzip")
+
+    assert_same first.first, second.first
+    assert_operator @compression.variants_size, :>, 0
+  end
+
+  def test_immutable_files_are_keyed_by_path
+    file = Tempfile.new(["asset", ".js"])
+    file.write(JSON_BODY)
+    file.flush
+    body = Struct.new(:to_path) { def each; yield File.read(to_path); end }
+    headers = { "content-type" => "text/javascript", "cache-control" => "immutable" }
+
+    _, first = @compression.apply(200, headers, body.new(file.path), "gzip")
+    _, second = @compression.apply(200, headers, body.new(file.path), "gzip")
+
+    assert_same first.first, second.first
+    assert_equal JSON_BODY, Zlib.gunzip(first.first)
+  ensure
+    file&.close!
+  end
+
+  def test_compressor_rejects_out_of_range_levels
+    { "gzip" => 10, "br" => 12, "zstd" => 1000 }.each do |coding, level|
+      next unless Quicsilver::Compressor.encodings.include?(coding)
+
+      error = assert_raises(ArgumentError) { Quicsilver::Compressor.new(coding, level) }
+      assert_includes error.message, "invalid compression level"
+    end
+  end
+
+  def test_head_gets_the_encoding_headers_of_its_get
+    headers = @compression.apply_head(200,
+      { "content-type" => "application/json", "content-length" => JSON_BODY.bytesize.to_s, "etag" => "\"v1\"" },
+      [], "gzip")
+    fields = headers.to_h
+
+    assert_equal "gzip", fields["content-encoding"]
+    assert_equal "accept-encoding", fields["vary"]
+    assert_equal "W/\"v1\"", fields["etag"]
+    refute fields.key?("content-length")
+  end
+
+  def test_head_for_an_uncompressed_get_is_left_alone
+    json = { "content-type" => "application/json" }
+
+    assert_same json, @compression.apply_head(200, json, ["{}"], "gzip")
+    assert_same json, @compression.apply_head(200, json, [JSON_BODY], "br")
+    png = { "content-type" => "image/png" }
+    assert_same png, @compression.apply_head(200, png, [JSON_BODY], "gzip")
+  end
+
+  def test_connection_sends_encoding_headers_for_head
+    connection = Quicsilver::Transport::Connection.new(12345, [12345, 67890], compression: @compression)
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+
+    sent = +"".b
+    Quicsilver.stub(:send_stream, ->(_handle, data, *) { sent << data }) do
+      connection.send_response(stream, 200, { "content-type" => "application/json" }, [JSON_BODY],
+        head_request: true, accept_encoding: "gzip")
+    end
+
+    response = Quicsilver::Protocol::ResponseParser.new(sent).tap(&:parse)
+    assert_equal "gzip", response.headers["content-encoding"]
+    assert_equal "accept-encoding", response.headers["vary"]
+  end
+
+  def test_connection_compresses_for_accepting_clients
+    connection = Quicsilver::Transport::Connection.new(12345, [12345, 67890], compression: @compression)
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+
+    sent = +"".b
+    Quicsilver.stub(:send_stream, ->(_handle, data, *) { sent << data }) do
+      connection.send_response(stream, 200, { "content-type" => "application/json" }, [JSON_BODY], accept_encoding: "gzip")
+    end
+
+    response = Quicsilver::Protocol::ResponseParser.new(sent).tap(&:parse)
+    assert_equal "gzip", response.headers["content-encoding"]
+    assert_equal JSON_BODY, Zlib.gunzip(response.body.read)
+  end
+
+  private
+
+  def assert_uncompressed(status, headers, body, accept_encoding)
+    result_headers, result_body = @compression.apply(status, headers, body, accept_encoding)
+
+    assert_same headers, result_headers
+    assert_same body, result_body
+  end
+end
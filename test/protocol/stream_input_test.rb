@@ -73,4 +73,96 @@ class Quicsilver::Protocol::StreamInputTest < Minitest::Test
     input.close_write
     assert_nil input.read
   end
+
+  def test_flow_control_pauses_at_limit_and_resumes_at_half
+    input = Quicsilver::Protocol::StreamInput.new
+    calls = []
+    input.flow_control(10) { |enabled| calls << enabled }
+
+    input.write("aaaa")
+    input.write("bbbb")
+    assert_empty calls
+    input.write("cccc")
+    assert_equal [false], calls
+    assert input.paused?
+
+    input.write("dddd") # in-flight data is still accepted, never blocks
+    assert_equal [false], calls
+    assert_equal 16, input.buffered_bytes
+
+    input.read
+    input.read
+    assert_equal [false], calls, "8 unread bytes is above half the limit"
+    input.read
+    assert_equal [false, true], calls
+    refute input.paused?
+  end
+
+  def test_flow_control_released_after_close_write
+    input = Quicsilver::Protocol::StreamInput.new
+    calls = []
+    input.flow_control(4) { |enabled| calls << enabled }
+
+    input.write("abcd")
+    input.close_write
+    assert_equal "abcd", input.read
+    assert_equal [false], calls, "no resume once the peer has finished"
+  end
+
+  def test_flow_control_released_after_close
+    input = Quicsilver::Protocol::StreamInput.new
+    calls = []
+    input.flow_control(4) { |enabled| calls << enabled }
+
+    input.close(RuntimeError.new("reset"))
+    assert_raises(Protocol::HTTP::Body::Writable::Closed) { input.write("abcd") }
+    assert_empty calls
+  end
+
+  def test_memory_account_charged_for_unread_bytes
+    account = Quicsilver::Transport::MemoryBudget.new.account
+    input = Quicsilver::Protocol::StreamInput.new
+    input.charge_to(account)
+
+    input.write("aaaa")
+    input.write("bbbb")
+    assert_equal 8, account.buffered
+    input.read
+    assert_equal 4, account.buffered
+
+    input.release_memory
+    assert_equal 0, account.buffered
+    input.read
+    assert_equal 0, account.buffered
+  end
+
+  def test_flow_control_pauses_while_account_is_over_budget
+    budget = Quicsilver::Transport::MemoryBudget.new(connection_limit: 6)
+    account = budget.account
+    input = Quicsilver::Protocol::StreamInput.new
+    calls = []
+    input.charge_to(account)
+    input.flow_control(100) { |enabled| calls << enabled }
+
+    input.write("aaaa")
+    assert_empty calls
+    account.reserve(4) # another stream's data on the same connection
+    input.write("bbbb")
+    assert_equal [false], calls
+
+    input.read
+    assert_equal [false], calls, "still over budget with unread data"
+    input.read
+    assert_equal [false, true], calls, "a drained body resumes regardless"
+  end
+
+  def test_close_releases_memory
+    account = Quicsilver::Transport::MemoryBudget.new.account
+    input = Quicsilver::Protocol::StreamInput.new
+    input.charge_to(account)
+    input.write("abcd")
+
+    input.close(RuntimeError.new("reset"))
+    assert_equal 0, account.buffered
+  end
 end
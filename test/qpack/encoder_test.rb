@@ -259,6 +259,55 @@ class QpackEncoderTest < Minitest::Test
     assert_includes names, "location"
   end
 
+  # Long-lived encoder caches
+  def test_repeated_header_block_is_encoded_once
+    first = @encoder.encode([[":status", "200"], ["content-type", "text/html"]])
+    second = @encoder.encode([[":status", "200"], ["content-type", "text/html"]])
+
+    assert_same first, second
+    assert first.frozen?
+  end
+
+  def test_block_cache_evicts_least_recently_used
+    encoder = Quicsilver::Protocol::Qpack::Encoder.new(max_blocks: 2)
+    a = encoder.encode([["x-a", "1"]])
+    encoder.encode([["x-b", "1"]])
+    encoder.encode([["x-a", "1"]])          # a is now most recent
+    encoder.encode([["x-c", "1"]])          # evicts b
+
+    assert_equal 2, encoder.cache_sizes["blocks"]
+    assert_same a, encoder.encode([["x-a", "1"]])
+    refute_same encoder.encode([["x-b", "1"]]), encoder.encode([["x-d", "1"]])
+  end
+
+  def test_field_cache_is_bounded
+    encoder = Quicsilver::Protocol::Qpack::Encoder.new(max_fields: 3)
+    10.times { |i| encoder.encode([["x-id", i.to_s]]) }
+
+    assert_equal 3, encoder.cache_sizes["fields"]
+  end
+
+  def test_shared_across_threads
+    expected = Quicsilver::Protocol::Qpack::Encoder.new.encode([[":status", "200"], ["x-n", "1"]])
+    results = 8.times.map do
+      Thread.new { 200.times.map { |i| @encoder.encode([[":status", "200"], ["x-n", (i % 4 + 1).to_s]]) } }
+    end.flat_map(&:value)
+
+    assert_equal expected, results.first
+    assert_equal 4, results.uniq.size
+  end
+
+  def test_locks_once_per_header_block
+    encoder = Quicsilver::Protocol::Qpack::Encoder.new
+    locks = 0
+    mutex = encoder.instance_variable_get(:@mutex)
+    mutex.define_singleton_method(:synchronize) { |&block| locks += 1; super(&block) }
+
+    encoder.encode([[":status", "200"], ["x-a", "1"], ["x-b", "2"], ["x-c", "3"]])
+
+    assert_equal 1, locks
+  end
+
   # Roundtrip sanity check
   def test_encoded_output_is_binary
     encoded = @encoder.encode({ ":method" => "GET" })
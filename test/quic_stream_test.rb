@@ -64,4 +64,17 @@ class QuicStreamTest < Minitest::Test
     stream.stream_handle = 12345
     assert stream.writable?
   end
+
+  def test_send_waits_for_send_window_by_default
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+    calls = []
+
+    Quicsilver.stub(:send_stream, ->(*args) { calls << args }) do
+      stream.send("a", fin: false)
+      stream.send("b", fin: true, wait: false)
+    end
+
+    assert_equal [[0xBEEF, "a", false], [0xBEEF, "b", true, false, false]], calls
+  end
 end
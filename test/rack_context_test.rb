@@ -28,4 +28,15 @@ class RackContextTest < Minitest::Test
     assert_nil context.webtransport
     assert_nil context["missing"]
   end
+
+  def test_cancelled_reflects_server_cancellation
+    cancellation = Quicsilver::Server::Cancellation.new
+    context = Quicsilver::Rack::Context.new(metadata: {"cancellation" => cancellation})
+
+    refute context.cancelled?
+    cancellation.cancel
+    assert context.cancelled?
+    assert_same cancellation, context.cancellation
+    refute Quicsilver::Rack::Context.new.cancelled?
+  end
 end
@@ -143,4 +143,36 @@ class RequestTest < Minitest::Test
       end
     end
   end
+
+  def test_not_early_data_by_default
+    refute @request.early_data?
+  end
+
+  def test_early_request_replays_after_425
+    retried_stream = Quicsilver::Transport::Stream.new(67890)
+    retried = Quicsilver::Client::Request.new(@mock_client, retried_stream)
+    replayed_with = nil
+    @mock_client.define_singleton_method(:build_request) do |method, path, **options|
+      replayed_with = [method, path, options]
+      retried.complete(Quicsilver::Response.new(status: 200, headers: {}, body: "OK"))
+      retried
+    end
+
+    request = Quicsilver::Client::Request.new(@mock_client, @mock_stream,
+      replay: ["GET", "/", { headers: {}, body: nil, priority: nil }])
+    assert request.early_data?
+
+    request.complete(Quicsilver::Response.new(status: 425, headers: {}, body: ""))
+    response = request.response(timeout: 1)
+
+    assert_equal 200, response.status
+    assert_equal ["GET", "/", { headers: {}, body: nil, priority: nil }], replayed_with
+    assert_same retried_stream, request.stream
+    assert request.completed?
+  end
+
+  def test_425_without_early_data_is_returned_as_is
+    @request.complete(Quicsilver::Response.new(status: 425, headers: {}, body: ""))
+    assert_equal 425, @request.response(timeout: 1).status
+  end
 end
@@ -0,0 +1,55 @@
+# frozen_string_literal: true
+
+require "test_helper"
+
+class SendSchedulerTest < Minitest::Test
+  Scheduler = Quicsilver::Transport::SendScheduler
+  Priority = Quicsilver::Protocol::Priority
+
+  def test_urgency_bands_are_strictly_ordered
+    values = (0..7).map do |urgency|
+      [Scheduler.quic_priority(0, Priority.new(urgency: urgency)),
+       Scheduler.quic_priority(400, Priority.new(urgency: urgency, incremental: true))]
+    end
+
+    # Lowest of one urgency stays above highest of the next
+    values.each_cons(2) { |higher, lower| assert_operator higher.min, :>, lower.max }
+    assert_equal 0xFFFF, values.first.max
+    assert_equal 0, values.last.min
+  end
+
+  def test_sequential_streams_go_in_stream_order_before_incremental_ones
+    default = Priority.new
+    incremental = Priority.new(incremental: true)
+
+    first = Scheduler.quic_priority(0, default)
+    second = Scheduler.quic_priority(4, default)
+
+    assert_operator first, :>, second
+    assert_operator second, :>, Scheduler.quic_priority(0, incremental)
+  end
+
+  def test_incremental_streams_of_equal_urgency_share_a_value
+    incremental = Priority.new(urgency: 5, incremental: true)
+
+    assert_equal Scheduler.quic_priority(0, incremental), Scheduler.quic_priority(96, incremental)
+  end
+
+  def test_update_moves_streams_already_sending
+    scheduler = Scheduler.new
+    set = []
+
+    Quicsilver.stub(:set_stream_priority, ->(handle, value) { set << [handle, value] }) do
+      scheduler.apply(4, 0xA, Priority.new)
+      assert scheduler.update(4, Priority.new(urgency: 0, incremental: true))
+      refute scheduler.update(4, Priority.new(urgency: 0, incremental: true))
+      refute scheduler.update(8, Priority.new(urgency: 0))
+    end
+
+    assert_equal [0xA, 0xA], set.map(&:first)
+    assert_equal Scheduler.quic_priority(4, Priority.new(urgency: 0, incremental: true)), set.last.last
+
+    scheduler.remove(4)
+    assert_equal 0, scheduler.size
+  end
+end
@@ -0,0 +1,148 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class AsyncBodyTest < Minitest::Test
+  def test_writes_before_attach_are_flushed_in_order
+    body = Quicsilver::Server::AsyncBody.new
+    body.write("a")
+    body.write("b")
+
+    sent = []
+    body.attach { |chunk, fin| sent << [chunk, fin] }
+    body.write("c")
+    body.close
+
+    assert_equal [["a", false], ["b", false], ["c", false], ["", true]], sent
+  end
+
+  def test_close_before_attach_sends_fin_on_attach
+    body = Quicsilver::Server::AsyncBody.new
+    body.write("only")
+    body.close
+
+    sent = []
+    body.attach { |chunk, fin| sent << [chunk, fin] }
+    assert_equal [["only", false], ["", true]], sent
+  end
+
+  def test_close_with_error_skips_fin_and_runs_callbacks
+    body = Quicsilver::Server::AsyncBody.new
+    sent = []
+    body.attach { |chunk, fin| sent << [chunk, fin] }
+    errors = []
+    body.on_close { |error| errors << error }
+
+    error = RuntimeError.new("Stream 0 cancelled")
+    body.close(error)
+    body.close
+
+    assert_empty sent
+    assert_equal [error], errors
+    refute body.write("late"), "write after close should report the body is gone"
+  end
+
+  def test_on_close_after_close_runs_immediately
+    body = Quicsilver::Server::AsyncBody.new
+    body.close
+    called = false
+    body.on_close { called = true }
+
+    assert called
+  end
+
+  def test_send_failure_closes_body
+    body = Quicsilver::Server::AsyncBody.new
+    body.attach { |_chunk, _fin| raise "StreamSend failed, 0x59!" }
+
+    refute body.write("x")
+    assert body.closed?
+    assert_equal "StreamSend failed, 0x59!", body.error.message
+  end
+
+  def test_read_blocks_until_written
+    body = Quicsilver::Server::AsyncBody.new
+    reader = Thread.new { [body.read, body.read] }
+    sleep 0.01
+    body.write("hello")
+    body.close
+
+    assert_equal ["hello", nil], reader.value
+  end
+
+  # --- Server integration ---
+
+  def test_worker_returns_while_body_stays_open
+    body = Quicsilver::Server::AsyncBody.new
+    server, connection = build_server(->(env) { [200, { "content-type" => "text/event-stream" }, body] })
+    stream = get_stream(connection)
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(handle, data, fin, *) { sent << [data, fin] }) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+      assert_equal 1, sent.size, "only HEADERS go out while the app is idle"
+      assert_equal 1, server.stats.dig("requests", "async")
+
+      body.write("data: 1\n\n")
+      body.close
+    end
+
+    assert_equal "data: 1\n\n", Quicsilver::Protocol::ChunkBuffer.new(sent[1][0]).shift_frame[1]
+    assert_equal ["", true], sent.last
+    assert_equal 0, connection.async_responses
+  end
+
+  def test_client_reset_closes_body
+    body = Quicsilver::Server::AsyncBody.new
+    server, connection = build_server(->(env) { [200, {}, body] })
+    stream = get_stream(connection)
+    closed_with = nil
+    body.on_close { |error| closed_with = error }
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+    server.send(:cancel_stream, connection, 0)
+
+    assert body.closed?
+    assert_match(/cancelled/, closed_with.message)
+    assert_equal 0, connection.async_responses
+  end
+
+  def test_drain_waits_for_open_async_bodies
+    body = Quicsilver::Server::AsyncBody.new
+    server, connection = build_server(->(env) { [200, {}, body] })
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      server.instance_variable_get(:@request_handler).call(connection, get_stream(connection))
+      closer = Thread.new { sleep 0.1; body.close }
+      server.drain(timeout: 2)
+      closer.join
+    end
+
+    assert body.closed?
+    assert_equal 0, server.stats.dig("requests", "async")
+  end
+
+  def test_drain_gives_up_on_async_bodies_at_the_timeout
+    body = Quicsilver::Server::AsyncBody.new
+    server, connection = build_server(->(env) { [200, {}, body] })
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      server.instance_variable_get(:@request_handler).call(connection, get_stream(connection))
+    end
+    server.drain(timeout: 0.1)
+
+    assert_equal 1, connection.async_responses
+  end
+
+  private
+
+  def get_stream(connection)
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+    stream.append_data(Quicsilver::Protocol::RequestEncoder.new(method: "GET", path: "/events", encoder: qpack_encoder).encode)
+    connection.add_stream(stream)
+    stream
+  end
+end
@@ -0,0 +1,142 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class CancellationTest < Minitest::Test
+  def test_cancel_runs_callbacks_once
+    cancellation = Quicsilver::Server::Cancellation.new
+    reasons = []
+    cancellation.on_cancel { |reason| reasons << reason }
+
+    assert cancellation.cancel("gone")
+    refute cancellation.cancel("again")
+
+    assert cancellation.cancelled?
+    assert_equal "gone", cancellation.reason
+    assert_equal ["gone"], reasons
+  end
+
+  def test_on_cancel_after_cancel_runs_immediately
+    cancellation = Quicsilver::Server::Cancellation.new
+    cancellation.cancel("gone")
+    called_with = nil
+    cancellation.on_cancel { |reason| called_with = reason }
+
+    assert_equal "gone", called_with
+  end
+
+  def test_raise_if_cancelled
+    cancellation = Quicsilver::Server::Cancellation.new
+    assert_nil cancellation.raise_if_cancelled!
+
+    cancellation.cancel("Stream 0 cancelled by peer")
+    error = assert_raises(Quicsilver::CancelledError) { cancellation.raise_if_cancelled! }
+    assert_equal "Stream 0 cancelled by peer", error.message
+  end
+
+  def test_failing_callback_does_not_stop_the_others
+    cancellation = Quicsilver::Server::Cancellation.new
+    called = false
+    cancellation.on_cancel { raise "boom" }
+    cancellation.on_cancel { called = true }
+    cancellation.cancel
+
+    assert called
+  end
+
+  # --- Server integration ---
+
+  def test_queued_request_is_dropped_after_reset
+    app_called = false
+    server, connection = build_server(->(env) { app_called = true; [200, {}, ["ok"]] })
+    stream = get_stream(connection)
+    server.send(:dispatch_request, connection, stream)
+    server.send(:cancel_stream, connection, 0)
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(*args) { sent << args }) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+
+    refute app_called
+    assert_empty sent
+    assert_empty server.instance_variable_get(:@cancellations)
+  end
+
+  def test_queued_streaming_request_is_dropped_after_reset
+    app_called = false
+    server, connection = build_server(->(env) { app_called = true; [200, {}, ["ok"]] })
+    server.send(:dispatch_streaming, connection, connection.handle, 0, get_headers, stream_handle: 0xBEEF)
+    pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+    server.send(:cancel_stream, connection, 0)
+
+    Quicsilver.stub(:send_stream, ->(*) { flunk "nothing should be sent" }) do
+      server.send(:handle_streaming_request, pending)
+    end
+
+    refute app_called
+    assert_empty server.instance_variable_get(:@cancellations)
+  end
+
+  def test_running_app_observes_cancellation
+    observed = []
+    server = nil
+    connection = nil
+    app = ->(env) {
+      context = env["quicsilver.context"]
+      observed << context.cancelled?
+      env["quicsilver.cancellation"].on_cancel { |reason| observed << reason }
+      server.send(:cancel_stream, connection, 0) # client resets mid-request
+      observed << context.cancelled?
+      [200, {}, ["too late"]]
+    }
+    server, connection = build_server(app)
+    stream = get_stream(connection)
+    server.send(:dispatch_request, connection, stream)
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(*args) { sent << args }) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+
+    assert_equal [false, "Stream 0 cancelled by peer", true], observed
+    assert_empty sent, "response for a cancelled stream should be skipped"
+  end
+
+  def test_cancelled_error_from_app_is_not_a_500
+    server, connection = build_server(->(env) { raise Quicsilver::CancelledError, "gone" }, mode: :falcon)
+    stream = get_stream(connection)
+    server.send(:dispatch_request, connection, stream)
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(*args) { sent << args }) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+
+    assert_empty sent
+  end
+
+  def test_connection_close_cancels_its_requests
+    server, connection = build_server(->(env) { [200, {}, []] })
+    stream = get_stream(connection)
+    server.send(:dispatch_request, connection, stream)
+    server.send(:cancel_connection_requests, connection.handle)
+
+    assert stream.cancellation.cancelled?
+    assert_equal "Connection closed", stream.cancellation.reason
+  end
+
+  private
+
+  def get_headers
+    Quicsilver::Protocol::RequestEncoder.new(method: "GET", path: "/report", encoder: qpack_encoder).encode
+  end
+
+  def get_stream(connection)
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+    stream.append_data(get_headers)
+    connection.add_stream(stream)
+    stream
+  end
+end
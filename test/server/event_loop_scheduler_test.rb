@@ -0,0 +1,86 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class EventLoopSchedulerTest < Minitest::Test
+  # Stands in for Transport::EventLoop: spawned blocks run when #run_spawned
+  # is called, the way the real loop starts them after each poll.
+  class FakeEventLoop
+    attr_reader :started_with, :spawned
+
+    def initialize
+      @spawned = []
+    end
+
+    def start(fiber_scheduler: nil)
+      @started_with = fiber_scheduler
+    end
+
+    def fiber_scheduler?
+      !@started_with.nil?
+    end
+
+    def spawn(&block)
+      @spawned << block
+    end
+
+    def run_spawned
+      @spawned.shift.call until @spawned.empty?
+    end
+  end
+
+  def test_start_switches_the_loop_into_fiber_mode
+    event_loop = FakeEventLoop.new
+    factory = -> {}
+    scheduler = build_scheduler(event_loop, fiber_scheduler: factory) {}
+    scheduler.start
+
+    assert_same factory, event_loop.started_with
+  end
+
+  def test_work_queued_before_start_runs_once_started
+    event_loop = FakeEventLoop.new
+    done = []
+    scheduler = build_scheduler(event_loop) { |work| done << work }
+    scheduler.enqueue(:a)
+    assert_empty event_loop.spawned
+
+    scheduler.start
+    event_loop.run_spawned
+    assert_equal [:a], done
+  end
+
+  def test_concurrency_caps_running_fibers
+    event_loop = FakeEventLoop.new
+    done = []
+    scheduler = build_scheduler(event_loop, concurrency: 2) { |work| done << work }
+    scheduler.start
+    5.times { |i| scheduler.enqueue(i) }
+
+    assert_equal 2, event_loop.spawned.size
+    assert_equal 2, scheduler.workers
+    assert_equal 3, scheduler.pending
+
+    event_loop.run_spawned # each finished fiber starts the next
+    assert_equal [0, 1, 2, 3, 4], done
+    assert_equal 0, scheduler.workers
+  end
+
+  def test_full_counts_waiting_work
+    event_loop = FakeEventLoop.new
+    scheduler = build_scheduler(event_loop, concurrency: 1, max_queue_size: 2) {}
+    scheduler.start
+    3.times { |i| scheduler.enqueue(i) }
+
+    assert scheduler.full?
+  end
+
+  private
+
+  def build_scheduler(event_loop, concurrency: 4, max_queue_size: 10, fiber_scheduler: -> {}, &handler)
+    Quicsilver::Server::Schedulers::EventLoopScheduler.new(
+      concurrency: concurrency, max_queue_size: max_queue_size,
+      event_loop: event_loop, fiber_scheduler: fiber_scheduler, &handler
+    )
+  end
+end
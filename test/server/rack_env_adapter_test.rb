@@ -0,0 +1,176 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+require "rack/lint"
+
+class RackEnvAdapterTest < Minitest::Test
+  HEADERS = {
+    ":method" => "POST", ":scheme" => "https", ":authority" => "example.com:4433",
+    ":path" => "/search?q=quic", "content-type" => "text/plain", "content-length" => "5",
+    "accept-language" => "en"
+  }.freeze
+
+  def test_env_is_built_from_headers
+    env = build_env(HEADERS, remote_address: "10.0.0.1", early_data: false)
+
+    assert_equal "POST", env["REQUEST_METHOD"]
+    assert_equal "", env["SCRIPT_NAME"]
+    assert_equal "/search", env["PATH_INFO"]
+    assert_equal "q=quic", env["QUERY_STRING"]
+    assert_equal "example.com", env["SERVER_NAME"]
+    assert_equal "4433", env["SERVER_PORT"]
+    assert_equal "HTTP/3", env["SERVER_PROTOCOL"]
+    assert_equal "https", env["rack.url_scheme"]
+    assert_equal "text/plain", env["CONTENT_TYPE"]
+    assert_equal "5", env["CONTENT_LENGTH"]
+    assert_equal "en", env["HTTP_ACCEPT_LANGUAGE"]
+    assert_equal "example.com:4433", env["HTTP_HOST"]
+    assert_equal "10.0.0.1", env["REMOTE_ADDR"]
+    assert_equal "false", env["HTTP_QUICSILVER_EARLY_DATA"]
+    refute env.key?("HTTP_CONTENT_TYPE")
+    assert env["rack.input"]
+  end
+
+  def test_env_keys_match_rack_mode
+    direct = build_env(HEADERS, remote_address: "10.0.0.1", early_data: true)
+
+    rack_env = nil
+    rack_adapter = Quicsilver::Server::RackAdapter.new(->(env) { rack_env = env; [200, {}, []] })
+    request, body = Quicsilver::Protocol::Adapter.new(rack_adapter).build_request(
+      HEADERS, remote_address: "10.0.0.1", remote_port: 1234, early_data: true
+    )
+    body.write("hello")
+    body.close_write
+    rack_adapter.call(request)
+
+    %w[REQUEST_METHOD PATH_INFO QUERY_STRING CONTENT_TYPE CONTENT_LENGTH
+       HTTP_ACCEPT_LANGUAGE HTTP_HOST HTTP_QUICSILVER_EARLY_DATA rack.url_scheme].each do |key|
+      assert_equal rack_env[key], direct[key], key
+    end
+  end
+
+  def test_get_and_post_envs_pass_rack_lint
+    get = build_env({ ":method" => "GET", ":scheme" => "https", ":authority" => "example.com", ":path" => "/" })
+    assert get["rack.input"], "bodyless requests get an empty input"
+    assert_equal "443", get["SERVER_PORT"]
+
+    inputs = []
+    lint_app = Rack::Lint.new(->(env) { inputs << env["rack.input"].read; [200, { "content-type" => "text/plain" }, ["ok"]] })
+    [get, post_env("hello")].each do |env|
+      _status, _headers, body = lint_app.call(env)
+      body.each { |_chunk| }
+      body.close
+    end
+    assert_equal ["", "hello"], inputs
+  end
+
+  def test_header_keys_are_frozen_and_reused
+    first = build_env(HEADERS).keys
+    second = build_env(HEADERS).keys
+
+    assert first.all?(&:frozen?)
+    first.zip(second).each { |a, b| assert_same a, b }
+  end
+
+  def test_transport_context_reaches_env
+    cancellation = Quicsilver::Server::Cancellation.new
+    context = { "connection" => { "stream_id" => 8, "request_id" => "r8" }, "cancellation" => cancellation }
+    env = build_env(HEADERS, transport_context: context)
+
+    assert_equal 8, env["quicsilver.stream_id"]
+    assert_equal "r8", env["quicsilver.request_id"]
+    assert_same cancellation, env["quicsilver.cancellation"]
+    assert_equal 8, env["quicsilver.context"].stream_id
+  end
+
+  def test_multi_value_headers_become_fields
+    response = call_app([200, { "set-cookie" => ["a=1", "b=2"], "vary" => "accept\norigin", "x" => "y" }, ["ok"]])
+    _status, headers, = adapter.response_parts(response)
+
+    assert_equal [["set-cookie", "a=1"], ["set-cookie", "b=2"], ["vary", "accept"], ["vary", "origin"], ["x", "y"]], headers
+  end
+
+  def test_single_value_headers_pass_through
+    rack_headers = { "content-type" => "text/plain" }
+    response = call_app([200, rack_headers, ["ok"]])
+
+    assert_same rack_headers, response.headers
+  end
+
+  def test_rack_trailers
+    app = ->(env) { env["rack.trailers"] = { "grpc-status" => "0" }; [200, {}, ["ok"]] }
+    response = call_app(app)
+
+    assert_equal({ "grpc-status" => "0" }, adapter.response_parts(response)[3])
+  end
+
+  def test_streaming_body_writes_through_each
+    app = ->(_env) { [200, {}, ->(stream) { stream.write("a"); stream << "b"; stream.close }] }
+    chunks = []
+    call_app(app).body.each { |chunk| chunks << chunk }
+
+    assert_equal %w[a b], chunks
+  end
+
+  def test_early_hints
+    hints = []
+    app = ->(env) { env["rack.early_hints"].call({ "link" => ["</a.css>", "</b.js>"] }); [200, {}, []] }
+    request, = adapter.build_request(HEADERS)
+    request.interim_response = ->(status, headers) { hints << [status, headers] }
+    Quicsilver::Server::RackEnvAdapter.new(app).call(request)
+
+    assert_equal [[103, [["link", "</a.css>"], ["link", "</b.js>"]]]], hints
+  end
+
+  def test_server_rack_direct_mode
+    seen = nil
+    app = ->(env) { seen = env; [200, { "content-type" => "text/plain" }, ["hello"]] }
+    config = Quicsilver::Transport::Configuration.new(cert_file_path, key_file_path, mode: :rack_direct)
+    server = Quicsilver::Server.new(4433, server_configuration: config, app: app)
+    connection = Quicsilver::Transport::Connection.new(12345, [12345, 67890])
+    server.connections[12345] = connection
+
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+    stream.append_data(Quicsilver::Protocol::RequestEncoder.new(method: "GET", path: "/hi?x=1", encoder: qpack_encoder).encode)
+    connection.add_stream(stream)
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(handle, data, fin, *) { sent << data }) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+
+    assert_kind_of Quicsilver::Server::RackEnvAdapter, server.instance_variable_get(:@request_handler).adapter
+    assert_equal "/hi", seen["PATH_INFO"]
+    assert_equal "x=1", seen["QUERY_STRING"]
+    assert_equal 0, seen["quicsilver.stream_id"]
+    response = Quicsilver::Protocol::ResponseParser.new(sent.join).tap(&:parse)
+    assert_equal 200, response.status
+    assert_equal "hello", response.body.read
+  end
+
+  private
+
+  def adapter
+    @adapter ||= Quicsilver::Server::RackEnvAdapter.new(->(_env) { [200, {}, []] })
+  end
+
+  def post_env(body_string)
+    request, body = adapter.build_request(HEADERS)
+    body.write(body_string)
+    body.close_write
+    adapter.build_env(request)
+  end
+
+  def build_env(headers, **options)
+    request, = adapter.build_request(headers, **options)
+    adapter.build_env(request)
+  end
+
+  def call_app(app_or_triple)
+    app = app_or_triple.respond_to?(:call) ? app_or_triple : ->(_env) { app_or_triple }
+    rack_env_adapter = Quicsilver::Server::RackEnvAdapter.new(app)
+    request, = rack_env_adapter.build_request(HEADERS)
+    rack_env_adapter.call(request)
+  end
+end
@@ -0,0 +1,103 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class RawAdapterTest < Minitest::Test
+  HEADERS = {
+    ":method" => "POST", ":scheme" => "https", ":authority" => "example.com",
+    ":path" => "/rpc", "content-type" => "application/json"
+  }.freeze
+
+  def test_app_gets_flat_frozen_headers
+    seen = nil
+    adapter = Quicsilver::Server::RawAdapter.new(->(stream, headers, body) { seen = [stream, headers, body]; [204, [], nil] })
+    request, body = adapter.build_request(HEADERS, transport_context: { "connection" => { "stream_id" => 4 } })
+    adapter.call(request)
+
+    stream, headers, app_body = seen
+    assert_equal [":method", "POST", ":scheme", "https", ":authority", "example.com", ":path", "/rpc",
+      "content-type", "application/json"], headers
+    assert headers.frozen?
+    assert_same body, app_body
+    assert_equal "POST", stream.method
+    assert_equal "/rpc", stream.path
+    assert_equal "application/json", stream.header("content-type")
+    assert_equal 4, stream.stream_id
+  end
+
+  def test_header_arrays_are_reused
+    adapter = Quicsilver::Server::RawAdapter.new(->(*) {})
+    first, = adapter.build_request(HEADERS.dup)
+    second, = adapter.build_request(HEADERS.dup)
+
+    assert_same first.headers, second.headers
+  end
+
+  def test_bodyless_request
+    adapter = Quicsilver::Server::RawAdapter.new(->(*) {})
+    request, body = adapter.build_request(HEADERS.merge(":method" => "GET"))
+
+    assert_nil body
+    assert_nil request.body
+  end
+
+  def test_encode_response_in_one_buffer
+    adapter = Quicsilver::Server::RawAdapter.new(->(*) {})
+    data = adapter.encode_response([200, ["content-type", "application/json"], %({"ok":true})])
+
+    response = Quicsilver::Protocol::ResponseParser.new(data).tap(&:parse)
+    assert_equal 200, response.status
+    assert_equal "application/json", response.headers["content-type"]
+    assert_equal %({"ok":true}), response.body.read
+  end
+
+  def test_head_request_and_empty_body_send_headers_only
+    adapter = Quicsilver::Server::RawAdapter.new(->(*) {})
+    headers = ["x-ok", "1"].freeze
+
+    head = adapter.encode_response([200, headers, "ignored"], head_request: true)
+    empty = adapter.encode_response([200, headers, ""])
+
+    assert_equal head, empty
+    assert_equal "", Quicsilver::Protocol::ResponseParser.new(head).tap(&:parse).body.read
+  end
+
+  def test_headers_frame_is_cached_per_status
+    adapter = Quicsilver::Server::RawAdapter.new(->(*) {})
+    headers = ["content-type", "text/plain"].freeze
+
+    assert_same adapter.encode_response([200, headers, nil]), adapter.encode_response([200, headers, nil])
+    refute_equal adapter.encode_response([200, headers, nil]), adapter.encode_response([404, headers, nil])
+  end
+
+  def test_utf8_body
+    adapter = Quicsilver::Server::RawAdapter.new(->(*) {})
+    data = adapter.encode_response([200, [], "héllo"])
+
+    assert_equal "héllo".b, Quicsilver::Protocol::ResponseParser.new(data).tap(&:parse).body.read.b
+  end
+
+  def test_server_raw_mode
+    app = ->(stream, headers, body) { [200, ["content-type", "text/plain"], "#{stream.method} #{stream.path}"] }
+    config = Quicsilver::Transport::Configuration.new(cert_file_path, key_file_path, mode: :raw)
+    server = Quicsilver::Server.new(4433, server_configuration: config, app: app)
+    connection = Quicsilver::Transport::Connection.new(12345, [12345, 67890])
+    server.connections[12345] = connection
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(handle, data, fin, *) { sent << [data, fin] }) do
+      server.send(:dispatch_streaming, connection, connection.handle, 0,
+        Quicsilver::Protocol::RequestEncoder.new(method: "GET", path: "/health", encoder: qpack_encoder).encode, stream_handle: 0xBEEF)
+      pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+      pending.complete(nil)
+      server.send(:handle_streaming_request, pending)
+    end
+
+    assert_equal 1, sent.size
+    data, fin = sent.first
+    assert fin
+    response = Quicsilver::Protocol::ResponseParser.new(data).tap(&:parse)
+    assert_equal 200, response.status
+    assert_equal "GET /health", response.body.read
+  end
+end
@@ -0,0 +1,112 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class RequestDeadlinesTest < Minitest::Test
+  def test_no_budget_means_no_deadline
+    deadlines = Quicsilver::Server::RequestDeadlines.new(header: "x-request-timeout-ms")
+    assert_nil deadlines.deadline_for(10.0, {})
+  end
+
+  def test_server_default
+    deadlines = Quicsilver::Server::RequestDeadlines.new(default_ms: 500)
+    assert_in_delta 10.5, deadlines.deadline_for(10.0, { "x-request-timeout-ms" => "100" })
+  end
+
+  def test_client_header_can_only_shorten_the_budget
+    deadlines = Quicsilver::Server::RequestDeadlines.new(default_ms: 500, header: "x-request-timeout-ms")
+    assert_in_delta 10.1, deadlines.deadline_for(10.0, { "x-request-timeout-ms" => "100" })
+    assert_in_delta 10.5, deadlines.deadline_for(10.0, { "x-request-timeout-ms" => "60000" })
+
+    deadlines = Quicsilver::Server::RequestDeadlines.new(header: "x-request-timeout-ms")
+    assert_in_delta 10.25, deadlines.deadline_for(10.0, { "x-request-timeout-ms" => "250" })
+  end
+
+  def test_malformed_header_is_ignored
+    deadlines = Quicsilver::Server::RequestDeadlines.new(header: "x-request-timeout-ms")
+    assert_nil deadlines.deadline_for(10.0, { "x-request-timeout-ms" => "soon" })
+    assert_nil deadlines.deadline_for(10.0, { "x-request-timeout-ms" => "-5" })
+    assert_nil deadlines.deadline_for(10.0, { "x-request-timeout-ms" => "0x10" })
+  end
+
+  def test_queue_time_stats
+    deadlines = Quicsilver::Server::RequestDeadlines.new
+    deadlines.dequeued(1.0, 1.010)
+    deadlines.dequeued(1.0, 1.030)
+    deadlines.expired!
+
+    assert_equal({ "dequeued" => 2, "expired" => 1, "avg_ms" => 20.0, "max_ms" => 30.0 }, deadlines.to_h)
+  end
+
+  # --- Server integration ---
+
+  def test_expired_queued_request_is_shed_with_503
+    app_called = false
+    server, connection = build_server(->(env) { app_called = true; [200, {}, ["ok"]] }, request_deadline_ms: 100)
+    stream = get_stream(connection)
+    server.send(:dispatch_request, connection, stream)
+    stream.arrived_at -= 1 # sat in the queue for a second
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(handle, data, fin, *) { sent << data }) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+
+    refute app_called
+    assert_equal "503", Quicsilver::Protocol::ResponseParser.new(sent.join).tap(&:parse).status.to_s
+    assert_equal 1, server.stats.dig("scheduler", "queue_time", "expired")
+  end
+
+  def test_expired_streaming_request_is_shed_with_503
+    app_called = false
+    server, connection = build_server(->(env) { app_called = true; [200, {}, ["ok"]] }, request_deadline_ms: 100)
+    server.send(:dispatch_streaming, connection, connection.handle, 0, get_headers, stream_handle: 0xBEEF)
+    pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+    pending.arrived_at -= 1
+    pending.deadline -= 1
+
+    sent = []
+    Quicsilver.stub(:send_stream, ->(handle, data, fin, *) { sent << data }) do
+      Quicsilver.stub(:stream_stop_sending, ->(*) {}) do
+        server.send(:handle_streaming_request, pending)
+      end
+    end
+
+    refute app_called
+    assert_equal "503", Quicsilver::Protocol::ResponseParser.new(sent.join).tap(&:parse).status.to_s
+  end
+
+  def test_app_sees_deadline_and_queue_time
+    seen = nil
+    server, connection = build_server(->(env) {
+      seen = [env["quicsilver.deadline"], env["quicsilver.queue_time"], env["quicsilver.context"].time_remaining]
+      [200, {}, ["ok"]]
+    })
+    stream = get_stream(connection, headers: { "x-request-timeout-ms" => "5000" })
+    server.send(:dispatch_request, connection, stream)
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+
+    deadline, queue_time, remaining = seen
+    assert_in_delta stream.arrived_at + 5, deadline, 0.001
+    assert_operator queue_time, :>=, 0
+    assert_operator remaining, :>, 4
+    assert_equal 1, server.stats.dig("scheduler", "queue_time", "dequeued")
+  end
+
+  private
+
+  def get_headers(headers = {})
+    Quicsilver::Protocol::RequestEncoder.new(method: "GET", path: "/report", headers: headers, encoder: qpack_encoder).encode
+  end
+
+  def get_stream(connection, headers: {})
+    stream = Quicsilver::Transport::InboundStream.new(0)
+    stream.stream_handle = 0xBEEF
+    stream.append_data(get_headers(headers))
+    connection.add_stream(stream)
+    stream
+  end
+end
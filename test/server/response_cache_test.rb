@@ -0,0 +1,197 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class ResponseCacheTest < Minitest::Test
+  Cache = Quicsilver::Server::ResponseCache
+
+  def test_policy_prefers_s_maxage
+    assert_equal [60, 0], Cache.policy(200, { "cache-control" => "public, max-age=10, s-maxage=60" })
+    assert_equal [10, 30], Cache.policy(200, [["cache-control", "max-age=10"], ["cache-control", "stale-while-revalidate=30"]])
+  end
+
+  def test_policy_rejects_uncacheable_responses
+    assert_nil Cache.policy(200, { "content-type" => "text/plain" })
+    assert_nil Cache.policy(200, { "cache-control" => "private, max-age=60" })
+    assert_nil Cache.policy(200, { "cache-control" => "no-store" })
+    assert_nil Cache.policy(200, { "cache-control" => "max-age=0" })
+    assert_nil Cache.policy(200, { "cache-control" => "max-age=60", "set-cookie" => "a=1" })
+    assert_nil Cache.policy(200, { "cache-control" => "max-age=60", "vary" => "accept" })
+    assert_nil Cache.policy(500, { "cache-control" => "max-age=60" })
+  end
+
+  def test_key_only_for_plain_get_and_head
+    cache = Cache.new(max_size: 1024)
+    get = { ":method" => "GET", ":authority" => "example.com", ":path" => "/flags" }
+
+    assert_equal "example.com/flags", cache.key(get)
+    assert_equal "example.com/flags", cache.key(get.merge(":method" => "HEAD"))
+    assert_nil cache.key(get.merge(":method" => "POST"))
+    assert_nil cache.key(get.merge("authorization" => "Bearer x"))
+    assert_nil cache.key(get.merge("cache-control" => "no-cache"))
+  end
+
+  def test_fresh_stale_and_expired
+    cache = Cache.new(max_size: 1024)
+    cache.store("k", "HEADERSbody", 7, [10, 5], 100.0)
+
+    assert cache.lookup("k", 105.0).fresh?(105.0)
+    refute cache.lookup("k", 112.0).fresh?(112.0)
+    assert_nil cache.lookup("k", 116.0)
+    assert_equal 0, cache.to_h["entries"]
+  end
+
+  def test_head_gets_the_headers_part
+    cache = Cache.new(max_size: 1024)
+    entry = cache.store("k", "HEADERSbody", 7, [10, 0])
+
+    assert_equal "HEADERS", entry.response(head: true)
+    assert_equal "HEADERSbody", entry.response
+  end
+
+  def test_least_recently_used_entry_is_evicted
+    cache = Cache.new(max_size: 25, max_entry_size: 25)
+    cache.store("a", "x" * 9, 1, [60, 0])
+    cache.store("b", "x" * 9, 1, [60, 0])
+    cache.lookup("a")
+    cache.store("c", "x" * 9, 1, [60, 0])
+
+    assert cache.lookup("a")
+    assert_nil cache.lookup("b")
+    assert cache.lookup("c")
+    assert_nil cache.store("d", "x" * 30, 1, [60, 0])
+  end
+
+  def test_concurrent_misses_wait_for_one_fill
+    cache = Cache.new(max_size: 1024)
+    served = []
+
+    fill = cache.begin_fill("k")
+    assert_nil cache.begin_fill("k") { |entry| served << entry.response }
+    assert_nil cache.begin_fill("k") { |entry| served << entry.response }
+    fill.complete("response", 4, [60, 0])
+
+    assert_equal %w[response response], served
+    assert_equal 2, cache.to_h["collapsed"]
+    assert_equal 0, cache.to_h["filling"]
+  end
+
+  def test_uncacheable_fill_releases_waiters_and_passes_the_key
+    cache = Cache.new(max_size: 1024)
+    released = []
+
+    fill = cache.begin_fill("k")
+    cache.begin_fill("k") { |entry| released << entry }
+    fill.release
+    fill.release
+
+    assert_equal [nil], released
+    assert cache.pass?("k")
+    refute cache.pass?("k", Quicsilver::Server::RequestDeadlines.now + Cache::PASS_SECONDS)
+  end
+
+  def test_server_serves_hits_without_the_scheduler
+    calls = 0
+    server, connection = build_server(->(_env) { calls += 1; [200, { "cache-control" => "s-maxage=60" }, ["flags"]] },
+      mode: :rack_direct, response_cache_size: 1024 * 1024)
+
+    sent = Hash.new { |hash, key| hash[key] = +"" }
+    Quicsilver.stub(:send_stream, ->(handle, data, *) { sent[handle] << data }) do
+      Quicsilver.stub(:stream_stop_sending, ->(*) {}) do
+        dispatch(server, connection, 0, 0xA)
+        dispatch(server, connection, 4, 0xB)
+        assert_equal 1, server.instance_variable_get(:@scheduler).pending
+
+        pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+        pending.complete(nil)
+        server.send(:handle_streaming_request, pending)
+
+        dispatch(server, connection, 8, 0xC)
+      end
+    end
+
+    assert_equal 1, calls
+    [0xA, 0xB, 0xC].each do |handle|
+      response = Quicsilver::Protocol::ResponseParser.new(sent[handle]).tap(&:parse)
+      assert_equal 200, response.status
+      assert_equal "flags", response.body.read
+    end
+    stats = server.stats["response_cache"]
+    assert_equal 1, stats["hits"]
+    assert_equal 1, stats["collapsed"]
+  end
+
+  def test_server_runs_the_app_for_uncacheable_responses
+    server, connection = build_server(->(_env) { [200, { "content-type" => "text/plain" }, ["hi"]] },
+      mode: :rack_direct, response_cache_size: 1024 * 1024)
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      dispatch(server, connection, 0, 0xA)
+      dispatch(server, connection, 4, 0xB)
+      pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+      pending.complete(nil)
+      server.send(:handle_streaming_request, pending)
+    end
+
+    # The parked request went to the queue after all
+    assert_equal 2, server.instance_variable_get(:@scheduler).pending
+    assert server.instance_variable_get(:@response_cache).pass?("localhost:4433/flags")
+  end
+
+  def test_cancelled_waiter_is_not_answered_by_the_fill
+    server, connection = build_server(->(_env) { [200, { "cache-control" => "s-maxage=60" }, ["flags"]] },
+      mode: :rack_direct, response_cache_size: 1024 * 1024)
+
+    sent = Hash.new { |hash, key| hash[key] = +"" }
+    Quicsilver.stub(:send_stream, ->(handle, data, *) { sent[handle] << data }) do
+      Quicsilver.stub(:stream_stop_sending, ->(*) {}) do
+        dispatch(server, connection, 0, 0xA)
+        dispatch(server, connection, 4, 0xB)
+        server.send(:cancel_stream, connection, 4)
+
+        pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+        pending.complete(nil)
+        server.send(:handle_streaming_request, pending)
+      end
+    end
+
+    assert_equal [0xA], sent.keys
+    refute server.instance_variable_get(:@cancellations).key?([12345, 4])
+  end
+
+  def test_revalidation_leaves_the_live_requests_state_alone
+    server, connection = build_server(->(_env) { [200, { "cache-control" => "s-maxage=60" }, ["new"]] },
+      mode: :rack_direct, response_cache_size: 1024 * 1024)
+    cache = server.instance_variable_get(:@response_cache)
+    bytes, headers_size = connection.encode_response(200, { "cache-control" => "s-maxage=1" }, ["old"])
+    cache.store("localhost:4433/flags", bytes, headers_size, [1, 60], Quicsilver::Server::RequestDeadlines.now - 2)
+
+    queued = []
+    server.instance_variable_get(:@scheduler).stub(:enqueue, ->(work) { queued << work }) do
+      Quicsilver.stub(:send_stream, ->(*) {}) do
+        Quicsilver.stub(:stream_stop_sending, ->(*) {}) do
+          dispatch(server, connection, 0, 0xA)
+        end
+      end
+    end
+
+    # Stream 0 is reused by a request still in flight
+    registry = server.instance_variable_get(:@request_registry)
+    registry.track(0, 12345, path: "/flags", method: "GET")
+    server.instance_variable_get(:@cancellations)[[12345, 0]] = Quicsilver::Server::Cancellation.new
+
+    connection, stream, early_data = queued.first
+    server.instance_variable_get(:@request_handler).call(connection, stream, early_data: early_data)
+
+    assert cache.lookup("localhost:4433/flags").fresh?
+    assert registry.include?(0, 12345)
+    assert server.instance_variable_get(:@cancellations).key?([12345, 0])
+  end
+
+  private
+
+  def dispatch(server, connection, stream_id, stream_handle)
+    data = Quicsilver::Protocol::RequestEncoder.new(method: "GET", path: "/flags", authority: "localhost:4433", encoder: qpack_encoder).encode
+    server.send(:dispatch_streaming, connection, connection.handle, stream_id, data, stream_handle: stream_handle)
+  end
+end
@@ -0,0 +1,102 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+
+class ServerPushTest < Minitest::Test
+  PAGE_APP = ->(env) {
+    if env["PATH_INFO"] == "/"
+      push = env["quicsilver.push"]
+      push&.push("/app.css")
+      push&.push("/app.css")
+      push&.push("/app.js")
+      [200, { "content-type" => "text/html" }, ["<link rel=stylesheet href=/app.css>"]]
+    else
+      [200, { "content-type" => "text/css" }, ["body{}"]]
+    end
+  }
+
+  def test_no_pusher_until_client_sends_max_push_id
+    seen = []
+    server, connection = build_server(->(env) { seen << env.key?("quicsilver.push"); [200, {}, ["ok"]] },
+      mode: :rack_direct, max_pushes_per_request: 4)
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      dispatch(server, connection, 0, 0xA, "/")
+      run_pending(server, 0)
+    end
+
+    assert_equal [false], seen
+  end
+
+  def test_pushes_promise_and_response_on_push_stream
+    server, connection = build_server(PAGE_APP, mode: :rack_direct, max_pushes_per_request: 1)
+    connection.receive_unidirectional_data(2, "\x00".b + Quicsilver::Protocol.build_settings_frame({}) +
+      Quicsilver::Protocol.build_max_push_id_frame(10))
+
+    sent = Hash.new { |hash, key| hash[key] = +"".b }
+    Quicsilver.stub(:send_stream, ->(handle, data, *) { sent[handle] << data }) do
+      Quicsilver.stub(:open_stream, ->(*) { 0xB0 }) do
+        Quicsilver.stub(:get_stream_id, ->(*) { 15 }) do
+          dispatch(server, connection, 0, 0xA, "/")
+          run_pending(server, 0)
+        end
+      end
+
+      # The pushed GET is queued like any request, after the page's own
+      push_stream = connection.instance_variable_get(:@pushes)[0]
+      assert_equal 2, server.instance_variable_get(:@scheduler).pending
+      server.instance_variable_get(:@request_handler).call(connection, push_stream)
+    end
+
+    # Request stream: PUSH_PROMISE for /app.css (max_pushes: 1), then the page
+    type, _ = Quicsilver::Protocol.decode_varint_str(sent[0xA], 0)
+    assert_equal Quicsilver::Protocol::FRAME_PUSH_PROMISE, type
+    assert_includes sent[0xA], "/app.css"
+    refute_includes sent[0xA], "/app.js"
+
+    # Push stream: type, push ID, then the pushed response
+    push_data = sent[0xB0]
+    assert_equal "\x01\x00".b, push_data.byteslice(0, 2)
+    response = Quicsilver::Protocol::ResponseParser.new(push_data.byteslice(2..)).tap(&:parse)
+    assert_equal 200, response.status
+    assert_equal "body{}", response.body.read
+  end
+
+  def test_pusher_cancels_its_own_push
+    server, connection = build_server(PAGE_APP, mode: :rack_direct, max_pushes_per_request: 4)
+    connection.receive_unidirectional_data(2, "\x00".b + Quicsilver::Protocol.build_settings_frame({}) +
+      Quicsilver::Protocol.build_max_push_id_frame(10))
+    request_stream = Quicsilver::Transport::InboundStream.new(0)
+    request_stream.stream_handle = 0xA
+    pusher = server.instance_variable_get(:@server_push).pusher(connection, request_stream, { ":authority" => "localhost" })
+
+    resets = []
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      Quicsilver.stub(:open_stream, ->(*) { 0xB0 }) do
+        Quicsilver.stub(:get_stream_id, ->(*) { 15 }) do
+          Quicsilver.stub(:stream_reset, ->(handle, _code) { resets << handle }) do
+            push_id = pusher.push("/app.css")
+            refute pusher.cancel(push_id + 1)
+            assert pusher.cancel(push_id)
+          end
+        end
+      end
+    end
+
+    assert_equal [0xB0], resets
+    assert_equal 0, connection.active_pushes
+  end
+
+  private
+
+  def dispatch(server, connection, stream_id, stream_handle, path)
+    data = Quicsilver::Protocol::RequestEncoder.new(method: "GET", path: path, authority: "localhost:4433", encoder: qpack_encoder).encode
+    server.send(:dispatch_streaming, connection, connection.handle, stream_id, data, stream_handle: stream_handle)
+  end
+
+  def run_pending(server, stream_id)
+    pending = server.instance_variable_get(:@pending_streams)[[12345, stream_id]]
+    pending.complete(nil)
+    server.send(:handle_streaming_request, pending)
+  end
+end
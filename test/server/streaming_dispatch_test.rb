@@ -25,6 +25,217 @@ class StreamingDispatchTest < Minitest::Test
     assert_nil result
   end
 
+  def test_pending_stream_with_receive_handle_does_not_wait
+    pending = Quicsilver::Server::PendingStream.new(
+      connection: nil, body: nil, request: nil, stream_id: 0, stream_handle: 7
+    )
+
+    assert_equal 7, pending.wait_for_handle(timeout: 0)
+  end
+
+  def test_pending_stream_complete_without_handle_keeps_receive_handle
+    pending = Quicsilver::Server::PendingStream.new(
+      connection: nil, body: nil, request: nil, stream_id: 0, stream_handle: 7
+    )
+    pending.complete(nil)
+
+    assert_equal 7, pending.stream_handle
+    assert pending.fin_received
+  end
+
+  # --- Full duplex ---
+
+  def test_response_sent_before_request_fin
+    server, connection = build_server(->(env) { [200, {}, ["early"]] })
+    server.send(:dispatch_streaming, connection, connection.handle, 0,
+      post_headers, stream_handle: 0xBEEF)
+    pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+
+    sent = []
+    stopped = []
+    Quicsilver.stub(:send_stream, ->(handle, data, fin) { sent << [handle, fin] }) do
+      Quicsilver.stub(:stream_stop_sending, ->(handle, code) { stopped << [handle, code] }) do
+        server.send(:handle_streaming_request, pending)
+      end
+    end
+
+    assert_equal 0xBEEF, sent.first[0]
+    assert sent.last[1], "response should finish with FIN"
+    refute pending.fin_received
+    assert_equal [[0xBEEF, Quicsilver::Protocol::H3_NO_ERROR]], stopped
+  end
+
+  def test_body_after_early_response_is_discarded
+    server, connection = build_server(->(env) { [200, {}, ["early"]] })
+    server.send(:dispatch_streaming, connection, connection.handle, 0,
+      post_headers, stream_handle: 0xBEEF)
+    pending_streams = server.instance_variable_get(:@pending_streams)
+    pending = pending_streams[[12345, 0]]
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      Quicsilver.stub(:stream_stop_sending, ->(*) {}) do
+        server.send(:handle_streaming_request, pending)
+      end
+    end
+    assert pending.discarding
+    assert_same pending, pending_streams[[12345, 0]], "late RECEIVEs must not look like a new request"
+
+    data_frame = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "late")
+    server.send(:handle_bidi_receive, connection, connection.handle, 0, 0xBEEF, data_frame)
+    assert_empty pending.frame_buffer
+
+    server.send(:handle_receive_fin, connection, connection.handle, 0, [0xBEEF].pack("Q<") + data_frame)
+    assert_nil pending_streams[[12345, 0]]
+  end
+
+  def test_discarding_stream_does_not_swallow_another_connections_request
+    received = nil
+    server, connection = build_server(->(env) { received = env["rack.input"].read; [200, {}, ["ok"]] })
+    other = Quicsilver::Transport::Connection.new(54321, [54321, 9876])
+    server.connections[54321] = other
+    pending_streams = server.instance_variable_get(:@pending_streams)
+
+    # Connection 12345 responds early on stream 0 and keeps discarding it
+    server.send(:dispatch_streaming, connection, connection.handle, 0, post_headers, stream_handle: 0xBEEF)
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      Quicsilver.stub(:stream_stop_sending, ->(*) {}) do
+        server.send(:handle_streaming_request, pending_streams[[12345, 0]])
+      end
+    end
+    assert pending_streams[[12345, 0]].discarding
+
+    # Connection 54321 uploads a body on its own stream 0
+    server.send(:dispatch_streaming, other, other.handle, 0, post_headers, stream_handle: 0xCAFE)
+    other_pending = pending_streams[[54321, 0]]
+    refute_same pending_streams[[12345, 0]], other_pending
+
+    data_frame = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "hello")
+    server.send(:handle_bidi_receive, other, other.handle, 0, 0xCAFE, data_frame)
+    server.send(:handle_receive_fin, other, other.handle, 0, [0xCAFE].pack("Q<"))
+    assert other_pending.fin_received
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      server.send(:handle_streaming_request, other_pending)
+    end
+    assert_equal "hello", received
+    assert pending_streams[[12345, 0]].discarding, "the first connection's entry is left alone"
+  end
+
+  def test_fully_received_request_is_untracked_after_response
+    server, connection = build_server(->(env) { [200, {}, [env["rack.input"].read]] })
+    server.send(:dispatch_streaming, connection, connection.handle, 0,
+      post_headers + Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "hello"),
+      stream_handle: 0xBEEF)
+    pending_streams = server.instance_variable_get(:@pending_streams)
+    pending = pending_streams[[12345, 0]]
+    server.send(:handle_receive_fin, connection, connection.handle, 0, [0xBEEF].pack("Q<"))
+
+    stopped = false
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      Quicsilver.stub(:stream_stop_sending, ->(*) { stopped = true }) do
+        server.send(:handle_streaming_request, pending)
+      end
+    end
+
+    refute stopped
+    assert_nil pending_streams[[12345, 0]]
+  end
+
+  def test_full_queue_answers_streaming_request_with_503
+    server, connection = build_server(->(env) { [200, {}, ["ok"]] })
+    sent = []
+    stopped = []
+    server.instance_variable_get(:@scheduler).stub(:admit?, false) do
+      Quicsilver.stub(:send_stream, ->(handle, data, fin) { sent << [handle, data, fin] }) do
+        Quicsilver.stub(:stream_stop_sending, ->(handle, code) { stopped << handle }) do
+          server.send(:dispatch_streaming, connection, connection.handle, 0, post_headers, stream_handle: 0xBEEF)
+        end
+      end
+    end
+
+    response = Quicsilver::Protocol::ResponseParser.new(sent.map { |_, data, _| data }.join).tap(&:parse)
+    assert_equal 503, response.status
+    assert sent.last[2], "the 503 should finish the stream"
+    assert_equal [0xBEEF], stopped, "the unread request body should be refused"
+    assert server.instance_variable_get(:@request_registry).empty?
+    assert server.instance_variable_get(:@pending_streams)[[12345, 0]].discarding
+  end
+
+  def test_slow_reader_pauses_and_resumes_receive
+    server, connection = build_server(->(env) { [200, {}, ["ok"]] }, request_body_buffer_size: 8)
+    toggles = []
+    Quicsilver.stub(:stream_receive_set_enabled, ->(handle, enabled) { toggles << [handle, enabled] }) do
+      server.send(:dispatch_streaming, connection, connection.handle, 0, post_headers, stream_handle: 0xBEEF)
+      pending = server.instance_variable_get(:@pending_streams)[[12345, 0]]
+
+      data = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "12345")
+      server.send(:handle_bidi_receive, connection, connection.handle, 0, 0xBEEF, data)
+      server.send(:handle_bidi_receive, connection, connection.handle, 0, 0xBEEF, data)
+      assert_equal [[0xBEEF, false]], toggles
+
+      pending.body.read
+      pending.body.read
+      assert_equal [[0xBEEF, false], [0xBEEF, true]], toggles
+    end
+  end
+
+  # --- Memory budget ---
+
+  def test_full_queue_releases_buffered_frames
+    server, connection = build_server(->(env) { [200, {}, ["ok"]] })
+    partial = Quicsilver::Protocol.build_frame(Quicsilver::Protocol::FRAME_DATA, "hello").byteslice(0, 4)
+    server.instance_variable_get(:@scheduler).stub(:admit?, false) do
+      Quicsilver.stub(:send_stream, ->(*) {}) do
+        Quicsilver.stub(:stream_stop_sending, ->(*) {}) do
+          server.send(:dispatch_streaming, connection, connection.handle, 0, post_headers + partial, stream_handle: 0xBEEF)
+        end
+      end
+    end
+
+    assert_equal 0, connection.memory.buffered
+  end
+
+  def test_send_complete_enforces_the_budget_on_unacknowledged_bytes
+    server, = build_server(->(env) { [200, {}, ["ok"]] }, connection_memory_budget: 100)
+    account = server.instance_variable_get(:@memory_budget).account(12345)
+    server.connections[12345] = Quicsilver::Transport::Connection.new(12345, [12345, 67890], memory: account)
+
+    closed = []
+    Quicsilver.stub(:connection_send_inflight, ->(_) { 500 }) do
+      Quicsilver.stub(:connection_shutdown, ->(handle, code, _) { closed << [handle, code] }) do
+        server.handle_stream_event([12345, 67890], 0, "SEND_COMPLETE", [0xBEEF].pack("Q<"), false)
+      end
+    end
+
+    assert_equal [[12345, Quicsilver::Protocol::H3_EXCESSIVE_LOAD]], closed
+  end
+
+  # --- Spooled buffered requests ---
+
+  def test_large_buffered_request_is_read_from_spool
+    received = nil
+    server, = build_server(->(env) { received = env["rack.input"].read; [200, {}, ["ok"]] },
+      request_body_spool_threshold: 64)
+    connection = Quicsilver::Transport::Connection.new(12345, [12345, 67890], spool_threshold: 64)
+    server.connections[12345] = connection
+
+    # A leading unknown frame keeps the request off the streaming path
+    grease = Quicsilver::Protocol.build_frame(0x21, "")
+    request = grease + Quicsilver::Protocol::RequestEncoder.new(method: "POST", path: "/upload", body: "b" * 500, encoder: qpack_encoder).encode
+    server.send(:handle_bidi_receive, connection, 12345, 0, 0xBEEF, request.byteslice(0, 200))
+
+    stream = nil
+    server.stub(:dispatch_request, ->(_conn, s, **) { stream = s }) do
+      server.send(:handle_receive_fin, connection, 12345, 0, [0xBEEF].pack("Q<") + request.byteslice(200..))
+    end
+    assert_instance_of Quicsilver::Protocol::RequestSpool, stream.body_spool
+
+    Quicsilver.stub(:send_stream, ->(*) {}) do
+      server.instance_variable_get(:@request_handler).call(connection, stream)
+    end
+    assert_equal "b" * 500, received
+  end
+
   # --- contains_headers_frame? ---
 
   # --- StreamInput content-length validation ---
@@ -121,11 +332,16 @@ class StreamingDispatchTest < Minitest::Test
 
   private
 
+  def post_headers
+    Quicsilver::Protocol::RequestEncoder.new(method: "POST", path: "/upload", encoder: qpack_encoder).encode
+  end
+
   def build_post_request(body_str)
     encoder = Quicsilver::Protocol::RequestEncoder.new(
       method: "POST", path: "/test",
       headers: { "content-length" => body_str.bytesize.to_s },
-      body: body_str
+      body: body_str,
+      encoder: qpack_encoder
     )
     encoder.encode
   end
@@ -0,0 +1,154 @@
+# frozen_string_literal: true
+
+require_relative "../test_helper"
+require "timeout"
+
+class ThreadSchedulerTest < Minitest::Test
+  def teardown
+    @scheduler&.stop
+  end
+
+  def test_fixed_pool_starts_all_workers
+    done = Queue.new
+    @scheduler = build_scheduler(concurrency: 3) { |work| done << work }
+    @scheduler.start
+
+    refute @scheduler.autoscaling?
+    assert_equal 3, @scheduler.workers
+    @scheduler.enqueue(:a)
+    assert_equal :a, Timeout.timeout(2) { done.pop }
+  end
+
+  def test_grows_when_work_waits
+    release = Queue.new
+    started = Queue.new
+    @scheduler = build_scheduler(concurrency: 4, min_concurrency: 1) do |work|
+      started << work
+      release.pop
+    end
+    @scheduler.start
+    assert_equal 1, @scheduler.workers
+
+    4.times { |i| @scheduler.enqueue(i) }
+    Timeout.timeout(2) { 4.times { started.pop } }
+
+    assert_equal 4, @scheduler.workers
+    4.times { release << true }
+  end
+
+  def test_never_grows_past_concurrency
+    release = Queue.new
+    @scheduler = build_scheduler(concurrency: 2, min_concurrency: 1) { |_work| release.pop }
+    @scheduler.start
+
+    6.times { |i| @scheduler.enqueue(i) }
+    sleep 0.1
+
+    assert_equal 2, @scheduler.workers
+    assert_equal 4, @scheduler.pending
+    6.times { release << true }
+  end
+
+  def test_reaps_idle_workers_down_to_minimum
+    release = Queue.new
+    started = Queue.new
+    @scheduler = build_scheduler(concurrency: 3, min_concurrency: 1, idle_timeout: 0.05) do |work|
+      started << work
+      release.pop
+    end
+    @scheduler.start
+    3.times { |i| @scheduler.enqueue(i) }
+    Timeout.timeout(2) { 3.times { started.pop } }
+    3.times { release << true }
+
+    Timeout.timeout(2) { sleep 0.01 until @scheduler.workers == 1 }
+    assert_equal 1, @scheduler.workers
+  end
+
+  def test_stop_finishes_queued_work
+    done = Queue.new
+    @scheduler = build_scheduler(concurrency: 1) { |work| sleep 0.01; done << work }
+    @scheduler.start
+    3.times { |i| @scheduler.enqueue(i) }
+    @scheduler.stop
+
+    assert_equal 3, done.size
+    assert_equal 0, @scheduler.workers
+  end
+
+  def test_without_fair_key_work_is_fifo
+    order = run_in_order(%w[a1 a2 b1 a3])
+    assert_equal %w[a1 a2 b1 a3], order
+  end
+
+  def test_fair_key_round_robins_between_keys
+    order = run_in_order(%w[a1 a2 a3 a4 b1 b2 c1], fair_key: ->(work) { work[0] })
+    assert_equal %w[a1 b1 c1 a2 b2 a3 a4], order
+  end
+
+  def test_weight_gives_a_key_more_turns
+    order = run_in_order(%w[a1 a2 a3 a4 b1 b2 b3],
+      fair_key: ->(work) { work[0] }, weight: ->(key) { key == "a" ? 2 : 1 })
+    assert_equal %w[a1 a2 b1 a3 a4 b2 b3], order
+  end
+
+  def test_pending_and_queues_count_all_keys
+    @scheduler = build_scheduler(concurrency: 1, fair_key: ->(work) { work[0] }) {}
+    %w[a1 a2 b1].each { |work| @scheduler.enqueue(work) }
+
+    assert_equal 3, @scheduler.pending
+    assert_equal 2, @scheduler.queues
+  end
+
+  def test_one_key_cannot_fill_the_queue_for_others
+    @scheduler = build_scheduler(concurrency: 1, max_queue_size: 4, fair_key: ->(work) { work[0] }) {}
+    4.times { |i| @scheduler.enqueue("a#{i}") }
+    assert @scheduler.full?
+
+    refute @scheduler.admit?("a4")
+    assert @scheduler.admit?("b0"), "a key with nothing queued still gets a place"
+    @scheduler.enqueue("b0")
+    refute @scheduler.admit?("b1")
+  end
+
+  def test_keys_are_held_to_an_even_share
+    @scheduler = build_scheduler(concurrency: 1, max_queue_size: 4, fair_key: ->(work) { work[0] }) {}
+    %w[a0 b0].each { |work| @scheduler.enqueue(work) }
+    @scheduler.enqueue("a1")
+
+    refute @scheduler.admit?("a2")
+    assert @scheduler.admit?("b1")
+  end
+
+  def test_weight_is_not_called_under_the_lock
+    weight = ->(_key) { @scheduler.admit?("x") && 1 }
+    @scheduler = build_scheduler(concurrency: 1, fair_key: ->(work) { work[0] }, weight: weight) {}
+
+    Timeout.timeout(2) { @scheduler.enqueue("a0") }
+    assert_equal 1, @scheduler.pending
+  end
+
+  def test_min_concurrency_is_clamped
+    @scheduler = build_scheduler(concurrency: 2, min_concurrency: 5) {}
+    assert_equal 2, @scheduler.min_concurrency
+    refute @scheduler.autoscaling?
+  end
+
+  private
+
+  # Queue everything first, then let a single worker take it.
+  def run_in_order(items, **options)
+    order = []
+    @scheduler = build_scheduler(concurrency: 1, **options) { |work| order << work }
+    items.each { |work| @scheduler.enqueue(work) }
+    @scheduler.start
+    @scheduler.stop
+    order
+  end
+
+  def build_scheduler(concurrency:, max_queue_size: 100, **options, &handler)
+    Quicsilver::Server::Schedulers::ThreadScheduler.new(
+      concurrency: concurrency, max_queue_size: max_queue_size, scale_up_wait: 0.005, **options, &handler
+    )
+  end
+end
@@ -278,7 +278,8 @@ class WebTransportManagerTest < Minitest::Test
       headers: {
         ":method" => "CONNECT", ":protocol" => "webtransport",
         ":scheme" => "https", ":authority" => "localhost", ":path" => "/wt"
-      }
+      },
+      encoder: qpack_encoder
     )
   end
 end
@@ -404,7 +404,7 @@ class WebTransportSessionTest < Minitest::Test
     stream.expect(:stream_handle, 99999)
 
     Quicsilver::Server::WebTransportSession.new(
-      connection: connection, stream: stream, headers: headers
+      connection: connection, stream: stream, headers: headers, encoder: qpack_encoder
     )
   end
 
@@ -238,6 +238,16 @@ class ServerConfigurationTest < Minitest::Test
     assert_equal :falcon, config.mode
   end
 
+  def test_mode_rack_direct
+    config = fetch_server_configuration_with_certs(mode: :rack_direct)
+    assert_equal :rack_direct, config.mode
+  end
+
+  def test_mode_raw
+    config = fetch_server_configuration_with_certs(mode: :raw)
+    assert_equal :raw, config.mode
+  end
+
   def test_mode_invalid_raises
     assert_raises(Quicsilver::ServerConfigurationError) do
       fetch_server_configuration_with_certs(mode: :bogus)
@@ -280,6 +290,183 @@ class ServerConfigurationTest < Minitest::Test
     assert_equal "transport_server_id must be exactly 4 bytes encoded as an 8-character hex string", error.message
   end
 
+  def test_admission_limits_default_to_unlimited_per_ip
+    config = fetch_server_configuration_with_certs
+
+    assert_nil config.max_connections_per_ip
+    assert_equal 32, config.ipv4_prefix_length
+    assert_equal 64, config.ipv6_prefix_length
+    assert_equal false, config.retry_under_load
+  end
+
+  def test_connection_limits_hash
+    config = fetch_server_configuration_with_certs(
+      max_connections_per_ip: 8, ipv4_prefix_length: 24, ipv6_prefix_length: 48, retry_under_load: true,
+      handshake_rate_limit: 500, retry_memory_percent: 20,
+      request_rate_limit: 50, request_rate_limit_per_ip: 200, byte_rate_limit_per_ip: 1_048_576
+    )
+
+    assert_equal({
+      max_connections: 100,
+      max_connections_per_prefix: 8,
+      ipv4_prefix_length: 24,
+      ipv6_prefix_length: 48,
+      retry_under_load: 1,
+      handshake_rate_limit: 500,
+      retry_memory_percent: 20,
+      request_rate_limit: 50,
+      prefix_request_rate_limit: 200,
+      byte_rate_limit: 0,
+      prefix_byte_rate_limit: 1_048_576
+    }, config.connection_limits(100))
+  end
+
+  def test_connection_limits_use_zero_for_unlimited
+    limits = fetch_server_configuration_with_certs.connection_limits(nil)
+
+    assert_equal 0, limits[:max_connections]
+    assert_equal 0, limits[:max_connections_per_prefix]
+    assert_equal 0, limits[:retry_under_load]
+    assert_equal 0, limits[:handshake_rate_limit]
+    assert_nil limits[:retry_memory_percent]
+  end
+
+  def test_flood_defense_options_are_validated
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(retry_memory_percent: 101)
+    end
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(handshake_rate_limit: 0)
+    end
+  end
+
+  def test_rate_limits_are_validated
+    error = assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(request_rate_limit: 0)
+    end
+    assert_equal "request_rate_limit must be a positive integer or nil", error.message
+
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(byte_rate_limit_per_ip: 1.5)
+    end
+  end
+
+  def test_max_connections_per_ip_must_be_positive
+    error = assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(max_connections_per_ip: 0)
+    end
+
+    assert_equal "max_connections_per_ip must be a positive integer or nil", error.message
+  end
+
+  def test_prefix_lengths_are_validated
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(ipv4_prefix_length: 33)
+    end
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(ipv6_prefix_length: 129)
+    end
+  end
+
+  def test_request_body_buffer_size
+    assert_equal 262_144, fetch_server_configuration_with_certs.request_body_buffer_size
+    assert_nil fetch_server_configuration_with_certs(request_body_buffer_size: nil).request_body_buffer_size
+
+    error = assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(request_body_buffer_size: 0)
+    end
+    assert_equal "request_body_buffer_size must be a positive integer or nil", error.message
+  end
+
+  def test_request_body_spool_threshold
+    assert_equal 1_048_576, fetch_server_configuration_with_certs.request_body_spool_threshold
+    assert_nil fetch_server_configuration_with_certs(request_body_spool_threshold: nil).request_body_spool_threshold
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(request_body_spool_threshold: -1)
+    end
+  end
+
+  def test_response_coalescing_options
+    config = fetch_server_configuration_with_certs
+    assert_equal 16_384, config.response_coalesce_size
+    assert_equal 5, config.response_coalesce_delay_ms
+    assert_nil fetch_server_configuration_with_certs(response_coalesce_size: nil).response_coalesce_size
+
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(response_coalesce_size: 0)
+    end
+    error = assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(response_coalesce_delay_ms: -1)
+    end
+    assert_equal "response_coalesce_delay_ms must be a non-negative number", error.message
+  end
+
+  def test_response_cache_size
+    assert_nil fetch_server_configuration_with_certs.response_cache_size
+    assert_equal 1024, fetch_server_configuration_with_certs(response_cache_size: 1024).response_cache_size
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(response_cache_size: 0)
+    end
+  end
+
+  def test_response_compression
+    assert_nil fetch_server_configuration_with_certs.response_compression
+    assert_equal %w[br gzip], fetch_server_configuration_with_certs(response_compression: %w[br gzip]).response_compression
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(response_compression: %w[deflate])
+    end
+  end
+
+  def test_max_pushes_per_request
+    assert_nil fetch_server_configuration_with_certs.max_pushes_per_request
+    assert_equal 4, fetch_server_configuration_with_certs(max_pushes_per_request: 4).max_pushes_per_request
+    assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(max_pushes_per_request: 0)
+    end
+  end
+
+  def test_send_high_water_marks
+    config = fetch_server_configuration_with_certs
+    assert_equal 1_048_576, config.send_high_water_mark
+    assert_equal 16_777_216, config.connection_send_high_water_mark
+    assert_nil fetch_server_configuration_with_certs(send_high_water_mark: nil).send_high_water_mark
+
+    error = assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(connection_send_high_water_mark: 0)
+    end
+    assert_equal "connection_send_high_water_mark must be a positive integer or nil", error.message
+  end
+
+  def test_memory_budgets
+    config = fetch_server_configuration_with_certs
+    assert_nil config.memory_budget
+    assert_nil config.connection_memory_budget
+
+    config = fetch_server_configuration_with_certs(memory_budget: 268_435_456, connection_memory_budget: 8_388_608)
+    assert_equal 268_435_456, config.memory_budget
+    assert_equal 8_388_608, config.connection_memory_budget
+
+    error = assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(connection_memory_budget: -1)
+    end
+    assert_equal "connection_memory_budget must be a positive integer or nil", error.message
+  end
+
+  def test_request_deadline_options
+    config = fetch_server_configuration_with_certs
+    assert_nil config.request_deadline_ms
+    assert_equal "x-request-timeout-ms", config.request_deadline_header
+
+    config = fetch_server_configuration_with_certs(request_deadline_ms: 2_000, request_deadline_header: "X-Budget-Ms")
+    assert_equal 2_000, config.request_deadline_ms
+    assert_equal "x-budget-ms", config.request_deadline_header
+
+    error = assert_raises(Quicsilver::ServerConfigurationError) do
+      fetch_server_configuration_with_certs(request_deadline_ms: 0)
+    end
+    assert_equal "request_deadline_ms must be a positive number or nil", error.message
+  end
+
   private
 
   def fetch_server_configuration_with_certs(options={})
@@ -61,8 +61,10 @@ class ServerStatsTest < Minitest::Test
       refute stats["draining"]
       refute stats["shutting_down"]
       assert_equal({"active" => 0, "max" => 11}, stats["connections"])
-      assert_equal({"active" => 1}, stats["requests"])
+      assert_equal({"active" => 1, "async" => 0}, stats["requests"])
       assert_equal 2, stats.dig("scheduler", "threads")
+      assert_equal 2, stats.dig("scheduler", "min_threads")
+      assert_equal 0, stats.dig("scheduler", "workers")
       assert_equal 0, stats.dig("scheduler", "pending")
       assert_equal 7, stats.dig("scheduler", "max_queue_size")
       refute stats.dig("scheduler", "full")
@@ -70,6 +72,20 @@ class ServerStatsTest < Minitest::Test
     end
   end
 
+  def test_stats_reports_autoscaling_pool_bounds
+    server = build_server(threads: 8, min_threads: 2)
+
+    Quicsilver.stub(:transport_counters, nil) do
+      server.scheduler.start
+      stats = server.stats
+      assert_equal 8, stats.dig("scheduler", "threads")
+      assert_equal 2, stats.dig("scheduler", "min_threads")
+      assert_equal 2, stats.dig("scheduler", "workers")
+    ensure
+      server.scheduler.stop
+    end
+  end
+
   def test_ready_is_false_when_server_is_not_running
     server = build_server
 
@@ -196,7 +196,21 @@ class ServerTest < Minitest::Test
       Quicsilver::Server.handle_stream(connection_data, stream_id, "STOP_SENDING", packed_data, false)
     end
 
-    assert server.cancelled_stream?(stream_id), "Stream should be marked as cancelled after STOP_SENDING"
+    assert server.cancelled_stream?(stream_id, connection_handle), "Stream should be marked as cancelled after STOP_SENDING"
+  end
+
+  def test_stop_sending_cancels_only_that_connections_stream
+    server = create_server(4433, app: ->(env) { [200, {}, ["OK"]] })
+    server.connections[111] = Quicsilver::Transport::Connection.new(111, [111, 1])
+    server.connections[222] = Quicsilver::Transport::Connection.new(222, [222, 2])
+    packed_data = [0xABCD, Quicsilver::Protocol::H3_REQUEST_CANCELLED].pack("QQ")
+
+    Quicsilver.stub(:stream_reset, ->(*args) { true }) do
+      Quicsilver::Server.handle_stream([111, 1], 4, "STOP_SENDING", packed_data, false)
+    end
+
+    assert server.cancelled_stream?(4, 111)
+    refute server.cancelled_stream?(4, 222), "Another connection's stream 4 must still be answered"
   end
 
   # STOP_SENDING compliance: server resets the send side of the stream
@@ -231,6 +245,24 @@ class ServerTest < Minitest::Test
     assert_equal 100, server.max_queue_size
   end
 
+  def test_min_threads_must_fit_the_pool
+    assert_raises(Quicsilver::ServerConfigurationError) { create_server_direct(threads: 4, min_threads: 5) }
+    assert_raises(Quicsilver::ServerConfigurationError) { create_server_direct(threads: 4, min_threads: 0) }
+    assert create_server_direct(threads: 4, min_threads: 1).scheduler.autoscaling?
+    refute create_server_direct(threads: 4).scheduler.autoscaling?
+  end
+
+  def test_requests_are_queued_per_connection
+    server = create_server_direct(threads: 1)
+    first = Quicsilver::Transport::Connection.new(1, [1, 2])
+    second = Quicsilver::Transport::Connection.new(3, [3, 4])
+    3.times { |i| server.scheduler.enqueue([first, Quicsilver::Transport::InboundStream.new(i * 4), false]) }
+    server.scheduler.enqueue([:streaming, Quicsilver::Server::PendingStream.new(connection: second, stream_id: 0)])
+
+    assert_equal 4, server.scheduler.pending
+    assert_equal 2, server.scheduler.queues
+  end
+
   def test_dispatch_sends_503_when_queue_full
     server = create_server_direct(threads: 1, max_queue_size: 1, app: ->(env) { [200, {}, ["OK"]] })
 
@@ -59,4 +59,12 @@ class StreamTest < Minitest::Test
     end
     assert_equal [42, 0x42], called_with
   end
+
+  def test_send_early_data_allows_0rtt
+    called_with = nil
+    Quicsilver.stub(:send_stream, ->(*args) { called_with = args; true }) do
+      @stream.send("early", fin: true, early_data: true)
+    end
+    assert_equal [42, "early", true, true], called_with
+  end
 end
@@ -18,6 +18,24 @@ def key_file_path
   Localhost::Authority.fetch.key_path
 end
 
+# A server that is never started, with one fake connection (handle 12345)
+# for driving its callbacks directly. Options go to the Configuration.
+def build_server(app, **options)
+  config = Quicsilver::Transport::Configuration.new(cert_file_path, key_file_path, options)
+  server = Quicsilver::Server.new(4433, server_configuration: config, app: app)
+  connection = Quicsilver::Transport::Connection.new(12345, [12345, 67890])
+  server.connections[12345] = connection
+  [server, connection]
+end
+
+# QPACK encoder for tests that build request or response frames directly.
+# Encoders are required everywhere so the library never builds throwaway ones.
+TEST_QPACK_ENCODER = Quicsilver::Protocol::Qpack::Encoder.new
+
+def qpack_encoder
+  TEST_QPACK_ENCODER
+end
+
 # Find an available UDP port for a Quicsilver server.
 #
 # Quicsilver servers bind to 0.0.0.0 by default, so probe the same wildcard